@@ -15,7 +15,7 @@ Color::Color(uint32_t r, uint32_t g, uint32_t b, uint32_t a)
     R = r;
     G = g;
     B = b;
-    a = a;
+    A = a;
 }
 
 uint32_t Color::getColor()
@@ -0,0 +1,145 @@
+#include <string.h>
+
+#include "DeltaCompression.h"
+
+#define MAX_LITERAL 128
+#define MIN_RUN 3
+#define MAX_RUN (0x7F + MIN_RUN)
+
+/**
+ * Writes the bytes from start to end as literal blocks.
+ */
+static uint8_t* writeLiterals(const uint8_t* data, const uint8_t* base, 
+                              size_t start, size_t end, uint8_t* out)
+{
+    while (start < end)
+    {
+        size_t count = end - start;
+        if (count > MAX_LITERAL)
+        {
+            count = MAX_LITERAL;
+        }
+        *out++ = (uint8_t)(count - 1);
+        for (size_t i = 0; i < count; i++)
+        {
+            out[i] = base ? data[start + i] ^ base[start + i] : data[start + i];
+        }
+        out += count;
+        start += count;
+    }
+    return out;
+}
+
+size_t getMaxDeltaSize(size_t length)
+{
+    return length + (length + MAX_LITERAL - 1) / MAX_LITERAL;
+}
+
+size_t encodeDelta(const uint8_t* data, const uint8_t* base, size_t length, 
+                   uint8_t* out)
+{
+    uint8_t* start = out;
+    size_t literalStart = 0;
+    size_t i = 0;
+    while (i < length)
+    {
+        // Skip over unchanged bytes a word at a time, they are the most 
+        // common by far.
+        if (base != NULL)
+        {
+            size_t j = i;
+            while (j + 8 <= length && memcmp(data + j, base + j, 8) == 0)
+            {
+                j += 8;
+            }
+            while (j < length && data[j] == base[j])
+            {
+                j++;
+            }
+            if (j - i >= MIN_RUN)
+            {
+                out = writeLiterals(data, base, literalStart, i, out);
+                while (j - i >= MIN_RUN)
+                {
+                    size_t run = j - i > MAX_RUN ? MAX_RUN : j - i;
+                    *out++ = (uint8_t)(0x80 + run - MIN_RUN);
+                    *out++ = 0;
+                    i += run;
+                }
+                literalStart = i;
+                if (i == j)
+                {
+                    continue;
+                }
+            }
+        }
+
+        uint8_t value = base ? data[i] ^ base[i] : data[i];
+        size_t j = i + 1;
+        while (j < length && j - i < MAX_RUN && 
+               (base ? data[j] ^ base[j] : data[j]) == value)
+        {
+            j++;
+        }
+
+        if (j - i >= MIN_RUN)
+        {
+            out = writeLiterals(data, base, literalStart, i, out);
+            *out++ = (uint8_t)(0x80 + (j - i) - MIN_RUN);
+            *out++ = value;
+            i = j;
+            literalStart = i;
+        }
+        else
+        {
+            i++;
+        }
+    }
+    out = writeLiterals(data, base, literalStart, length, out);
+    return out - start;
+}
+
+bool decodeDelta(const uint8_t* in, size_t inLength, const uint8_t* base, 
+                 uint8_t* out, size_t length)
+{
+    size_t pos = 0;
+    size_t i = 0;
+    while (i < inLength)
+    {
+        uint8_t control = in[i++];
+        if (control < 0x80)
+        {
+            size_t count = control + 1;
+            if (i + count > inLength || pos + count > length)
+            {
+                return false;
+            }
+            memcpy(out + pos, in + i, count);
+            i += count;
+            pos += count;
+        }
+        else
+        {
+            size_t count = control - 0x80 + MIN_RUN;
+            if (i >= inLength || pos + count > length)
+            {
+                return false;
+            }
+            memset(out + pos, in[i++], count);
+            pos += count;
+        }
+    }
+    if (pos != length)
+    {
+        return false;
+    }
+
+    if (base != NULL)
+    {
+        for (size_t j = 0; j < length; j++)
+        {
+            out[j] ^= base[j];
+        }
+    }
+    return true;
+}
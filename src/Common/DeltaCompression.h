@@ -0,0 +1,55 @@
+#ifndef _DELTA_COMPRESSION_H_
+#define _DELTA_COMPRESSION_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file DeltaCompression.h
+ * @brief Run-length compression of the difference between two buffers.
+ *
+ * The data is XORed with a base buffer, so bytes that did not change become
+ * zero, then run-length encoded. Consecutive save states mostly differ in a 
+ * few bytes, so their delta is mostly long runs of zeros. Without a base 
+ * the data is just run-length encoded.
+ *
+ * The encoded data is a list of blocks, each starting with a control byte:
+ * - 0x00-0x7F: the next (control + 1) bytes are copied as they are.
+ * - 0x80-0xFF: the next byte is repeated (control - 0x80 + 3) times.
+ */
+
+/**
+ * Gets the most bytes encoding a buffer can take.
+ *
+ * @param length Length of the buffer to encode.
+ */
+size_t getMaxDeltaSize(size_t length);
+
+/**
+ * Encodes a buffer as the difference from a base buffer.
+ *
+ * @param data The buffer to encode.
+ * @param base The buffer to encode against, of the same length, or NULL.
+ * @param length Length of the buffers.
+ * @param out Where to write the encoding, at least getMaxDeltaSize(length)
+ * bytes.
+ * @return Length of the encoding.
+ */
+size_t encodeDelta(const uint8_t* data, const uint8_t* base, size_t length, 
+                   uint8_t* out);
+
+/**
+ * Decodes a buffer encoded by encodeDelta().
+ *
+ * @param in The encoding.
+ * @param inLength Length of the encoding.
+ * @param base The buffer that was encoded against, or NULL.
+ * @param out Where to write the decoded buffer.
+ * @param length Length of the decoded buffer.
+ * @return True if the encoding decoded to exactly length bytes, false 
+ * otherwise.
+ */
+bool decodeDelta(const uint8_t* in, size_t inLength, const uint8_t* base, 
+                 uint8_t* out, size_t length);
+
+#endif
@@ -0,0 +1,140 @@
+#include <errno.h>
+#include <time.h>
+
+#include "FramePacer.h"
+
+#define CYCLES_PER_FRAME 70224
+#define CYCLES_PER_SECOND 4194304
+#define NANOS_PER_SECOND 1000000000ULL
+
+// Sleep until this long before the deadline, then spin.
+#define SPIN_NANOS 500000
+
+// Start the schedule again when this many frames behind, rather than running
+// a burst of frames to catch up.
+#define MAX_FRAMES_BEHIND 4
+
+FramePacer::FramePacer()
+{
+    started = false;
+    deadline = 0;
+    remainder = 0;
+    drift = 0;
+    lateFrames = 0;
+    resyncs = 0;
+    setSpeed(1);
+}
+
+void FramePacer::setSpeed(int multiplier)
+{
+    speed = multiplier < 0 ? 0 : multiplier;
+    started = false;
+    if (speed == 0)
+    {
+        return;
+    }
+
+    uint64_t nanosPerFrame = CYCLES_PER_FRAME * NANOS_PER_SECOND;
+    periodDivisor = (uint64_t)CYCLES_PER_SECOND * speed;
+    framePeriod = nanosPerFrame / periodDivisor;
+    framePeriodRemainder = nanosPerFrame % periodDivisor;
+}
+
+int FramePacer::getSpeed()
+{
+    return speed;
+}
+
+void FramePacer::waitForFrame()
+{
+    if (speed == 0)
+    {
+        return;
+    }
+    if (!started)
+    {
+        resync();
+    }
+
+    uint64_t time = currentTime();
+    if (time > deadline)
+    {
+        drift += time - deadline;
+        lateFrames++;
+        if (time - deadline > MAX_FRAMES_BEHIND * framePeriod)
+        {
+            resyncs++;
+            resync();
+            return;
+        }
+    }
+    else
+    {
+        if (deadline - time > SPIN_NANOS)
+        {
+            sleepUntil(deadline - SPIN_NANOS);
+        }
+        while (currentTime() < deadline)
+        {
+            // Spin for the last part of the frame.
+        }
+    }
+
+    // The next frame's deadline.
+    deadline += framePeriod;
+    remainder += framePeriodRemainder;
+    if (remainder >= periodDivisor)
+    {
+        remainder -= periodDivisor;
+        deadline++;
+    }
+}
+
+uint64_t FramePacer::getDrift()
+{
+    return drift;
+}
+
+uint64_t FramePacer::getLateFrames()
+{
+    return lateFrames;
+}
+
+uint64_t FramePacer::getResyncs()
+{
+    return resyncs;
+}
+
+uint64_t FramePacer::now()
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * NANOS_PER_SECOND + time.tv_nsec;
+}
+
+uint64_t FramePacer::currentTime()
+{
+    return now();
+}
+
+void FramePacer::sleepUntil(uint64_t time)
+{
+    struct timespec wakeTime;
+    wakeTime.tv_sec = time / NANOS_PER_SECOND;
+    wakeTime.tv_nsec = time % NANOS_PER_SECOND;
+    int result;
+    do
+    {
+        // Interrupted by a signal, sleep for the rest of it. Any other error
+        // leaves the rest of the wait to the spin.
+        result = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeTime, 
+                                 NULL);
+    } while (result == EINTR);
+}
+
+void FramePacer::resync()
+{
+    started = true;
+    remainder = 0;
+    deadline = currentTime() + framePeriod;
+}
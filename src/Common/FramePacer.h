@@ -0,0 +1,109 @@
+#ifndef _FRAME_PACER_H_
+#define _FRAME_PACER_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Keeps frames running at the speed of a real Game Boy.
+ *
+ * A DMG frame is 70224 cycles at 4194304 Hz, about 59.7275 frames a second. 
+ * Each frame has an absolute deadline that is worked out from when pacing 
+ * started, not from when the last frame ended, so time spent emulating and
+ * oversleeping does not add up over many frames.
+ *
+ * The pacer sleeps with clock_nanosleep() until just before the deadline,
+ * then spins for the last part of it, as sleeps are only accurate to around
+ * a millisecond.
+ *
+ * Speeds above 1 fast-forward by that multiple, and speed 0 does not wait at
+ * all.
+ */
+class FramePacer
+{
+public:
+    FramePacer();
+    virtual ~FramePacer() {}
+
+    /**
+     * Sets how many times faster than a Game Boy to run. The schedule starts
+     * again from the next frame.
+     *
+     * @param multiplier The speed, e.g. 1, 2, 4 or 8. 0 does not throttle.
+     */
+    void setSpeed(int multiplier);
+
+    /**
+     * Gets how many times faster than a Game Boy frames are run.
+     */
+    int getSpeed();
+
+    /**
+     * Waits until the current frame's time is up. Call once after each 
+     * frame.
+     */
+    void waitForFrame();
+
+    /**
+     * Gets the total time in nanoseconds that frames were finished after 
+     * their deadlines.
+     */
+    uint64_t getDrift();
+
+    /**
+     * Gets the number of frames that were finished after their deadlines.
+     */
+    uint64_t getLateFrames();
+
+    /**
+     * Gets the number of times the pacer fell too far behind and started
+     * the schedule again.
+     */
+    uint64_t getResyncs();
+
+    /**
+     * Gets the current time of the monotonic clock in nanoseconds.
+     */
+    static uint64_t now();
+
+protected:
+    /**
+     * Gets the time frames are paced by, in nanoseconds. The monotonic clock
+     * unless a test replaces it.
+     */
+    virtual uint64_t currentTime();
+
+    /**
+     * Sleeps until currentTime() reaches a time, in nanoseconds.
+     */
+    virtual void sleepUntil(uint64_t time);
+
+private:
+    /**
+     * Starts the schedule again from now.
+     */
+    void resync();
+
+    /* The speed multiplier, 0 for no throttling. */
+    int speed;
+
+    /* Is the schedule running? */
+    bool started;
+
+    /* Deadline of the current frame in nanoseconds. */
+    uint64_t deadline;
+
+    /* A frame lasts framePeriod + framePeriodRemainder / periodDivisor 
+       nanoseconds. The remainder is carried from frame to frame so deadlines
+       stay exact. */
+    uint64_t framePeriod;
+    uint64_t framePeriodRemainder;
+    uint64_t periodDivisor;
+    uint64_t remainder;
+
+    /* Drift counters */
+    uint64_t drift;
+    uint64_t lateFrames;
+    uint64_t resyncs;
+};
+
+#endif
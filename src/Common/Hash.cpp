@@ -0,0 +1,105 @@
+#include <string.h>
+
+#include "Hash.h"
+
+// XXH64, by Yann Collet. Stripes of 32 bytes are mixed into four lanes that
+// don't depend on each other, so the compiler can keep all of them going at
+// once.
+#define PRIME1 0x9E3779B185EBCA87ULL
+#define PRIME2 0xC2B2AE3D27D4EB4FULL
+#define PRIME3 0x165667B19E3779F9ULL
+#define PRIME4 0x85EBCA77C2B2AE63ULL
+#define PRIME5 0x27D4EB2F165667C5ULL
+
+static inline uint64_t rotl(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// memcpy lets unaligned reads compile to plain loads. The hash is defined on
+// little endian values, like the hosts the emulator runs on.
+static inline uint64_t read64(const uint8_t* bytes)
+{
+    uint64_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+static inline uint32_t read32(const uint8_t* bytes)
+{
+    uint32_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+static inline uint64_t mixLane(uint64_t acc, uint64_t input)
+{
+    acc += input * PRIME2;
+    acc = rotl(acc, 31);
+    return acc * PRIME1;
+}
+
+static inline uint64_t mergeRound(uint64_t acc, uint64_t lane)
+{
+    acc ^= mixLane(0, lane);
+    return acc * PRIME1 + PRIME4;
+}
+
+uint64_t hashBytes(const void* data, size_t length, uint64_t seed)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    const uint8_t* end = bytes + length;
+    uint64_t hash;
+
+    if (length >= 32)
+    {
+        uint64_t lane1 = seed + PRIME1 + PRIME2;
+        uint64_t lane2 = seed + PRIME2;
+        uint64_t lane3 = seed;
+        uint64_t lane4 = seed - PRIME1;
+        const uint8_t* lastStripe = end - 32;
+        do
+        {
+            lane1 = mixLane(lane1, read64(bytes));
+            lane2 = mixLane(lane2, read64(bytes + 8));
+            lane3 = mixLane(lane3, read64(bytes + 16));
+            lane4 = mixLane(lane4, read64(bytes + 24));
+            bytes += 32;
+        } while (bytes <= lastStripe);
+
+        hash = rotl(lane1, 1) + rotl(lane2, 7) + rotl(lane3, 12) + rotl(lane4, 18);
+        hash = mergeRound(hash, lane1);
+        hash = mergeRound(hash, lane2);
+        hash = mergeRound(hash, lane3);
+        hash = mergeRound(hash, lane4);
+    }
+    else
+    {
+        hash = seed + PRIME5;
+    }
+    hash += length;
+
+    for (; bytes + 8 <= end; bytes += 8)
+    {
+        hash ^= mixLane(0, read64(bytes));
+        hash = rotl(hash, 27) * PRIME1 + PRIME4;
+    }
+    if (bytes + 4 <= end)
+    {
+        hash ^= read32(bytes) * PRIME1;
+        hash = rotl(hash, 23) * PRIME2 + PRIME3;
+        bytes += 4;
+    }
+    for (; bytes < end; bytes++)
+    {
+        hash ^= *bytes * PRIME5;
+        hash = rotl(hash, 11) * PRIME1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIME2;
+    hash ^= hash >> 29;
+    hash *= PRIME3;
+    hash ^= hash >> 32;
+    return hash;
+}
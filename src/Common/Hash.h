@@ -0,0 +1,23 @@
+#ifndef _HASH_H_
+#define _HASH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Hashes a block of memory, e.g. to check that two runs drew the same 
+ * frames or ended up in the same state.
+ *
+ * The hash is XXH64, so it matches xxhsum -H1 and other xxHash
+ * implementations. It goes through several GB/s, so hashing a frame or a
+ * save state every frame is cheap next to emulating it.
+ *
+ * @param data The memory to hash.
+ * @param length Length of the memory in bytes.
+ * @param seed Starts the hash somewhere else, giving another hash of the
+ * same memory.
+ * @return A 64-bit hash of the memory.
+ */
+uint64_t hashBytes(const void* data, size_t length, uint64_t seed = 0);
+
+#endif
@@ -0,0 +1,126 @@
+#include <time.h>
+
+#include "Metrics.h"
+
+#define NANOS_PER_SECOND 1000000000ULL
+
+static const char* counterNames[] =
+{
+    "instructions",
+    "cycles",
+    "memory_reads.RomBank0_1",
+    "memory_reads.RomBank0_2",
+    "memory_reads.RomBanks_1",
+    "memory_reads.RomBanks_2",
+    "memory_reads.VRAM",
+    "memory_reads.ERam",
+    "memory_reads.WRam0",
+    "memory_reads.WRam1",
+    "memory_reads.ECHORAM",
+    "memory_reads.Oam",
+    "memory_reads.NonUseable",
+    "memory_reads.IOPorts",
+    "memory_reads.HRam",
+    "memory_reads.IReg",
+    "vram_rejects",
+    "frames_rendered",
+    "frames_skipped",
+    "cpu_ns",
+    "lcd_ns",
+    "present_ns",
+    "host_cycles",
+    "host_instructions",
+    "host_branch_misses",
+    "host_cache_misses"
+};
+
+static_assert(sizeof(counterNames) / sizeof(counterNames[0]) == Metrics::COUNTER_COUNT,
+              "Every counter needs a name.");
+
+std::mutex Metrics::registryMutex;
+std::vector<Metrics::ThreadCounters*> Metrics::registry;
+
+uint64_t Metrics::now()
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * NANOS_PER_SECOND + time.tv_nsec;
+}
+
+const char* Metrics::getName(int counter)
+{
+    return counterNames[counter];
+}
+
+Metrics::ThreadCounters* Metrics::registerThread()
+{
+    ThreadCounters* counters = new ThreadCounters;
+    for (int i = 0; i < COUNTER_COUNT; i++)
+    {
+        counters->values[i].store(0, std::memory_order_relaxed);
+    }
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    registry.push_back(counters);
+    return counters;
+}
+
+void Metrics::snapshot(Snapshot* snapshot)
+{
+    snapshot->time = now();
+    snapshot->threads.clear();
+    snapshot->total.assign(COUNTER_COUNT, 0);
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (size_t i = 0; i < registry.size(); i++)
+    {
+        ThreadCounters* counters = registry[i];
+        std::vector<uint64_t> values(COUNTER_COUNT);
+        for (int c = 0; c < COUNTER_COUNT; c++)
+        {
+            values[c] = counters->values[c].load(std::memory_order_relaxed);
+            snapshot->total[c] += values[c];
+        }
+        snapshot->threads.push_back(values);
+    }
+}
+
+void Metrics::writeText(const Snapshot& snapshot, std::ostream& out)
+{
+    for (int c = 0; c < COUNTER_COUNT; c++)
+    {
+        out << counterNames[c] << " " << snapshot.total[c] << "\n";
+    }
+}
+
+/**
+ * Writes counters as the members of a JSON object.
+ */
+static void writeJsonCounters(const std::vector<uint64_t>& values,
+                              std::ostream& out)
+{
+    out << "{";
+    for (int c = 0; c < Metrics::COUNTER_COUNT; c++)
+    {
+        out << (c == 0 ? "" : ", ") << "\"" << counterNames[c] << "\": "
+            << values[c];
+    }
+    out << "}";
+}
+
+void Metrics::writeJson(const Snapshot& snapshot, std::ostream& out)
+{
+    out << "{\n"
+        << "  \"time_ns\": " << snapshot.time << ",\n"
+        << "  \"total\": ";
+    writeJsonCounters(snapshot.total, out);
+    out << ",\n"
+        << "  \"threads\": [";
+    for (size_t i = 0; i < snapshot.threads.size(); i++)
+    {
+        out << (i == 0 ? "\n    " : ",\n    ");
+        writeJsonCounters(snapshot.threads[i], out);
+    }
+    out << "\n  ]\n"
+        << "}\n";
+}
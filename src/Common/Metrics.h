@@ -0,0 +1,131 @@
+#ifndef _METRICS_H_
+#define _METRICS_H_
+
+#include <atomic>
+#include <mutex>
+#include <ostream>
+#include <stdint.h>
+#include <vector>
+
+#include "../Memory/MemoryDefs.h"
+
+/**
+ * Adds to a counter, when the emulator is built with GB_METRICS. Otherwise it
+ * compiles to nothing, so the hot paths cost nothing.
+ */
+#ifdef GB_METRICS
+#define GB_METRIC_ADD(counter, value) Metrics::add((counter), (value))
+#else
+#define GB_METRIC_ADD(counter, value) do {} while (0)
+#endif
+
+/**
+ * @brief Counters of what the emulator is doing.
+ *
+ * Every thread has its own counters, which only it writes to, so counting
+ * costs a load and a store to memory no other thread writes to. Any thread
+ * can take a snapshot of all counters at any time.
+ *
+ * The emulator only counts when it is built with GB_METRICS.
+ */
+class Metrics
+{
+public:
+    enum Counter
+    {
+        INSTRUCTIONS,
+        CYCLES,
+        /** Memory::read calls, one counter per AddressRange. */
+        MEMORY_READS,
+        /** VRAM reads that were blocked while the LCD was drawing. */
+        VRAM_REJECTS = MEMORY_READS + ADDRESS_RANGE_SIZE,
+        FRAMES_RENDERED,
+        FRAMES_SKIPPED,
+        /** Host time spent in each component, in nanoseconds. */
+        CPU_NS,
+        LCD_NS,
+        PRESENT_NS,
+        /** Host CPU events while emulating, see PerfCounters. */
+        HOST_CYCLES,
+        HOST_INSTRUCTIONS,
+        HOST_BRANCH_MISSES,
+        HOST_CACHE_MISSES,
+        COUNTER_COUNT
+    };
+
+    /**
+     * The counters at one point in time.
+     */
+    struct Snapshot
+    {
+        /** Nanoseconds since an arbitrary point, see now(). */
+        uint64_t time;
+        /** Counters of every thread that counted something. */
+        std::vector<std::vector<uint64_t> > threads;
+        /** Counters added up over all threads. */
+        std::vector<uint64_t> total;
+    };
+
+    /**
+     * Adds to one of the calling thread's counters.
+     */
+    static void add(int counter, uint64_t value)
+    {
+        std::atomic<uint64_t>& count = getThreadCounters()->values[counter];
+        count.store(count.load(std::memory_order_relaxed) + value,
+                    std::memory_order_relaxed);
+    }
+
+    /**
+     * Gets the time from a monotonic clock, in nanoseconds.
+     */
+    static uint64_t now();
+
+    /**
+     * Gets the name of a counter, such as "memory_reads.VRAM".
+     */
+    static const char* getName(int counter);
+
+    /**
+     * Reads the counters of all threads.
+     */
+    static void snapshot(Snapshot* snapshot);
+
+    /**
+     * Writes the totals, one "name value" line per counter.
+     */
+    static void writeText(const Snapshot& snapshot, std::ostream& out);
+
+    /**
+     * Writes the totals and the counters of each thread as a JSON object.
+     */
+    static void writeJson(const Snapshot& snapshot, std::ostream& out);
+
+private:
+    struct ThreadCounters
+    {
+        std::atomic<uint64_t> values[COUNTER_COUNT];
+    };
+
+    static ThreadCounters* getThreadCounters()
+    {
+        static thread_local ThreadCounters* counters = NULL;
+        if (counters == NULL)
+        {
+            counters = registerThread();
+        }
+        return counters;
+    }
+
+    /**
+     * Creates counters for the calling thread. They are kept after the
+     * thread ends, so that what it counted is still in the totals.
+     */
+    static ThreadCounters* registerThread();
+
+    /* Counters of every thread that has counted something. */
+    static std::mutex registryMutex;
+    static std::vector<ThreadCounters*> registry;
+};
+
+#endif
@@ -0,0 +1,206 @@
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "Metrics.h"
+#include "MetricsExporter.h"
+
+// How long the thread waits at most, so that it stops soon after being told.
+#define POLL_MS 100
+
+MetricsExporter::MetricsExporter()
+{
+    intervalMs = 1000;
+    listenFd = -1;
+    running = false;
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    stop();
+#ifndef _WIN32
+    if (listenFd >= 0)
+    {
+        close(listenFd);
+        unlink(socketPath.c_str());
+    }
+#endif
+}
+
+void MetricsExporter::setFile(const std::string& file, int interval)
+{
+    fileName = file;
+    intervalMs = interval > 0 ? interval : 1;
+}
+
+bool MetricsExporter::listen(const std::string& path)
+{
+#ifdef _WIN32
+    error = "Unix sockets are not supported on this platform.";
+    return false;
+#else
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path))
+    {
+        error = "The socket path " + path + " is too long.";
+        return false;
+    }
+    strcpy(addr.sun_path, path.c_str());
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        error = std::string("Could not create a socket: ") + strerror(errno);
+        return false;
+    }
+    // Only a socket left behind by an earlier run is replaced. Anything else
+    // with the name is kept, and the bind fails.
+    struct stat info;
+    if (lstat(path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode))
+    {
+        unlink(path.c_str());
+    }
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        ::listen(fd, 4) != 0)
+    {
+        error = "Could not listen on " + path + ": " + strerror(errno);
+        close(fd);
+        return false;
+    }
+    listenFd = fd;
+    socketPath = path;
+    return true;
+#endif
+}
+
+void MetricsExporter::start()
+{
+    if (!running)
+    {
+        running = true;
+        thread = std::thread(&MetricsExporter::run, this);
+    }
+}
+
+void MetricsExporter::stop()
+{
+    if (running)
+    {
+        running = false;
+        thread.join();
+        writeFile();
+    }
+}
+
+std::string MetricsExporter::getErrorMessage()
+{
+    return error;
+}
+
+void MetricsExporter::run()
+{
+    uint64_t nextWrite = Metrics::now();
+    while (running)
+    {
+        uint64_t time = Metrics::now();
+        if (time >= nextWrite)
+        {
+            writeFile();
+            nextWrite = time + (uint64_t)intervalMs * 1000000;
+        }
+        int timeout = (int)((nextWrite - time) / 1000000);
+        if (timeout > POLL_MS)
+        {
+            timeout = POLL_MS;
+        }
+
+#ifdef _WIN32
+        std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+#else
+        if (listenFd < 0)
+        {
+            poll(NULL, 0, timeout);
+            continue;
+        }
+        struct pollfd fds;
+        fds.fd = listenFd;
+        fds.events = POLLIN;
+        if (poll(&fds, 1, timeout) > 0 && (fds.revents & POLLIN))
+        {
+            answer();
+        }
+#endif
+    }
+}
+
+void MetricsExporter::writeFile()
+{
+    if (fileName.empty())
+    {
+        return;
+    }
+
+    Metrics::Snapshot snapshot;
+    Metrics::snapshot(&snapshot);
+
+    std::string tempName = fileName + ".tmp";
+    {
+        std::ofstream out(tempName.c_str());
+        if (!out.is_open())
+        {
+            return;
+        }
+        if (fileName.size() >= 5 &&
+            fileName.compare(fileName.size() - 5, 5, ".json") == 0)
+        {
+            Metrics::writeJson(snapshot, out);
+        }
+        else
+        {
+            Metrics::writeText(snapshot, out);
+        }
+    }
+    rename(tempName.c_str(), fileName.c_str());
+}
+
+void MetricsExporter::answer()
+{
+#ifndef _WIN32
+    int fd = accept(listenFd, NULL, NULL);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    Metrics::Snapshot snapshot;
+    Metrics::snapshot(&snapshot);
+    std::ostringstream out;
+    Metrics::writeJson(snapshot, out);
+    std::string text = out.str();
+
+    size_t sent = 0;
+    while (sent < text.size())
+    {
+        ssize_t n = send(fd, text.data() + sent, text.size() - sent,
+                         MSG_NOSIGNAL);
+        if (n <= 0)
+        {
+            break;
+        }
+        sent += n;
+    }
+    close(fd);
+#endif
+}
@@ -0,0 +1,69 @@
+#ifndef _METRICS_EXPORTER_H_
+#define _METRICS_EXPORTER_H_
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Makes the metrics available outside of the emulator.
+ *
+ * A thread of its own writes a snapshot of the metrics to a file every
+ * interval, and/or answers every connection to a Unix socket with a JSON
+ * snapshot, e.g. "nc -U gameboy.sock". The file is JSON when its name ends
+ * in .json, and "name value" lines otherwise. It is replaced as a whole, so
+ * readers never see half a snapshot.
+ */
+class MetricsExporter
+{
+public:
+    MetricsExporter();
+
+    /**
+     * Stops exporting.
+     */
+    ~MetricsExporter();
+
+    /**
+     * Writes snapshots to a file.
+     *
+     * @param fileName The file to write to.
+     * @param intervalMs Milliseconds between snapshots.
+     */
+    void setFile(const std::string& fileName, int intervalMs = 1000);
+
+    /**
+     * Serves snapshots on a Unix socket, replacing whatever is at the path.
+     *
+     * @return false if the socket could not be made.
+     */
+    bool listen(const std::string& socketPath);
+
+    /**
+     * Starts exporting on a thread.
+     */
+    void start();
+
+    /**
+     * Stops exporting, after writing the file one last time.
+     */
+    void stop();
+
+    std::string getErrorMessage();
+
+private:
+    void run();
+    void writeFile();
+    void answer();
+
+    std::string fileName;
+    int intervalMs;
+    std::string socketPath;
+    int listenFd;
+
+    std::thread thread;
+    std::atomic<bool> running;
+    std::string error;
+};
+
+#endif
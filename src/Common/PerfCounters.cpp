@@ -0,0 +1,225 @@
+#include <string.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "Metrics.h"
+#include "PerfCounters.h"
+
+static const char* eventNames[PerfCounters::EVENT_COUNT] =
+{
+    "cycles",
+    "instructions",
+    "branch_misses",
+    "cache_misses",
+    "task_clock_ns"
+};
+
+PerfCounters::PerfCounters()
+{
+    for (int i = 0; i < EVENT_COUNT; i++)
+    {
+        fds[i] = -1;
+        totals[i] = 0;
+        startValues[i] = 0;
+    }
+    startEnabled = 0;
+    startRunning = 0;
+    leader = -1;
+    opened = false;
+    slices = 0;
+}
+
+PerfCounters::~PerfCounters()
+{
+#ifdef __linux__
+    for (int i = 0; i < EVENT_COUNT; i++)
+    {
+        if (fds[i] >= 0)
+        {
+            close(fds[i]);
+        }
+    }
+#endif
+}
+
+bool PerfCounters::open()
+{
+    opened = true;
+#ifdef __linux__
+    static const struct
+    {
+        uint32_t type;
+        uint64_t config;
+    } events[EVENT_COUNT] =
+    {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK }
+    };
+
+    std::string firstError;
+    for (int i = 0; i < EVENT_COUNT; i++)
+    {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = events[i].type;
+        attr.config = events[i].config;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                           PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        // The group starts counting at once, slices are told apart by
+        // reading it at start() and stop().
+        int groupFd = leader < 0 ? -1 : fds[leader];
+        fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0);
+        if (fds[i] < 0)
+        {
+            if (firstError.empty())
+            {
+                firstError = std::string(eventNames[i]) + ": " + strerror(errno);
+            }
+        }
+        else if (leader < 0)
+        {
+            leader = i;
+        }
+    }
+
+    if (leader < 0)
+    {
+        error = "Could not open the perf counters, " + firstError + ".";
+        return false;
+    }
+    return true;
+#else
+    error = "Perf counters are only supported on Linux.";
+    return false;
+#endif
+}
+
+void PerfCounters::start()
+{
+    if (!opened)
+    {
+        open();
+    }
+    if (leader >= 0)
+    {
+        read(startValues, &startEnabled, &startRunning);
+    }
+}
+
+void PerfCounters::stop()
+{
+    if (leader < 0)
+    {
+        return;
+    }
+    uint64_t values[EVENT_COUNT];
+    uint64_t enabled;
+    uint64_t running;
+    read(values, &enabled, &running);
+
+    // Scale up by the share of this slice the group was counting for, if it
+    // had to share the hardware. Scaling the counts since the counters were
+    // opened instead would mix in how earlier slices were shared.
+    uint64_t enabledTime = enabled - startEnabled;
+    uint64_t runningTime = running - startRunning;
+    double scale = 1.0;
+    if (runningTime != 0 && runningTime < enabledTime)
+    {
+        scale = (double)enabledTime / runningTime;
+    }
+    uint64_t deltas[EVENT_COUNT];
+    for (int i = 0; i < EVENT_COUNT; i++)
+    {
+        deltas[i] = values[i] >= startValues[i] ?
+                    (uint64_t)((values[i] - startValues[i]) * scale) : 0;
+        totals[i] += deltas[i];
+    }
+    slices++;
+
+    GB_METRIC_ADD(Metrics::HOST_CYCLES, deltas[CYCLES]);
+    GB_METRIC_ADD(Metrics::HOST_INSTRUCTIONS, deltas[INSTRUCTIONS]);
+    GB_METRIC_ADD(Metrics::HOST_BRANCH_MISSES, deltas[BRANCH_MISSES]);
+    GB_METRIC_ADD(Metrics::HOST_CACHE_MISSES, deltas[CACHE_MISSES]);
+}
+
+void PerfCounters::read(uint64_t* values, uint64_t* enabled, uint64_t* running)
+{
+    memset(values, 0, sizeof(uint64_t) * EVENT_COUNT);
+    *enabled = 0;
+    *running = 0;
+#ifdef __linux__
+    // nr, time enabled, time running, then a value per event in the order
+    // they were opened.
+    uint64_t data[3 + EVENT_COUNT];
+    ssize_t size = ::read(fds[leader], data, sizeof(data));
+    if (size < (ssize_t)(3 * sizeof(uint64_t)))
+    {
+        return;
+    }
+
+    *enabled = data[1];
+    *running = data[2];
+    uint64_t index = 0;
+    for (int i = 0; i < EVENT_COUNT && index < data[0]; i++)
+    {
+        if (fds[i] >= 0)
+        {
+            values[i] = data[3 + index];
+            index++;
+        }
+    }
+#endif
+}
+
+const char* PerfCounters::getName(int event)
+{
+    return eventNames[event];
+}
+
+void PerfCounters::writeText(std::ostream& out, uint64_t guestCycles,
+                             uint64_t guestInstructions) const
+{
+    out << "Host counters over " << slices << " slices:\n";
+    for (int i = 0; i < EVENT_COUNT; i++)
+    {
+        out << "  " << eventNames[i] << ": ";
+        if (!isAvailable(i))
+        {
+            out << "not supported\n";
+            continue;
+        }
+        out << totals[i];
+        if (guestCycles != 0)
+        {
+            out << ", " << (double)totals[i] / guestCycles << " per guest cycle";
+        }
+        if (guestInstructions != 0)
+        {
+            out << ", " << (double)totals[i] / guestInstructions
+                << " per guest instruction";
+        }
+        out << "\n";
+    }
+    if (isAvailable(CYCLES) && isAvailable(INSTRUCTIONS) && totals[CYCLES] != 0)
+    {
+        out << "  instructions per cycle: "
+            << (double)totals[INSTRUCTIONS] / totals[CYCLES] << "\n";
+    }
+}
+
+std::string PerfCounters::getErrorMessage()
+{
+    return error;
+}
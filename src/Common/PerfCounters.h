@@ -0,0 +1,120 @@
+#ifndef _PERF_COUNTERS_H_
+#define _PERF_COUNTERS_H_
+
+#include <ostream>
+#include <stdint.h>
+#include <string>
+
+/**
+ * @brief Hardware counters of the host CPU, read with perf_event_open.
+ *
+ * The counters count the thread that opened them, and only between start()
+ * and stop(), so they can be wrapped around the slices of emulation and
+ * leave out waiting for the display or the frame pacer. Every stop() adds
+ * what was counted to the totals, and to the host_* Metrics counters when
+ * built with GB_METRICS.
+ *
+ * The events are opened as one group, so a slice costs a single read. Events
+ * the host does not have are left out of the group, as virtual machines
+ * often have no hardware counters, or only some of them. Task clock is a
+ * software event and works wherever perf_event_open does. Counts are scaled
+ * up if the kernel had to share the hardware counters with other users.
+ *
+ * Counters are only supported on Linux. Most systems need
+ * /proc/sys/kernel/perf_event_paranoid at 2 or less, as only user space is
+ * counted.
+ */
+class PerfCounters
+{
+public:
+    enum Event
+    {
+        CYCLES,
+        INSTRUCTIONS,
+        BRANCH_MISSES,
+        CACHE_MISSES,
+        /** Time the thread was running, in nanoseconds. */
+        TASK_CLOCK,
+        EVENT_COUNT
+    };
+
+    PerfCounters();
+
+    /**
+     * Closes the counters.
+     */
+    ~PerfCounters();
+
+    /**
+     * Opens the counters for the calling thread, which has to be the one
+     * that calls start() and stop(). If it is not called, the first start()
+     * opens them.
+     *
+     * @return false if no event could be opened, see getErrorMessage().
+     */
+    bool open();
+
+    /**
+     * Checks whether an event could be opened.
+     */
+    bool isAvailable(int event) const { return fds[event] >= 0; }
+
+    /**
+     * Starts counting.
+     */
+    void start();
+
+    /**
+     * Stops counting, and adds what was counted since start() to the
+     * totals.
+     */
+    void stop();
+
+    /**
+     * Gets the total of an event over every slice.
+     */
+    uint64_t get(int event) const { return totals[event]; }
+
+    /**
+     * Gets the number of slices that were counted.
+     */
+    uint64_t getSliceCount() const { return slices; }
+
+    /**
+     * Gets the name of an event, such as "branch_misses".
+     */
+    static const char* getName(int event);
+
+    /**
+     * Writes the totals, and their cost per guest cycle and instruction.
+     *
+     * @param guestCycles Cycles the Game Boy ran for.
+     * @param guestInstructions Instructions the Game Boy ran, or 0 if they
+     * were not counted.
+     */
+    void writeText(std::ostream& out, uint64_t guestCycles,
+                   uint64_t guestInstructions) const;
+
+    std::string getErrorMessage();
+
+private:
+    /**
+     * Reads every event as counted, and the nanoseconds the group was
+     * enabled for and actually counting for.
+     */
+    void read(uint64_t* values, uint64_t* enabled, uint64_t* running);
+
+    int fds[EVENT_COUNT];
+    /* The first event that was opened, which leads the group. */
+    int leader;
+    bool opened;
+    uint64_t totals[EVENT_COUNT];
+    /* The raw value of each event, and the group's times, at start(). */
+    uint64_t startValues[EVENT_COUNT];
+    uint64_t startEnabled;
+    uint64_t startRunning;
+    uint64_t slices;
+    std::string error;
+};
+
+#endif
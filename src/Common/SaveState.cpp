@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "FileUtils.h"
+#include "SaveState.h"
+
+#define SAVE_STATE_MAGIC "GBST"
+#define HEADER_SIZE 8
+#define CHUNK_HEADER_SIZE 8
+
+StateWriter::StateWriter()
+{
+    clear();
+}
+
+void StateWriter::clear()
+{
+    data.clear();
+    chunkStart = 0;
+
+    uint32_t version = SAVE_STATE_VERSION;
+    write(SAVE_STATE_MAGIC, 4);
+    write(version);
+}
+
+void StateWriter::beginChunk(const char* id)
+{
+    write(id, 4);
+    chunkStart = data.size();
+
+    uint32_t size = 0;
+    write(size);
+}
+
+void StateWriter::endChunk()
+{
+    uint32_t size = (uint32_t)(data.size() - chunkStart - sizeof(uint32_t));
+    if (size == 0)
+    {
+        data.resize(chunkStart - 4);
+    }
+    else
+    {
+        memcpy(&data[chunkStart], &size, sizeof(size));
+    }
+}
+
+void StateWriter::write(const void* bytes, size_t size)
+{
+    // Grown and copied rather than inserted, which GCC 12 wrongly warns 
+    // overflows at -O3.
+    if (size > 0)
+    {
+        size_t end = data.size();
+        data.resize(end + size);
+        memcpy(&data[end], bytes, size);
+    }
+}
+
+const uint8_t* StateWriter::getData()
+{
+    return &data[0];
+}
+
+size_t StateWriter::getSize()
+{
+    return data.size();
+}
+
+bool StateWriter::save(const std::string fileName)
+{
+    FILE* file = fopen(fileName.c_str(), "wb");
+    if (file == NULL)
+    {
+        return false;
+    }
+    bool written = fwrite(&data[0], 1, data.size(), file) == data.size();
+    return fclose(file) == 0 && written;
+}
+
+StateReader::StateReader(const uint8_t* data, size_t size)
+{
+    this->data = data;
+    this->size = size;
+    readHeader();
+}
+
+StateReader::StateReader(const std::string fileName)
+{
+    size_t length = 0;
+    char* buffer = readFileToBuffer(fileName, &length);
+    if (buffer != NULL)
+    {
+        fileData.assign(buffer, buffer + length);
+        delete[] buffer;
+    }
+
+    data = fileData.empty() ? NULL : &fileData[0];
+    size = fileData.size();
+    readHeader();
+    if (buffer == NULL)
+    {
+        error = "Could not read save state " + fileName + ".";
+    }
+}
+
+void StateReader::readHeader()
+{
+    chunk = NULL;
+    chunkSize = 0;
+    chunkPos = 0;
+
+    valid = false;
+    if (size < HEADER_SIZE || memcmp(data, SAVE_STATE_MAGIC, 4) != 0)
+    {
+        error = "Not a save state.";
+        return;
+    }
+
+    uint32_t version;
+    memcpy(&version, data + 4, sizeof(version));
+    if (version != SAVE_STATE_VERSION)
+    {
+        error = "The save state is from a different version.";
+        return;
+    }
+    valid = true;
+}
+
+bool StateReader::isValid()
+{
+    return valid;
+}
+
+bool StateReader::openChunk(const char* id)
+{
+    chunk = NULL;
+    chunkSize = 0;
+    chunkPos = 0;
+    if (!valid)
+    {
+        return false;
+    }
+
+    size_t pos = HEADER_SIZE;
+    while (pos + CHUNK_HEADER_SIZE <= size)
+    {
+        uint32_t length;
+        memcpy(&length, data + pos + 4, sizeof(length));
+        if (pos + CHUNK_HEADER_SIZE + length > size)
+        {
+            break;
+        }
+        if (memcmp(data + pos, id, 4) == 0)
+        {
+            chunk = data + pos + CHUNK_HEADER_SIZE;
+            chunkSize = length;
+            return true;
+        }
+        pos += CHUNK_HEADER_SIZE + length;
+    }
+
+    error = std::string("The save state has no ") + std::string(id, 4) + 
+            " chunk.";
+    return false;
+}
+
+size_t StateReader::getChunkSize()
+{
+    return chunkSize;
+}
+
+bool StateReader::read(void* bytes, size_t length)
+{
+    if (chunk == NULL || chunkPos + length > chunkSize)
+    {
+        error = "A save state chunk is too short.";
+        return false;
+    }
+    memcpy(bytes, chunk + chunkPos, length);
+    chunkPos += length;
+    return true;
+}
+
+std::string StateReader::getErrorMessage()
+{
+    return error;
+}
+
+void StateReader::setErrorMessage(const std::string message)
+{
+    error = message;
+}
@@ -0,0 +1,175 @@
+#ifndef _SAVE_STATE_H_
+#define _SAVE_STATE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * @file SaveState.h
+ * @brief Reading and writing snapshots of a machine.
+ *
+ * A save state starts with a header:
+ *
+ *     char     magic[4]    "GBST"
+ *     uint32_t version     SAVE_STATE_VERSION
+ *
+ * followed by a list of chunks:
+ *
+ *     char     id[4]       e.g. "CPU ", "LCD ", "VRAM"
+ *     uint32_t size        Size of the data in bytes.
+ *     uint8_t  data[size]
+ *
+ * Each component of the machine writes its own chunks, and finds them again
+ * by id when loading, so chunks can be added without breaking old states. 
+ * Values are stored in the byte order of the host. Changing the contents of
+ * an existing chunk must bump SAVE_STATE_VERSION.
+ */
+
+#define SAVE_STATE_VERSION 1
+
+/**
+ * Writes a save state into memory.
+ */
+class StateWriter
+{
+public:
+    StateWriter();
+
+    /**
+     * Starts a new state, throwing away anything that was written. The 
+     * memory that was used is kept, so writing states over and over does not
+     * allocate.
+     */
+    void clear();
+
+    /**
+     * Starts a chunk. Chunks can't be nested.
+     *
+     * @param id The four character id of the chunk.
+     */
+    void beginChunk(const char* id);
+
+    /**
+     * Finishes the chunk that was started. Empty chunks are left out.
+     */
+    void endChunk();
+
+    /**
+     * Writes data to the current chunk.
+     */
+    void write(const void* data, size_t size);
+
+    template <typename T>
+    void write(const T& value)
+    {
+        write(&value, sizeof(T));
+    }
+
+    /**
+     * Gets the state that was written.
+     */
+    const uint8_t* getData();
+
+    /**
+     * Gets the size of the state that was written, in bytes.
+     */
+    size_t getSize();
+
+    /**
+     * Writes the state to a file.
+     *
+     * @return True if the state was saved, false otherwise.
+     */
+    bool save(const std::string fileName);
+
+private:
+    std::vector<uint8_t> data;
+
+    /* Where the size of the current chunk goes. */
+    size_t chunkStart;
+};
+
+/**
+ * Reads a save state from memory.
+ */
+class StateReader
+{
+public:
+    /**
+     * Reads a state in memory. The memory must stay around while it is 
+     * being read.
+     */
+    StateReader(const uint8_t* data, size_t size);
+
+    /**
+     * Reads a state from a file.
+     */
+    StateReader(const std::string fileName);
+
+    /**
+     * Is this a state that can be read? False if the header is not right, or
+     * the state is from a different version.
+     */
+    bool isValid();
+
+    /**
+     * Finds a chunk and starts reading it from the beginning.
+     *
+     * @param id The four character id of the chunk.
+     * @return True if the chunk was found, false otherwise.
+     */
+    bool openChunk(const char* id);
+
+    /**
+     * Gets the size of the open chunk in bytes.
+     */
+    size_t getChunkSize();
+
+    /**
+     * Reads data from the open chunk.
+     *
+     * @return True if there was enough data left in the chunk, false 
+     * otherwise.
+     */
+    bool read(void* data, size_t size);
+
+    template <typename T>
+    bool read(T* value)
+    {
+        return read(value, sizeof(T));
+    }
+
+    /**
+     * Gets the reason the state could not be read.
+     */
+    std::string getErrorMessage();
+
+    /**
+     * Records why a component could not load the state.
+     */
+    void setErrorMessage(const std::string message);
+
+private:
+    /**
+     * Checks the header of the state.
+     */
+    void readHeader();
+
+    /* Holds the state when it is read from a file. */
+    std::vector<uint8_t> fileData;
+
+    const uint8_t* data;
+    size_t size;
+    bool valid;
+
+    /* The open chunk */
+    const uint8_t* chunk;
+    size_t chunkSize;
+    size_t chunkPos;
+
+    std::string error;
+};
+
+#endif
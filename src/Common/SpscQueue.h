@@ -0,0 +1,64 @@
+#ifndef _SPSC_QUEUE_H_
+#define _SPSC_QUEUE_H_
+
+#include <atomic>
+
+/**
+ * @brief Lock-free single producer, single consumer queue.
+ *
+ * A fixed size ring of items. Only one thread may push, and only one thread
+ * may pop.
+ *
+ * @tparam T Type of the items.
+ * @tparam Size Maximum number of items in the queue, must be a power of 2.
+ */
+template<typename T, unsigned Size>
+class SpscQueue
+{
+public:
+    SpscQueue() : head(0), tail(0) {}
+
+    /**
+     * Adds an item to the back of the queue.
+     *
+     * @return True if the item was added, false if the queue is full.
+     */
+    bool push(const T& item)
+    {
+        unsigned t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == Size)
+        {
+            return false;
+        }
+        items[t & (Size - 1)] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Removes the item at the front of the queue.
+     *
+     * @param[out] item Where to store the item.
+     * @return True if an item was removed, false if the queue is empty.
+     */
+    bool pop(T* item)
+    {
+        unsigned h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        *item = items[h & (Size - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    T items[Size];
+
+    /* Both only ever increase, and wrap around together. */
+    std::atomic<unsigned> head;
+    std::atomic<unsigned> tail;
+};
+
+#endif
@@ -0,0 +1,135 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(int threads)
+{
+    if (threads <= 0)
+    {
+        threads = (int)std::thread::hardware_concurrency();
+        if (threads <= 0)
+        {
+            threads = 1;
+        }
+    }
+
+    nextWorker = 0;
+    queued = 0;
+    pending = 0;
+    stopping = false;
+
+    for (int i = 0; i < threads; i++)
+    {
+        workers.push_back(new Worker());
+    }
+    for (int i = 0; i < threads; i++)
+    {
+        this->threads.push_back(std::thread(&ThreadPool::work, this, i));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(stateLock);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (size_t i = 0; i < threads.size(); i++)
+    {
+        threads[i].join();
+    }
+    for (size_t i = 0; i < workers.size(); i++)
+    {
+        delete workers[i];
+    }
+}
+
+void ThreadPool::submit(Task* task)
+{
+    Worker* worker;
+    {
+        std::lock_guard<std::mutex> lock(stateLock);
+        worker = workers[nextWorker++ % workers.size()];
+        queued++;
+        pending++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(worker->lock);
+        worker->tasks.push_back(task);
+    }
+    wakeUp.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(stateLock);
+    while (pending > 0)
+    {
+        finished.wait(lock);
+    }
+}
+
+int ThreadPool::getThreadCount()
+{
+    return (int)threads.size();
+}
+
+void ThreadPool::work(int index)
+{
+    while (true)
+    {
+        Task* task;
+        if (takeTask(index, &task))
+        {
+            task->run();
+
+            std::lock_guard<std::mutex> lock(stateLock);
+            if (--pending == 0)
+            {
+                finished.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(stateLock);
+        while (queued == 0 && !stopping)
+        {
+            wakeUp.wait(lock);
+        }
+        if (stopping && queued == 0)
+        {
+            return;
+        }
+    }
+}
+
+bool ThreadPool::takeTask(int index, Task** task)
+{
+    int count = (int)workers.size();
+    for (int i = 0; i < count; i++)
+    {
+        Worker* worker = workers[(index + i) % count];
+        std::lock_guard<std::mutex> lock(worker->lock);
+        if (worker->tasks.empty())
+        {
+            continue;
+        }
+
+        // Take the newest of our own tasks, or the oldest of someone else's.
+        if (i == 0)
+        {
+            *task = worker->tasks.back();
+            worker->tasks.pop_back();
+        }
+        else
+        {
+            *task = worker->tasks.front();
+            worker->tasks.pop_front();
+        }
+
+        std::lock_guard<std::mutex> stateGuard(stateLock);
+        queued--;
+        return true;
+    }
+    return false;
+}
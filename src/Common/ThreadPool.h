@@ -0,0 +1,102 @@
+#ifndef _THREAD_POOL_H_
+#define _THREAD_POOL_H_
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A piece of work for a ThreadPool.
+ */
+class Task
+{
+public:
+    virtual ~Task() {}
+
+    /**
+     * Does the work, on one of the pool's threads.
+     */
+    virtual void run() = 0;
+};
+
+/**
+ * @brief Runs tasks on a fixed set of threads, with work stealing.
+ *
+ * Each thread has its own queue of tasks. Submitted tasks are spread over 
+ * the queues, and a thread takes the newest task from its own queue. When 
+ * its queue is empty it steals the oldest task from another thread, so 
+ * threads stay busy when tasks take very different amounts of time. Threads
+ * sleep while there is nothing to do.
+ *
+ * The pool does not own its tasks.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * Starts the threads.
+     *
+     * @param threads Number of threads, or 0 for one per core.
+     */
+    ThreadPool(int threads = 0);
+
+    /**
+     * Waits for every task to finish and stops the threads.
+     */
+    ~ThreadPool();
+
+    /**
+     * Queues a task. Tasks can be submitted from inside other tasks.
+     */
+    void submit(Task* task);
+
+    /**
+     * Waits until every task that was submitted has finished.
+     */
+    void wait();
+
+    /**
+     * Gets the number of threads.
+     */
+    int getThreadCount();
+
+private:
+    struct Worker
+    {
+        std::mutex lock;
+        std::deque<Task*> tasks;
+    };
+
+    /**
+     * Runs tasks until the pool is stopped. Runs on each thread.
+     */
+    void work(int index);
+
+    /**
+     * Takes a task from a thread's own queue, or steals one from another 
+     * thread.
+     *
+     * @return True if a task was found, false otherwise.
+     */
+    bool takeTask(int index, Task** task);
+
+    std::vector<Worker*> workers;
+    std::vector<std::thread> threads;
+
+    /* Queue to submit the next task to. */
+    unsigned int nextWorker;
+
+    /* Guards the counts below, and the stopping flag. */
+    std::mutex stateLock;
+    std::condition_variable wakeUp;
+    std::condition_variable finished;
+
+    /* Tasks in the queues, and tasks that have not finished. */
+    int queued;
+    int pending;
+    bool stopping;
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef _TRIPLE_BUFFER_H_
+#define _TRIPLE_BUFFER_H_
+
+#include <atomic>
+
+/**
+ * @brief Lock-free triple buffer, for passing data from one thread to another.
+ *
+ * The writer always has a back buffer it can fill without waiting, and the
+ * reader always has a front buffer it can read without waiting. Publishing
+ * swaps the back buffer with a middle buffer, updating swaps the middle 
+ * buffer with the front buffer. If the writer publishes faster than the
+ * reader updates, the older data in the middle buffer is dropped.
+ *
+ * Only one thread may write, and only one thread may read.
+ *
+ * @tparam T Type of each buffer.
+ */
+template<typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() : middle(1)
+    {
+        back = 0;
+        front = 2;
+    }
+
+    /**
+     * Gets the buffer that the writer fills.
+     */
+    T* getBackBuffer() { return &buffers[back]; }
+
+    /**
+     * Makes the back buffer available to the reader, and gives the writer a 
+     * new back buffer.
+     */
+    void publish()
+    {
+        back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    /**
+     * Takes the most recently published buffer as the front buffer, if one was
+     * published since the last update.
+     *
+     * @return True if the front buffer changed, false otherwise.
+     */
+    bool update()
+    {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH))
+        {
+            return false;
+        }
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+
+    /**
+     * Gets the buffer that the reader reads.
+     */
+    const T* getFrontBuffer() { return &buffers[front]; }
+
+private:
+    /* The middle index has this bit set when it holds data the reader has
+       not seen yet. */
+    static const unsigned FRESH = 0x4;
+    static const unsigned INDEX = 0x3;
+
+    T buffers[3];
+    std::atomic<unsigned> middle;
+
+    /* Only used by the writer. */
+    unsigned back;
+
+    /* Only used by the reader. */
+    unsigned front;
+};
+
+#endif
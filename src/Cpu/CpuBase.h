@@ -13,6 +13,8 @@
 class CpuBase
 {
 public:
+    virtual ~CpuBase() {}
+
     /**
      * Initializes the CPU
      */
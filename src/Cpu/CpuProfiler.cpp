@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <iomanip>
+#include <stdio.h>
+
+#include "CpuProfiler.h"
+#include "SymbolTable.h"
+#include "Z80Disassembler.h"
+
+/**
+ * Sorts indices by the cycles they took, most first.
+ */
+struct ByCycles
+{
+    const uint64_t* cycles;
+    bool operator()(int a, int b) const { return cycles[a] > cycles[b]; }
+};
+
+CpuProfiler::CpuProfiler()
+    : addressCounts(0x10000), addressCycles(0x10000)
+{
+    clear();
+}
+
+void CpuProfiler::clear()
+{
+    std::fill(opcodeCounts, opcodeCounts + OPCODE_COUNT, 0);
+    std::fill(opcodeCycles, opcodeCycles + OPCODE_COUNT, 0);
+    std::fill(addressCounts.begin(), addressCounts.end(), 0);
+    std::fill(addressCycles.begin(), addressCycles.end(), 0);
+    stack.clear();
+    stacks.clear();
+    updateStack();
+}
+
+void CpuProfiler::pushFrame(uint16_t addr)
+{
+    if (stack.size() == MAX_STACK_DEPTH)
+    {
+        stack.erase(stack.begin());
+    }
+    stack.push_back(addr);
+    updateStack();
+}
+
+void CpuProfiler::popFrame()
+{
+    // Code that returns more than it called, e.g. after changing SP, just
+    // stays at the outermost level.
+    if (!stack.empty())
+    {
+        stack.pop_back();
+        updateStack();
+    }
+}
+
+void CpuProfiler::updateStack()
+{
+    // std::map never moves its values, so the pointer stays valid.
+    stackCycles = &stacks[stack];
+}
+
+uint64_t CpuProfiler::getTotalCycles() const
+{
+    uint64_t total = 0;
+    for (int i = 0; i < OPCODE_COUNT; i++)
+    {
+        total += opcodeCycles[i];
+    }
+    return total;
+}
+
+std::string CpuProfiler::formatAddress(uint16_t addr, int bank)
+{
+    if (addr < 0x4000 || addr >= 0x8000)
+        bank = 0;
+    else if (bank < 0)
+        bank = 1;
+    char text[16];
+    snprintf(text, sizeof(text), "%02X:%04X", bank, addr);
+    return text;
+}
+
+void CpuProfiler::writeHistogram(std::ostream& out, int maxAddresses,
+                                 const SymbolTable* symbols) const
+{
+    uint64_t total = getTotalCycles();
+    double scale = total == 0 ? 0.0 : 100.0 / total;
+
+    std::vector<int> opcodes;
+    for (int i = 0; i < OPCODE_COUNT; i++)
+    {
+        if (opcodeCounts[i] != 0)
+        {
+            opcodes.push_back(i);
+        }
+    }
+    ByCycles byOpcodeCycles = { opcodeCycles };
+    std::stable_sort(opcodes.begin(), opcodes.end(), byOpcodeCycles);
+
+    out << "Opcodes by cycles:\n"
+        << "  opcode       count        cycles      %  mnemonic\n";
+    for (size_t i = 0; i < opcodes.size(); i++)
+    {
+        int op = opcodes[i];
+        const char* mnemonic = Z80Disassembler::getMnemonic(op);
+        char name[8];
+        if (op >= 0x100)
+            snprintf(name, sizeof(name), "CB %02X", op & 0xFF);
+        else
+            snprintf(name, sizeof(name), "%02X", op);
+        out << "  " << std::left << std::setw(6) << name << std::right
+            << std::setw(12) << opcodeCounts[op]
+            << std::setw(14) << opcodeCycles[op]
+            << std::setw(7) << std::fixed << std::setprecision(2)
+            << opcodeCycles[op] * scale << "  "
+            << (mnemonic != NULL ? mnemonic : "?") << "\n";
+    }
+
+    std::vector<int> addresses;
+    for (int i = 0; i < 0x10000; i++)
+    {
+        if (addressCounts[i] != 0)
+        {
+            addresses.push_back(i);
+        }
+    }
+    ByCycles byAddressCycles = { &addressCycles[0] };
+    std::stable_sort(addresses.begin(), addresses.end(), byAddressCycles);
+    if ((int)addresses.size() > maxAddresses)
+    {
+        addresses.resize(maxAddresses);
+    }
+
+    out << "\nAddresses by cycles:\n"
+        << "  address      count        cycles      %"
+        << (symbols != NULL ? "  symbol\n" : "\n");
+    for (size_t i = 0; i < addresses.size(); i++)
+    {
+        int addr = addresses[i];
+        out << "  " << formatAddress(addr)
+            << std::setw(11) << addressCounts[addr]
+            << std::setw(14) << addressCycles[addr]
+            << std::setw(7) << std::fixed << std::setprecision(2)
+            << addressCycles[addr] * scale;
+        if (symbols != NULL)
+        {
+            out << "  " << symbols->format(addr);
+        }
+        out << "\n";
+    }
+}
+
+void CpuProfiler::writeFoldedStacks(std::ostream& out,
+                                    const SymbolTable* symbols) const
+{
+    for (StackMap::const_iterator it = stacks.begin(); it != stacks.end(); ++it)
+    {
+        if (it->second == 0)
+        {
+            continue;
+        }
+        out << "root";
+        for (size_t i = 0; i < it->first.size(); i++)
+        {
+            uint16_t addr = it->first[i];
+            out << ";" << (symbols != NULL ? symbols->format(addr) : formatAddress(addr));
+        }
+        out << " " << it->second << "\n";
+    }
+}
@@ -0,0 +1,137 @@
+#ifndef _CPU_PROFILER_H_
+#define _CPU_PROFILER_H_
+
+#include <map>
+#include <ostream>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class SymbolTable;
+
+/**
+ * @brief Counts where the CPU spends its time.
+ *
+ * Executions and cycles are counted per opcode, with the CB page after the
+ * main page, and per address. CALL, RST and RET are followed to keep a guest
+ * call stack, and cycles are also counted per call stack so they can be
+ * drawn as a flame graph.
+ *
+ * Z80Cpu only reports to a profiler when it is built with GB_PROFILER.
+ *
+ * @ingroup CPU
+ */
+class CpuProfiler
+{
+public:
+    /** Number of opcodes, the 256 main ones followed by the CB page. */
+    static const int OPCODE_COUNT = 0x200;
+
+    /** Deeper call stacks lose their outermost calls. */
+    static const unsigned MAX_STACK_DEPTH = 64;
+
+    CpuProfiler();
+
+    /**
+     * Forgets everything that was counted.
+     */
+    void clear();
+
+    /**
+     * Records an instruction that was executed.
+     *
+     * @param pc Address the instruction was fetched from.
+     * @param opcode The opcode, 0x100 plus the second byte for the CB page.
+     * @param nextPC Address of the next instruction.
+     * @param cycles Number of cycles the instruction took.
+     */
+    void record(uint16_t pc, int opcode, uint16_t nextPC, int cycles)
+    {
+        opcodeCounts[opcode]++;
+        opcodeCycles[opcode] += cycles;
+        addressCounts[pc]++;
+        addressCycles[pc] += cycles;
+        *stackCycles += cycles;
+
+        switch (opcode)
+        {
+        case 0xC4: case 0xCC: case 0xCD: case 0xD4: case 0xDC:
+            if (nextPC != (uint16_t)(pc + 3))
+            {
+                pushFrame(nextPC);
+            }
+            break;
+        case 0xC7: case 0xCF: case 0xD7: case 0xDF:
+        case 0xE7: case 0xEF: case 0xF7: case 0xFF:
+            pushFrame(nextPC);
+            break;
+        case 0xC0: case 0xC8: case 0xC9: case 0xD0: case 0xD8: case 0xD9:
+            if (nextPC != (uint16_t)(pc + 1))
+            {
+                popFrame();
+            }
+            break;
+        }
+    }
+
+    uint64_t getOpcodeCount(int opcode) const { return opcodeCounts[opcode]; }
+    uint64_t getOpcodeCycles(int opcode) const { return opcodeCycles[opcode]; }
+    uint64_t getAddressCount(uint16_t pc) const { return addressCounts[pc]; }
+    uint64_t getAddressCycles(uint16_t pc) const { return addressCycles[pc]; }
+
+    /**
+     * Gets the number of cycles recorded over all instructions.
+     */
+    uint64_t getTotalCycles() const;
+
+    /**
+     * Writes the opcodes and the busiest addresses, sorted by the cycles
+     * spent on them.
+     *
+     * @param out Where to write the histogram.
+     * @param maxAddresses Number of addresses to list.
+     * @param symbols Names for the addresses, or NULL.
+     */
+    void writeHistogram(std::ostream& out, int maxAddresses = 50,
+                        const SymbolTable* symbols = NULL) const;
+
+    /**
+     * Writes the cycles spent in each call stack, one "frame;frame cycles"
+     * line per stack, which flamegraph.pl reads as is.
+     *
+     * @param symbols Names for the frames, or NULL.
+     */
+    void writeFoldedStacks(std::ostream& out,
+                           const SymbolTable* symbols = NULL) const;
+
+    /**
+     * Formats an address as bank:address, the way symbol files do.
+     *
+     * @param bank The ROM bank of addresses in 0x4000-0x7FFF. Defaults to
+     * bank 1, as there are no memory bank controllers yet.
+     */
+    static std::string formatAddress(uint16_t addr, int bank = -1);
+
+private:
+    typedef std::map<std::vector<uint16_t>, uint64_t> StackMap;
+
+    void pushFrame(uint16_t addr);
+    void popFrame();
+
+    /**
+     * Points stackCycles at the counter for the current call stack.
+     */
+    void updateStack();
+
+    uint64_t opcodeCounts[OPCODE_COUNT];
+    uint64_t opcodeCycles[OPCODE_COUNT];
+    std::vector<uint64_t> addressCounts;
+    std::vector<uint64_t> addressCycles;
+
+    /* Entry addresses of the current calls, outermost first. */
+    std::vector<uint16_t> stack;
+    StackMap stacks;
+    uint64_t* stackCycles;
+};
+
+#endif
@@ -0,0 +1,233 @@
+#include <algorithm>
+#include <fcntl.h>
+#include <fstream>
+#include <string.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+#include "CpuTrace.h"
+
+#define MAGIC "GBTRACE"
+#define HEADER_SIZE 24
+
+// Entries are written this many at a time.
+#define WRITE_BATCH 64
+
+static void put16(data_t* out, uint16_t value)
+{
+    out[0] = value & 0xFF;
+    out[1] = value >> 8;
+}
+
+static void put32(data_t* out, uint32_t value)
+{
+    put16(out, value & 0xFFFF);
+    put16(out + 2, value >> 16);
+}
+
+static void put64(data_t* out, uint64_t value)
+{
+    put32(out, value & 0xFFFFFFFF);
+    put32(out + 4, value >> 32);
+}
+
+static uint16_t get16(const data_t* in)
+{
+    return in[0] | (in[1] << 8);
+}
+
+static uint32_t get32(const data_t* in)
+{
+    return get16(in) | ((uint32_t)get16(in + 2) << 16);
+}
+
+static uint64_t get64(const data_t* in)
+{
+    return get32(in) | ((uint64_t)get32(in + 4) << 32);
+}
+
+static void encodeEntry(const TraceEntry& entry, data_t* out)
+{
+    put64(out, entry.cycle);
+    put16(out + 8, entry.pc);
+    put16(out + 10, entry.sp);
+    put16(out + 12, entry.af);
+    put16(out + 14, entry.bc);
+    put16(out + 16, entry.de);
+    put16(out + 18, entry.hl);
+    memcpy(out + 20, entry.bytes, 3);
+    out[23] = 0;
+}
+
+static void decodeEntry(const data_t* in, TraceEntry* entry)
+{
+    entry->cycle = get64(in);
+    entry->pc = get16(in + 8);
+    entry->sp = get16(in + 10);
+    entry->af = get16(in + 12);
+    entry->bc = get16(in + 14);
+    entry->de = get16(in + 16);
+    entry->hl = get16(in + 18);
+    memcpy(entry->bytes, in + 20, 3);
+    entry->reserved = 0;
+}
+
+/**
+ * Writes all of a buffer, carrying on after partial writes.
+ */
+static bool writeAll(int fd, const data_t* data, size_t size)
+{
+    while (size > 0)
+    {
+        int written = (int)::write(fd, data, (unsigned)size);
+        if (written <= 0)
+        {
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+CpuTrace::CpuTrace(size_t size)
+{
+    size_t capacity = 1;
+    while (capacity < size)
+    {
+        capacity <<= 1;
+    }
+    entries.resize(capacity);
+    mask = capacity - 1;
+    head = 0;
+    cycle = 0;
+    requestedFile = NULL;
+}
+
+uint64_t CpuTrace::copy(std::vector<TraceEntry>* copied) const
+{
+    uint64_t end = head.load(std::memory_order_acquire);
+    uint64_t start = end > entries.size() ? end - entries.size() : 0;
+    copied->clear();
+    for (uint64_t i = start; i < end; i++)
+    {
+        copied->push_back(entries[i & mask]);
+    }
+
+    // Entries the CPU wrote over while they were copied are left out.
+    uint64_t now = head.load(std::memory_order_acquire);
+    uint64_t overwritten = now > entries.size() ? now - entries.size() : 0;
+    if (overwritten > start)
+    {
+        size_t lost = (size_t)std::min<uint64_t>(overwritten - start, copied->size());
+        copied->erase(copied->begin(), copied->begin() + lost);
+        start += lost;
+    }
+    return start;
+}
+
+bool CpuTrace::write(int fd) const
+{
+    uint64_t end = head.load(std::memory_order_acquire);
+    uint64_t start = end > entries.size() ? end - entries.size() : 0;
+
+    data_t header[HEADER_SIZE];
+    memcpy(header, MAGIC, 8);
+    put32(header + 8, VERSION);
+    put32(header + 12, (uint32_t)(end - start));
+    put64(header + 16, start);
+    if (!writeAll(fd, header, sizeof(header)))
+    {
+        return false;
+    }
+
+    data_t batch[WRITE_BATCH * ENTRY_SIZE];
+    uint64_t i = start;
+    while (i < end)
+    {
+        int count = 0;
+        for (; count < WRITE_BATCH && i < end; count++, i++)
+        {
+            encodeEntry(entries[i & mask], batch + count * ENTRY_SIZE);
+        }
+        if (!writeAll(fd, batch, count * ENTRY_SIZE))
+        {
+            return false;
+        }
+    }
+
+    // As in copy(), entries the CPU wrote over while they were written make
+    // the file wrong. The header is already out, so the write fails instead.
+    uint64_t now = head.load(std::memory_order_acquire);
+    uint64_t overwritten = now > entries.size() ? now - entries.size() : 0;
+    return overwritten <= start;
+}
+
+void CpuTrace::saveRequested()
+{
+    const char* fileName = requestedFile.exchange(NULL, 
+                                                  std::memory_order_acquire);
+    if (fileName != NULL)
+    {
+        save(fileName);
+    }
+}
+
+bool CpuTrace::save(const char* fileName) const
+{
+    int fd = open(fileName, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0644);
+    if (fd < 0)
+    {
+        return false;
+    }
+    bool written = write(fd);
+    return close(fd) == 0 && written;
+}
+
+bool CpuTrace::load(const std::string& fileName,
+                    std::vector<TraceEntry>* loaded, uint64_t* first,
+                    std::string* error)
+{
+    std::ifstream in(fileName.c_str(), std::ios::binary);
+    if (!in.is_open())
+    {
+        *error = "Could not open " + fileName + ".";
+        return false;
+    }
+
+    data_t header[HEADER_SIZE];
+    if (!in.read((char*)header, sizeof(header)) ||
+        memcmp(header, MAGIC, 8) != 0)
+    {
+        *error = fileName + " is not a trace.";
+        return false;
+    }
+    if (get32(header + 8) != VERSION)
+    {
+        *error = fileName + " is from a different version of the trace.";
+        return false;
+    }
+    uint32_t count = get32(header + 12);
+    *first = get64(header + 16);
+
+    loaded->resize(count);
+    data_t entry[ENTRY_SIZE];
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (!in.read((char*)entry, sizeof(entry)))
+        {
+            *error = fileName + " ends part way through the trace.";
+            return false;
+        }
+        decodeEntry(entry, &(*loaded)[i]);
+    }
+    return true;
+}
@@ -0,0 +1,166 @@
+#ifndef _CPU_TRACE_H_
+#define _CPU_TRACE_H_
+
+#include <atomic>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "../Memory/MemoryDefs.h"
+#include "Z80.h"
+
+/**
+ * One instruction in a trace, with the registers from before it ran.
+ */
+struct TraceEntry
+{
+    uint64_t cycle;     //!< Cycles run by the CPU before the instruction.
+    uint16_t pc;
+    uint16_t sp;
+    uint16_t af;
+    uint16_t bc;
+    uint16_t de;
+    uint16_t hl;
+    data_t bytes[3];    //!< The opcode and the two bytes after it.
+    data_t reserved;
+};
+
+/**
+ * @brief Remembers the last instructions the CPU ran.
+ *
+ * Entries are kept in a ring buffer with a power of two size, so recording
+ * one is a few stores and no allocation. Only the CPU's thread records. Any
+ * thread may take a copy of the trace, which is done without locking: the
+ * copy leaves out entries that were overwritten while it was made. Writing
+ * the trace to a file is only consistent from the CPU's thread, or while
+ * the CPU is stopped; other threads and signal handlers use requestSave().
+ *
+ * A trace is saved as an 8 byte "GBTRACE" magic, a 32 bit version, a 32 bit
+ * entry count and the 64 bit number of instructions before the first entry,
+ * then the entries oldest first. Every field is little endian, and entries
+ * are laid out like TraceEntry, 24 bytes each. gameboy-trace decodes it.
+ *
+ * Z80Cpu only records to a trace when it is built with GB_TRACE.
+ *
+ * @ingroup CPU
+ */
+class CpuTrace
+{
+public:
+    static const uint32_t VERSION = 1;
+    static const int ENTRY_SIZE = 24;
+
+    /**
+     * @param size The number of instructions to keep, rounded up to a power
+     * of two.
+     */
+    CpuTrace(size_t size = 65536);
+
+    /**
+     * Sets the cycle the CPU is at, which later entries count on from.
+     */
+    void setCycle(uint64_t cycle) { this->cycle = cycle; }
+
+    /**
+     * Records an instruction that is about to run. Its cycle is filled in by
+     * end().
+     *
+     * @param registers The registers before the instruction runs.
+     * @return The entry, for the caller to fill in the instruction bytes.
+     */
+    TraceEntry* begin(const Z80Registers& registers)
+    {
+        uint64_t index = head.load(std::memory_order_relaxed);
+        TraceEntry* entry = &entries[index & mask];
+        entry->cycle = cycle;
+        entry->pc = registers.PC.val;
+        entry->sp = registers.SP.val;
+        entry->af = registers.AF.val;
+        entry->bc = registers.BC.val;
+        entry->de = registers.DE.val;
+        entry->hl = registers.HL.val;
+        return entry;
+    }
+
+    /**
+     * Finishes recording the instruction begin() was called for.
+     *
+     * @param cycles Number of cycles the instruction took.
+     */
+    void end(int cycles)
+    {
+        cycle += cycles;
+        head.store(head.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_release);
+        if (requestedFile.load(std::memory_order_relaxed) != NULL)
+        {
+            saveRequested();
+        }
+    }
+
+    /**
+     * Asks for the trace to be saved by the CPU's thread after the next
+     * instruction it records. Only an atomic store, so it can be used from a
+     * signal handler.
+     *
+     * @param fileName The file to save to, which must outlive the request.
+     */
+    void requestSave(const char* fileName)
+    {
+        requestedFile.store(fileName, std::memory_order_release);
+    }
+
+    /**
+     * Gets the number of instructions recorded since the trace was made.
+     */
+    uint64_t getCount() const { return head.load(std::memory_order_acquire); }
+
+    /**
+     * Copies the entries that are still in the buffer, oldest first.
+     *
+     * @param entries Set to the entries.
+     * @return The number of instructions before the first entry.
+     */
+    uint64_t copy(std::vector<TraceEntry>* entries) const;
+
+    /**
+     * Writes the trace to a file descriptor. It does not allocate, so it
+     * can be used from a signal handler, e.g. after a crash.
+     *
+     * @return false if it could not all be written, or if the CPU wrote over
+     * entries while they were being written.
+     */
+    bool write(int fd) const;
+
+    /**
+     * Writes the trace to a file, replacing it.
+     */
+    bool save(const char* fileName) const;
+
+    /**
+     * Reads a trace saved by save().
+     *
+     * @param fileName The file to read.
+     * @param entries Set to the entries in the file, oldest first.
+     * @param first Set to the number of instructions before the first entry.
+     * @param error Set to what went wrong if the file could not be read.
+     * @return true if the file was read.
+     */
+    static bool load(const std::string& fileName,
+                     std::vector<TraceEntry>* entries, uint64_t* first,
+                     std::string* error);
+
+private:
+    /**
+     * Saves the trace to the file requestSave() was given.
+     */
+    void saveRequested();
+
+    std::vector<TraceEntry> entries;
+    uint64_t mask;
+    std::atomic<uint64_t> head;
+    uint64_t cycle;
+    std::atomic<const char*> requestedFile;
+};
+
+#endif
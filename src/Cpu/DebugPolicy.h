@@ -0,0 +1,31 @@
+#ifndef _DEBUG_POLICY_H_
+#define _DEBUG_POLICY_H_
+
+#include <stdint.h>
+
+/**
+ * @brief The debug policy for running without a debugger.
+ *
+ * Z80Cpu::stepWith() and GBMachine::runUntilWith() take a debug policy as a
+ * template parameter, and call it around every instruction. A policy has
+ * the same members as this one:
+ *
+ * - beforeInstruction(pc) is called before the instruction at pc runs, and
+ *   returns true to stop without running it.
+ * - afterInstruction() is called once it has run.
+ * - isStopped() says whether the machine should stop running.
+ *
+ * Everything here does nothing, so once inlined the checks disappear, and
+ * the plain step() and runUntil() stay as fast as they were. Debugger is
+ * the policy with breakpoints and watchpoints.
+ *
+ * @ingroup CPU
+ */
+struct NoDebugPolicy
+{
+    bool beforeInstruction(uint16_t) { return false; }
+    void afterInstruction() {}
+    bool isStopped() const { return false; }
+};
+
+#endif
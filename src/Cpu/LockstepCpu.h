@@ -0,0 +1,585 @@
+#ifndef _LOCKSTEP_CPU_H_
+#define _LOCKSTEP_CPU_H_
+
+#include <stdint.h>
+
+#include "../Memory/Memory.h"
+#include "../Memory/Customizers/IOMemory.h"
+#include "Z80.h"
+#include "Z80Cpu.h"
+
+/**
+ * @brief Experimental CPU that steps several Game Boys in lockstep.
+ *
+ * Running many copies of the same ROM mostly runs the same instructions on
+ * different data. The registers of every lane are kept as a structure of
+ * arrays, so an instruction is executed for all lanes by a loop over the
+ * lanes without any branches, which the compiler turns into SIMD code. Each
+ * lane still has its own memory, and memory accesses are made lane by lane.
+ *
+ * Every step runs one instruction in each lane. The lanes that fetched the
+ * same opcode as most of the others are stepped together, the others are
+ * masked out and stepped by a scalar Z80Cpu of their own. A lane that keeps
+ * running different code from the others for DIVERGENCE_LIMIT steps drops
+ * back to its scalar Z80Cpu for good.
+ *
+ * Only the common register loads, 8-bit arithmetic and jumps are run in
+ * lockstep, everything else goes through the scalar CPU, so every lane
+ * behaves exactly the same as a Z80Cpu would. Interrupts are not handled, the
+ * same as Z80Cpu.
+ *
+ * @tparam Lanes Number of Game Boys to step together.
+ *
+ * @ingroup CPU
+ */
+template<int Lanes>
+class LockstepCpu
+{
+public:
+    /**
+     * Number of steps in a row a lane can run different code from the others
+     * before it drops back to the scalar CPU.
+     */
+    static const int DIVERGENCE_LIMIT = 256;
+
+    /**
+     * Creates the CPU.
+     *
+     * @param memories The memory of every lane.
+     */
+    LockstepCpu(Memory* const* memories)
+    {
+        for (int l = 0; l < Lanes; l++)
+        {
+            memory[l] = memories[l];
+            ioMemory[l] = memories[l]->getIOMemory();
+            cpu[l] = new Z80Cpu(memories[l]);
+            cycles[l] = 0;
+            divergence[l] = 0;
+            detached[l] = false;
+        }
+        lockstepCount = 0;
+        scalarCount = 0;
+    }
+
+    ~LockstepCpu()
+    {
+        for (int l = 0; l < Lanes; l++)
+        {
+            delete cpu[l];
+        }
+    }
+
+    /**
+     * Initializes the CPU of every lane.
+     */
+    void init()
+    {
+        for (int l = 0; l < Lanes; l++)
+        {
+            cpu[l]->init();
+            loadLane(l);
+        }
+    }
+
+    /**
+     * Executes a single instruction in every lane.
+     */
+    void step()
+    {
+        // Each lane fetches from its own memory.
+        for (int l = 0; l < Lanes; l++)
+        {
+            opcode[l] = detached[l] ? 0 : memory[l]->read(pc[l]);
+        }
+
+        int leader = findLeader();
+        for (int l = 0; l < Lanes; l++)
+        {
+            bool same = !detached[l] && opcode[l] == leader;
+            active[l] = same ? 0xFF : 0;
+            divergence[l] = same ? 0 : divergence[l] + 1;
+        }
+        if (leader < 0 || !execute((uint8_t)leader))
+        {
+            for (int l = 0; l < Lanes; l++)
+            {
+                active[l] = 0;
+            }
+        }
+
+        for (int l = 0; l < Lanes; l++)
+        {
+            if (active[l])
+            {
+                advanceTimer(l, stepTime[l]);
+                cycles[l] += stepTime[l];
+                lockstepCount++;
+            }
+            else if (detached[l])
+            {
+                cycles[l] += cpu[l]->step();
+                scalarCount++;
+            }
+            else
+            {
+                storeLane(l);
+                cycles[l] += cpu[l]->step();
+                scalarCount++;
+                if (divergence[l] >= DIVERGENCE_LIMIT)
+                {
+                    detached[l] = true;
+                }
+                else
+                {
+                    loadLane(l);
+                }
+            }
+        }
+    }
+
+    /**
+     * Gets the registers of a lane.
+     */
+    Z80Registers getRegisters(int lane)
+    {
+        if (!detached[lane])
+        {
+            storeLane(lane);
+        }
+        return *cpu[lane]->GetRegisters();
+    }
+
+    /**
+     * Gets the number of cycles a lane has run for.
+     */
+    uint64_t getCycle(int lane) const
+    {
+        return cycles[lane];
+    }
+
+    /**
+     * Checks if a lane has dropped back to the scalar CPU for good.
+     */
+    bool isDetached(int lane) const
+    {
+        return detached[lane];
+    }
+
+    /**
+     * Gets the number of instructions that were run in lockstep, summed over
+     * all lanes.
+     */
+    uint64_t getLockstepCount() const
+    {
+        return lockstepCount;
+    }
+
+    /**
+     * Gets the number of instructions that were run by the scalar CPUs,
+     * summed over all lanes.
+     */
+    uint64_t getScalarCount() const
+    {
+        return scalarCount;
+    }
+
+private:
+    /** Register indices, in the order the opcodes encode them. (HL) has no
+     *  register, so F is kept in its place. */
+    enum { REG_B, REG_C, REG_D, REG_E, REG_H, REG_L, REG_F, REG_A, REG_COUNT };
+
+    static const uint16_t TMA_ADDR = 0xFF06;
+    static const uint16_t IF_ADDR = 0xFF0F;
+    static const uint8_t TIMER_REQUEST = 0x40;
+
+    /**
+     * Finds the opcode fetched by the most lanes, using a majority vote.
+     *
+     * @return The opcode, or -1 if every lane has been detached.
+     */
+    int findLeader()
+    {
+        int leader = -1;
+        int count = 0;
+        for (int l = 0; l < Lanes; l++)
+        {
+            if (detached[l])
+            {
+                continue;
+            }
+            if (count == 0)
+            {
+                leader = opcode[l];
+                count = 1;
+            }
+            else
+            {
+                count += (opcode[l] == leader) ? 1 : -1;
+            }
+        }
+        return leader;
+    }
+
+    /**
+     * Checks if an opcode can be run in lockstep. Opcodes that the scalar CPU
+     * treats differently from the rest of their row, such as LD E, A and
+     * JR C, are left to it.
+     */
+    static bool isLockstepOpcode(uint8_t op)
+    {
+        int x = op >> 6;
+        int y = (op >> 3) & 7;
+        int z = op & 7;
+        switch (x)
+        {
+        case 0:
+            if (op == 0x00 || op == 0x18 || op == 0x20 || op == 0x28 ||
+                op == 0x30)
+            {
+                return true;
+            }
+            return y != 6 && (z == 4 || z == 5 || z == 6);
+        case 1:
+            return y != 6 && z != 6 && op != 0x5F;
+        case 2:
+            return z != 6;
+        default:
+            return z == 6 || op == 0xC2 || op == 0xC3 || op == 0xCA ||
+                   op == 0xD2;
+        }
+    }
+
+    /**
+     * Executes an opcode for every active lane.
+     *
+     * @return True if the opcode was run, false if it has to be run by the
+     *     scalar CPU.
+     */
+    bool execute(uint8_t op)
+    {
+        if (!isLockstepOpcode(op))
+        {
+            return false;
+        }
+
+        for (int l = 0; l < Lanes; l++)
+        {
+            pc[l] += active[l] & 1;
+        }
+
+        int y = (op >> 3) & 7;
+        int z = op & 7;
+        switch (op >> 6)
+        {
+        case 0:
+            if (op == 0x00)
+            {
+                setStepTime(4);
+            }
+            else if (op == 0x18)
+            {
+                relativeJump(0x00, 0x00);
+            }
+            else if (op == 0x20 || op == 0x28)
+            {
+                relativeJump(0x80, op == 0x28 ? 0x80 : 0x00);
+            }
+            else if (op == 0x30)
+            {
+                relativeJump(0x10, 0x00);
+            }
+            else if (z == 4)
+            {
+                incReg(regs[y]);
+            }
+            else if (z == 5)
+            {
+                decReg(regs[y]);
+            }
+            else
+            {
+                readImmediate();
+                loadReg(imm, regs[y]);
+                setStepTime(8);
+            }
+            break;
+        case 1:
+            loadReg(regs[z], regs[y]);
+            setStepTime(4);
+            break;
+        case 2:
+            alu(y, regs[z]);
+            setStepTime(4);
+            break;
+        default:
+            if (op == 0xC3)
+            {
+                jump(0x00, 0x00);
+            }
+            else if (op == 0xC2 || op == 0xCA)
+            {
+                jump(0x80, op == 0xCA ? 0x80 : 0x00);
+            }
+            else if (op == 0xD2)
+            {
+                jump(0x10, 0x00);
+            }
+            else
+            {
+                readImmediate();
+                alu(y, imm);
+                setStepTime(8);
+            }
+            break;
+        }
+        return true;
+    }
+
+    void setStepTime(uint8_t time)
+    {
+        for (int l = 0; l < Lanes; l++)
+        {
+            stepTime[l] = time;
+        }
+    }
+
+    /**
+     * Reads the byte at PC for every active lane, and moves past it.
+     */
+    void readImmediate()
+    {
+        for (int l = 0; l < Lanes; l++)
+        {
+            if (active[l])
+            {
+                imm[l] = memory[l]->read(pc[l]++);
+            }
+        }
+    }
+
+    void loadReg(const uint8_t* src, uint8_t* dest)
+    {
+        for (int l = 0; l < Lanes; l++)
+        {
+            dest[l] = (dest[l] & ~active[l]) | (src[l] & active[l]);
+        }
+    }
+
+    /**
+     * Sets the flags of the active lanes, keeping the bits in keep.
+     */
+    void setFlags(const uint8_t* flags, uint8_t keep)
+    {
+        uint8_t* f = regs[REG_F];
+        for (int l = 0; l < Lanes; l++)
+        {
+            uint8_t value = (f[l] & keep) | flags[l];
+            f[l] = (f[l] & ~active[l]) | (value & active[l]);
+        }
+    }
+
+    void incReg(uint8_t* reg)
+    {
+        for (int l = 0; l < Lanes; l++)
+        {
+            uint8_t result = reg[l] + 1;
+            flags[l] = ((result == 0) << 7) | (((reg[l] & 0xF) == 0xF) << 5);
+            reg[l] = (reg[l] & ~active[l]) | (result & active[l]);
+        }
+        setFlags(flags, 0x1F);
+        setStepTime(4);
+    }
+
+    void decReg(uint8_t* reg)
+    {
+        for (int l = 0; l < Lanes; l++)
+        {
+            uint8_t result = reg[l] - 1;
+            flags[l] = ((result == 0) << 7) | 0x40 |
+                       (((reg[l] & 0xF) == 0) << 5);
+            reg[l] = (reg[l] & ~active[l]) | (result & active[l]);
+        }
+        setFlags(flags, 0x1F);
+        setStepTime(4);
+    }
+
+    /**
+     * Runs one of the eight accumulator operations, in opcode order: ADD,
+     * ADC, SUB, SBC, AND, XOR, OR and CP.
+     */
+    void alu(int operation, const uint8_t* src)
+    {
+        uint8_t* a = regs[REG_A];
+        const uint8_t* f = regs[REG_F];
+        for (int l = 0; l < Lanes; l++)
+        {
+            // Like the scalar CPU, the carry is added to the operand as a
+            // byte.
+            uint8_t carry = (operation == 1 || operation == 3) ?
+                            (f[l] >> 4) & 1 : 0;
+            uint8_t op2 = src[l] + carry;
+            int result;
+            switch (operation)
+            {
+            case 0:
+            case 1:
+                result = a[l] + op2;
+                flags[l] = (((result & 0xFF) == 0) << 7) |
+                           (((a[l] & 0xF) + (op2 & 0xF) > 0xF) << 5) |
+                           ((result > 0xFF) << 4);
+                break;
+            case 4:
+                result = a[l] & op2;
+                flags[l] = ((result == 0) << 7) | 0x20;
+                break;
+            case 5:
+                result = a[l] ^ op2;
+                flags[l] = (result == 0) << 7;
+                break;
+            case 6:
+                result = a[l] | op2;
+                flags[l] = (result == 0) << 7;
+                break;
+            default:
+                result = a[l] - op2;
+                flags[l] = (((result & 0xFF) == 0) << 7) | 0x40 |
+                           (((a[l] & 0xF) < (op2 & 0xF)) << 5) |
+                           ((result < 0) << 4);
+                break;
+            }
+            if (operation != 7)
+            {
+                a[l] = (a[l] & ~active[l]) | ((uint8_t)result & active[l]);
+            }
+        }
+        setFlags(flags, 0x0F);
+    }
+
+    /**
+     * Checks the jump condition of every active lane. The condition is met
+     * when the flags under mask equal value, a mask of 0 always jumps.
+     */
+    void checkCondition(uint8_t mask, uint8_t value)
+    {
+        const uint8_t* f = regs[REG_F];
+        for (int l = 0; l < Lanes; l++)
+        {
+            taken[l] = active[l] & ((f[l] & mask) == value ? 0xFF : 0);
+        }
+    }
+
+    void relativeJump(uint8_t mask, uint8_t value)
+    {
+        checkCondition(mask, value);
+        for (int l = 0; l < Lanes; l++)
+        {
+            if (taken[l])
+            {
+                int8_t offset = (int8_t)memory[l]->read(pc[l]++);
+                pc[l] += offset;
+                stepTime[l] = 12;
+            }
+            else
+            {
+                pc[l] += active[l] & 1;
+                stepTime[l] = 8;
+            }
+        }
+    }
+
+    void jump(uint8_t mask, uint8_t value)
+    {
+        checkCondition(mask, value);
+        for (int l = 0; l < Lanes; l++)
+        {
+            if (taken[l])
+            {
+                uint8_t low = memory[l]->read(pc[l]++);
+                uint8_t high = memory[l]->read(pc[l]++);
+                pc[l] = (high << 8) | low;
+                stepTime[l] = 16;
+            }
+            else
+            {
+                pc[l] += active[l] & 2;
+                stepTime[l] = 12;
+            }
+        }
+    }
+
+    /**
+     * Advances the timer of a lane the same way Z80Cpu does.
+     */
+    void advanceTimer(int lane, int time)
+    {
+        int timer = ioMemory[lane]->TIMA + time;
+        if (timer > 0xFF)
+        {
+            timer = memory[lane]->read(TMA_ADDR);
+            memory[lane]->write(IF_ADDR, TIMER_REQUEST);
+        }
+        ioMemory[lane]->TIMA = timer;
+    }
+
+    /**
+     * Copies the registers of a lane into its scalar CPU.
+     */
+    void storeLane(int lane)
+    {
+        Z80Registers* r = cpu[lane]->GetRegisters();
+        r->BC.hi = regs[REG_B][lane];
+        r->BC.lo = regs[REG_C][lane];
+        r->DE.hi = regs[REG_D][lane];
+        r->DE.lo = regs[REG_E][lane];
+        r->HL.hi = regs[REG_H][lane];
+        r->HL.lo = regs[REG_L][lane];
+        r->AF.hi = regs[REG_A][lane];
+        r->AF.lo = regs[REG_F][lane];
+        r->PC.val = pc[lane];
+        r->SP.val = sp[lane];
+    }
+
+    /**
+     * Copies the registers of a lane back from its scalar CPU.
+     */
+    void loadLane(int lane)
+    {
+        Z80Registers* r = cpu[lane]->GetRegisters();
+        regs[REG_B][lane] = r->BC.hi;
+        regs[REG_C][lane] = r->BC.lo;
+        regs[REG_D][lane] = r->DE.hi;
+        regs[REG_E][lane] = r->DE.lo;
+        regs[REG_H][lane] = r->HL.hi;
+        regs[REG_L][lane] = r->HL.lo;
+        regs[REG_A][lane] = r->AF.hi;
+        regs[REG_F][lane] = r->AF.lo;
+        pc[lane] = r->PC.val;
+        sp[lane] = r->SP.val;
+    }
+
+    /* Registers, as a structure of arrays. */
+    uint8_t regs[REG_COUNT][Lanes];
+    uint16_t pc[Lanes];
+    uint16_t sp[Lanes];
+
+    /* Scratch space for the current step. */
+    uint8_t opcode[Lanes];
+    uint8_t active[Lanes];
+    uint8_t taken[Lanes];
+    uint8_t imm[Lanes];
+    uint8_t flags[Lanes];
+    uint8_t stepTime[Lanes];
+
+    Memory* memory[Lanes];
+    IOMemory* ioMemory[Lanes];
+    Z80Cpu* cpu[Lanes];
+    uint64_t cycles[Lanes];
+    int divergence[Lanes];
+    bool detached[Lanes];
+
+    uint64_t lockstepCount;
+    uint64_t scalarCount;
+};
+
+#endif
@@ -0,0 +1,135 @@
+#include <fstream>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "CpuProfiler.h"
+#include "SymbolTable.h"
+
+// Furthest an address is formatted from its symbol, beyond that it is more
+// likely to belong to something without a name.
+#define MAX_SYMBOL_OFFSET 0x1000
+
+/**
+ * Gets the start of the part of the memory map an address is in, split the
+ * same way RGBDS sections are: ROM0, ROMX, VRAM, SRAM, WRAM0, WRAMX, echo
+ * RAM, OAM, unusable, I/O, HRAM and IE. A symbol only names addresses in its
+ * own part.
+ */
+static uint16_t getRegion(uint16_t addr)
+{
+    static const uint16_t starts[] =
+    {
+        0xFFFF, 0xFF80, 0xFF00, 0xFEA0, 0xFE00, 0xE000, 0xD000, 0xC000,
+        0xA000, 0x8000, 0x4000, 0x0000
+    };
+    for (size_t i = 0; i < sizeof(starts) / sizeof(starts[0]); i++)
+    {
+        if (addr >= starts[i])
+        {
+            return starts[i];
+        }
+    }
+    return 0;
+}
+
+bool SymbolTable::load(const std::string& fileName)
+{
+    std::ifstream file(fileName.c_str());
+    if (!file.is_open())
+    {
+        error = "Could not open " + fileName + ".";
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        lineNumber++;
+        size_t comment = line.find(';');
+        if (comment != std::string::npos)
+        {
+            line.erase(comment);
+        }
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos)
+        {
+            continue;
+        }
+
+        const char* text = line.c_str() + start;
+        char* end;
+        unsigned long bank = strtoul(text, &end, 16);
+        unsigned long addr = 0;
+        bool valid = *end == ':';
+        if (valid)
+        {
+            addr = strtoul(end + 1, &end, 16);
+            valid = addr <= 0xFFFF && (*end == ' ' || *end == '\t');
+        }
+        size_t nameStart = valid ? line.find_first_not_of(" \t", end - line.c_str())
+                                 : std::string::npos;
+        if (nameStart == std::string::npos)
+        {
+            char number[16];
+            snprintf(number, sizeof(number), "%d", lineNumber);
+            error = fileName + ":" + number + ": expected \"bank:address name\".";
+            return false;
+        }
+        size_t nameEnd = line.find_first_of(" \t\r", nameStart);
+        add((int)bank, (uint16_t)addr, line.substr(nameStart, nameEnd - nameStart));
+    }
+    return true;
+}
+
+void SymbolTable::add(int bank, uint16_t addr, const std::string& name)
+{
+    symbols.insert(std::make_pair(getKey(addr, bank), name));
+}
+
+const char* SymbolTable::getName(uint16_t addr, int bank) const
+{
+    std::map<uint32_t, std::string>::const_iterator it =
+        symbols.find(getKey(addr, bank));
+    return it == symbols.end() ? NULL : it->second.c_str();
+}
+
+std::string SymbolTable::format(uint16_t addr, int bank) const
+{
+    uint32_t key = getKey(addr, bank);
+    std::map<uint32_t, std::string>::const_iterator it = symbols.upper_bound(key);
+    if (it != symbols.begin())
+    {
+        --it;
+        // The symbol has to be in the same bank and part of the memory map,
+        // and not too far away.
+        uint32_t offset = key - it->first;
+        if ((it->first >> 16) == (key >> 16) &&
+            getRegion(it->first & 0xFFFF) == getRegion(addr) &&
+            offset < MAX_SYMBOL_OFFSET)
+        {
+            if (offset == 0)
+            {
+                return it->second;
+            }
+            char text[16];
+            snprintf(text, sizeof(text), "+$%X", offset);
+            return it->second + text;
+        }
+    }
+    return CpuProfiler::formatAddress(addr, bank);
+}
+
+std::string SymbolTable::getErrorMessage()
+{
+    return error;
+}
+
+uint32_t SymbolTable::getKey(uint16_t addr, int bank)
+{
+    if (addr < 0x4000 || addr >= 0x8000)
+    {
+        return addr;
+    }
+    return ((uint32_t)(bank < 0 ? 1 : bank) << 16) | addr;
+}
@@ -0,0 +1,69 @@
+#ifndef _SYMBOL_TABLE_H_
+#define _SYMBOL_TABLE_H_
+
+#include <map>
+#include <stdint.h>
+#include <string>
+
+/**
+ * @brief Names of addresses, as loaded from an RGBDS .sym file.
+ *
+ * Symbol files have one "bank:address name" line per label, such as
+ * "01:4000 LoadLevel", and comments after a ';'. Banks only tell addresses
+ * in 0x4000-0x7FFF apart, as there is no RAM banking. Wherever the bank of
+ * such an address is not known, it is taken to be bank 1, the same as
+ * CpuProfiler::formatAddress() does.
+ *
+ * @ingroup CPU
+ */
+class SymbolTable
+{
+public:
+    /**
+     * Adds the symbols in a .sym file to the table.
+     *
+     * @return false if the file could not be read, see getErrorMessage().
+     */
+    bool load(const std::string& fileName);
+
+    /**
+     * Names an address. An address with several names keeps the first.
+     *
+     * @param bank The ROM bank, for addresses in 0x4000-0x7FFF.
+     */
+    void add(int bank, uint16_t addr, const std::string& name);
+
+    /**
+     * Gets the name of an address.
+     *
+     * @param bank The ROM bank, or -1 if it is not known.
+     * @return The name, or NULL if the address has none.
+     */
+    const char* getName(uint16_t addr, int bank = -1) const;
+
+    /**
+     * Formats an address as the closest symbol at or before it in the same
+     * bank and the same part of the memory map, e.g. "LoadLevel+$1A". 
+     * Addresses without such a symbol within 4KB are formatted as 
+     * bank:address.
+     *
+     * @param bank The ROM bank, or -1 if it is not known.
+     */
+    std::string format(uint16_t addr, int bank = -1) const;
+
+    size_t size() const { return symbols.size(); }
+
+    std::string getErrorMessage();
+
+private:
+    /**
+     * Gets the key of an address, its bank above the address. Addresses
+     * outside the switchable ROM bank are all in bank 0.
+     */
+    static uint32_t getKey(uint16_t addr, int bank);
+
+    std::map<uint32_t, std::string> symbols;
+    std::string error;
+};
+
+#endif
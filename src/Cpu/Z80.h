@@ -21,7 +21,7 @@ union RegisterPair
      * @param high Upper 8-bits of the RegisterPair.
      * @param low Lower 8-bits of the RegisterPair.
      */
-    RegisterPair(uint8_t high, uint8_t low) { hi = high; lo = low; }
+    RegisterPair(uint8_t high, uint8_t low) { val = (high << 8) | low; }
     
     /**
      * Creates a RegisterPair with the specifed value.
@@ -1,5 +1,6 @@
 #include "../Common/Config.h"
 #include "Z80Cpu.h"
+#include "Z80Disassembler.h"
 
 #define TMA_ADDR 0xFF06
 #define IF_ADDR 0xFF0F
@@ -11,6 +12,10 @@ Z80Cpu::Z80Cpu(Memory* mem)
     memory = mem;
     ioMemory = memory->getIOMemory();
     flags = registers.getFlags();
+    intMasterEnable = false;
+    profiler = NULL;
+    cbOpcode = 0;
+    trace = NULL;
 };
 
 
@@ -97,6 +102,23 @@ int Z80Cpu::checkForInterrupts()
 int Z80Cpu::step()
 {
     int stepTime = 0; 
+#ifdef GB_PROFILER
+    uint16_t pc = registers.PC.val;
+#endif
+#ifdef GB_TRACE
+    if (trace != NULL)
+    {
+        // Peeked, so bytes the program never reads stay unread for
+        // watchpoints and metrics.
+        TraceEntry *entry = trace->begin(registers);
+        entry->bytes[0] = memory->peek(registers.PC.val);
+        int length = Z80Disassembler::getLength(entry->bytes[0]);
+        for (int i = 1; i < 3; i++)
+        {
+            entry->bytes[i] = i < length ? memory->peek(registers.PC.val + i) : 0;
+        }
+    }
+#endif
     // stepTime += checkForInterrupts();
     // Fetch the next instruction
     data_t cpuInst = memory->read(registers.PC.val++);
@@ -104,6 +126,24 @@ int Z80Cpu::step()
     stepTime += executeInstruction(cpuInst);
      
     advanceTimer(stepTime);
+
+#ifdef GB_PROFILER
+    if (profiler != NULL)
+    {
+        int opcode = cpuInst;
+        if (cpuInst == 0xCB)
+        {
+            opcode = 0x100 + cbOpcode;
+        }
+        profiler->record(pc, opcode, registers.PC.val, stepTime);
+    }
+#endif
+#ifdef GB_TRACE
+    if (trace != NULL)
+    {
+        trace->end(stepTime);
+    }
+#endif
     return stepTime;
 }
 
@@ -937,6 +977,9 @@ int Z80Cpu::executeCBInstruction()
 
     // break the instruction down
     data_t inst = memory->read(registers.PC.val++);
+#ifdef GB_PROFILER
+    cbOpcode = inst;
+#endif
     int highInst = (inst >> 4) & 0xF;
     int lowInst = inst & 0xF;
 
@@ -1084,3 +1127,28 @@ int Z80Cpu::executeCBInstruction()
     }
     return stepTime;
 }
+
+void Z80Cpu::saveState(StateWriter *state)
+{
+    state->beginChunk("CPU ");
+    state->write(registers.BC.val);
+    state->write(registers.DE.val);
+    state->write(registers.HL.val);
+    state->write(registers.AF.val);
+    state->write(registers.PC.val);
+    state->write(registers.SP.val);
+    state->write(intMasterEnable);
+    state->endChunk();
+}
+
+bool Z80Cpu::loadState(StateReader *state)
+{
+    return state->openChunk("CPU ") &&
+           state->read(&registers.BC.val) &&
+           state->read(&registers.DE.val) &&
+           state->read(&registers.HL.val) &&
+           state->read(&registers.AF.val) &&
+           state->read(&registers.PC.val) &&
+           state->read(&registers.SP.val) &&
+           state->read(&intMasterEnable);
+}
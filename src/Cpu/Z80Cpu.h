@@ -2,6 +2,10 @@
 #define _Z80_CPU_H_
 
 #include "CpuBase.h"
+#include "CpuProfiler.h"
+#include "CpuTrace.h"
+#include "DebugPolicy.h"
+#include "../Common/SaveState.h"
 #include "../Memory/Memory.h"
 #include "../Memory/Customizers/IOMemory.h"
 #include "Z80.h"
@@ -17,6 +21,25 @@ class Z80Cpu : public ::CpuBase
 public: 
     void init();
     int step();
+
+    /**
+     * Runs one instruction, checking with a debug policy first.
+     *
+     * @param policy The debug policy, see DebugPolicy.h.
+     * @return The cycles the instruction took, 0 if the policy stopped
+     * before it.
+     */
+    template<class DebugPolicy>
+    int stepWith(DebugPolicy &policy)
+    {
+        if (policy.beforeInstruction(registers.PC.val))
+        {
+            return 0;
+        }
+        int cycles = step();
+        policy.afterInstruction();
+        return cycles;
+    }
     
     /**
      * Creates the Z80 CPU.
@@ -31,6 +54,40 @@ public:
         return &registers;
     }
 
+    /**
+     * Writes the registers and interrupt master enable into a "CPU " chunk.
+     */
+    void saveState(StateWriter *state);
+
+    /**
+     * Restores the CPU from its save state chunk.
+     *
+     * @return True if the state was loaded, false otherwise.
+     */
+    bool loadState(StateReader *state);
+
+    /**
+     * Sets a profiler to report every instruction to. Instructions are only
+     * reported when the CPU is built with GB_PROFILER.
+     *
+     * @param profiler The profiler, or NULL for none.
+     */
+    void setProfiler(CpuProfiler *profiler)
+    {
+        this->profiler = profiler;
+    }
+
+    /**
+     * Sets a trace to record every instruction to. Instructions are only
+     * recorded when the CPU is built with GB_TRACE.
+     *
+     * @param trace The trace, or NULL for none.
+     */
+    void setTrace(CpuTrace *trace)
+    {
+        this->trace = trace;
+    }
+
 private:
     /**
      * Checks for any interrupts and makes a system call if necessarry.
@@ -49,6 +106,10 @@ private:
     Z80Registers registers;
     Z80Flags *flags;
     bool intMasterEnable;
+    CpuProfiler *profiler;
+    /* The second byte of the last CB instruction, for the profiler. */
+    data_t cbOpcode;
+    CpuTrace *trace;
 };
 
 #endif
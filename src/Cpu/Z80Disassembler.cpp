@@ -0,0 +1,396 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "SymbolTable.h"
+#include "Z80Disassembler.h"
+
+/**
+ * Mnemonics of the opcodes, as in the opcode table in Z80Cpu.cpp. Operands
+ * are lower case: n is an 8 bit value, nn a 16 bit value, d a relative jump
+ * and dd a signed 8 bit offset. NULL opcodes do not exist.
+ */
+static const char* mnemonics[0x100] =
+{
+    /* 0x00 */ "NOP", "LD BC, nn", "LD (BC), A", "INC BC",
+    /* 0x04 */ "INC B", "DEC B", "LD B, n", "RLCA",
+    /* 0x08 */ "LD (nn), SP", "ADD HL, BC", "LD A, (BC)", "DEC BC",
+    /* 0x0C */ "INC C", "DEC C", "LD C, n", "RRCA",
+    /* 0x10 */ "STOP", "LD DE, nn", "LD (DE), A", "INC DE",
+    /* 0x14 */ "INC D", "DEC D", "LD D, n", "RLA",
+    /* 0x18 */ "JR d", "ADD HL, DE", "LD A, (DE)", "DEC DE",
+    /* 0x1C */ "INC E", "DEC E", "LD E, n", "RRA",
+    /* 0x20 */ "JR NZ, d", "LD HL, nn", "LDI (HL), A", "INC HL",
+    /* 0x24 */ "INC H", "DEC H", "LD H, n", "DAA",
+    /* 0x28 */ "JR Z, d", "ADD HL, HL", "LDI A, (HL)", "DEC HL",
+    /* 0x2C */ "INC L", "DEC L", "LD L, n", "CPL",
+    /* 0x30 */ "JR NC, d", "LD SP, nn", "LDD (HL), A", "INC SP",
+    /* 0x34 */ "INC (HL)", "DEC (HL)", "LD (HL), n", "SCF",
+    /* 0x38 */ "JR C, d", "ADD HL, SP", "LDD A, (HL)", "DEC SP",
+    /* 0x3C */ "INC A", "DEC A", "LD A, n", "CCF",
+    /* 0x40 */ "LD B, B", "LD B, C", "LD B, D", "LD B, E",
+    /* 0x44 */ "LD B, H", "LD B, L", "LD B, (HL)", "LD B, A",
+    /* 0x48 */ "LD C, B", "LD C, C", "LD C, D", "LD C, E",
+    /* 0x4C */ "LD C, H", "LD C, L", "LD C, (HL)", "LD C, A",
+    /* 0x50 */ "LD D, B", "LD D, C", "LD D, D", "LD D, E",
+    /* 0x54 */ "LD D, H", "LD D, L", "LD D, (HL)", "LD D, A",
+    /* 0x58 */ "LD E, B", "LD E, C", "LD E, D", "LD E, E",
+    /* 0x5C */ "LD E, H", "LD E, L", "LD E, (HL)", "LD E, A",
+    /* 0x60 */ "LD H, B", "LD H, C", "LD H, D", "LD H, E",
+    /* 0x64 */ "LD H, H", "LD H, L", "LD H, (HL)", "LD H, A",
+    /* 0x68 */ "LD L, B", "LD L, C", "LD L, D", "LD L, E",
+    /* 0x6C */ "LD L, H", "LD L, L", "LD L, (HL)", "LD L, A",
+    /* 0x70 */ "LD (HL), B", "LD (HL), C", "LD (HL), D", "LD (HL), E",
+    /* 0x74 */ "LD (HL), H", "LD (HL), L", "HALT", "LD (HL), A",
+    /* 0x78 */ "LD A, B", "LD A, C", "LD A, D", "LD A, E",
+    /* 0x7C */ "LD A, H", "LD A, L", "LD A, (HL)", "LD A, A",
+    /* 0x80 */ "ADD A, B", "ADD A, C", "ADD A, D", "ADD A, E",
+    /* 0x84 */ "ADD A, H", "ADD A, L", "ADD A, (HL)", "ADD A, A",
+    /* 0x88 */ "ADC A, B", "ADC A, C", "ADC A, D", "ADC A, E",
+    /* 0x8C */ "ADC A, H", "ADC A, L", "ADC A, (HL)", "ADC A, A",
+    /* 0x90 */ "SUB B", "SUB C", "SUB D", "SUB E",
+    /* 0x94 */ "SUB H", "SUB L", "SUB (HL)", "SUB A",
+    /* 0x98 */ "SBC A, B", "SBC A, C", "SBC A, D", "SBC A, E",
+    /* 0x9C */ "SBC A, H", "SBC A, L", "SBC A, (HL)", "SBC A, A",
+    /* 0xA0 */ "AND B", "AND C", "AND D", "AND E",
+    /* 0xA4 */ "AND H", "AND L", "AND (HL)", "AND A",
+    /* 0xA8 */ "XOR B", "XOR C", "XOR D", "XOR E",
+    /* 0xAC */ "XOR H", "XOR L", "XOR (HL)", "XOR A",
+    /* 0xB0 */ "OR B", "OR C", "OR D", "OR E",
+    /* 0xB4 */ "OR H", "OR L", "OR (HL)", "OR A",
+    /* 0xB8 */ "CP B", "CP C", "CP D", "CP E",
+    /* 0xBC */ "CP H", "CP L", "CP (HL)", "CP A",
+    /* 0xC0 */ "RET NZ", "POP BC", "JP NZ, nn", "JP nn",
+    /* 0xC4 */ "CALL NZ, nn", "PUSH BC", "ADD A, n", "RST 00H",
+    /* 0xC8 */ "RET Z", "RET", "JP Z, nn", NULL,
+    /* 0xCC */ "CALL Z, nn", "CALL nn", "ADC A, n", "RST 08H",
+    /* 0xD0 */ "RET NC", "POP DE", "JP NC, nn", NULL,
+    /* 0xD4 */ "CALL NC, nn", "PUSH DE", "SUB n", "RST 10H",
+    /* 0xD8 */ "RET C", "RETI", "JP C, nn", NULL,
+    /* 0xDC */ "CALL C, nn", NULL, "SBC A, n", "RST 18H",
+    /* 0xE0 */ "LD (FF00+n), A", "POP HL", "LD (FF00+C), A", NULL,
+    /* 0xE4 */ NULL, "PUSH HL", "AND n", "RST 20H",
+    /* 0xE8 */ "ADD SP, dd", "JP (HL)", "LD (nn), A", NULL,
+    /* 0xEC */ NULL, NULL, "XOR n", "RST 28H",
+    /* 0xF0 */ "LD A, (FF00+n)", "POP AF", "LD A, (FF00+C)", "DI",
+    /* 0xF4 */ NULL, "PUSH AF", "OR n", "RST 30H",
+    /* 0xF8 */ "LD HL, SP+dd", "LD SP, HL", "LD A, (nn)", "EI",
+    /* 0xFC */ NULL, NULL, "CP n", "RST 38H"
+};
+
+/** CB opcodes, by the top five bits. BIT, RES and SET also take a bit. */
+static const char* cbMnemonics[] =
+{
+    "RLC", "RRC", "RL", "RR", "SLA", "SRA", "SWAP", "SRL"
+};
+static const char* cbBitMnemonics[] = { "BIT", "RES", "SET" };
+static const char* cbOperands[] = { "B", "C", "D", "E", "H", "L", "(HL)", "A" };
+
+/** The kinds of operand an opcode can have. */
+enum OperandType
+{
+    NO_OPERAND,
+    /** n, an 8 bit value. */
+    IMMEDIATE_8,
+    /** nn, a 16 bit value. */
+    IMMEDIATE_16,
+    /** FF00+n, a high memory address, with FF00+ ending the prefix. */
+    HIGH_ADDRESS,
+    /** d, a relative jump. */
+    RELATIVE,
+    /** dd, a signed offset, written with its sign if it had a + before it. */
+    OFFSET,
+    SIGNED_OFFSET
+};
+
+/** Size of the text of an opcode, which is always copied whole. */
+#define ENTRY_TEXT_SIZE 32
+
+/**
+ * An opcode, with its text written out but for the digits of its operand.
+ */
+struct OpcodeEntry
+{
+    const char* mnemonic;
+    /* The text, with "$" and a placeholder for every hex digit. */
+    char text[ENTRY_TEXT_SIZE];
+    uint8_t textLength;
+    /* The operand follows the prefix, and takes operandLength characters
+       of the text. Offsets take none, as their length changes. */
+    uint8_t prefixLength;
+    uint8_t operandLength;
+    uint8_t operand;
+    uint8_t length;
+    /* Whether the operand is an address that can have a symbol. */
+    bool isAddress;
+    /* Whether the text only needs its hex digits filled in. */
+    bool isPlain;
+};
+
+/**
+ * Every opcode, written out once from the mnemonics. The CB page follows
+ * the main page.
+ */
+class OpcodeTable
+{
+public:
+    OpcodeTable()
+    {
+        for (int op = 0; op < 0x100; op++)
+        {
+            split(&entries[op], mnemonics[op]);
+        }
+        for (int op = 0; op < 0x100; op++)
+        {
+            const char* operand = cbOperands[op & 0x07];
+            if (op < 0x40)
+                snprintf(cbTexts[op], sizeof(cbTexts[op]), "%s %s",
+                         cbMnemonics[op >> 3], operand);
+            else
+                snprintf(cbTexts[op], sizeof(cbTexts[op]), "%s %d, %s",
+                         cbBitMnemonics[(op >> 6) - 1], (op >> 3) & 0x07, operand);
+            split(&entries[0x100 + op], cbTexts[op]);
+            entries[0x100 + op].length = 2;
+        }
+        for (int i = 0; i < 0x100; i++)
+        {
+            hexPairs[i][0] = "0123456789ABCDEF"[i >> 4];
+            hexPairs[i][1] = "0123456789ABCDEF"[i & 0x0F];
+        }
+    }
+
+    OpcodeEntry entries[0x200];
+    /* Every byte as two hex digits. */
+    char hexPairs[0x100][2];
+
+private:
+    static void split(OpcodeEntry* entry, const char* mnemonic)
+    {
+        memset(entry, 0, sizeof(*entry));
+        entry->mnemonic = mnemonic;
+        entry->length = 1;
+        if (mnemonic == NULL)
+        {
+            return;
+        }
+
+        const char* operand = mnemonic;
+        while (*operand != '\0' && *operand != 'n' && *operand != 'd')
+        {
+            operand++;
+        }
+        bool isWide = operand[0] != '\0' && operand[1] == operand[0];
+        size_t prefixLength = operand - mnemonic;
+        int digits = 0;
+
+        if (operand[0] == 'n')
+        {
+            entry->operand = isWide ? IMMEDIATE_16 : IMMEDIATE_8;
+            entry->length = isWide ? 3 : 2;
+            digits = isWide ? 4 : 2;
+            if (prefixLength >= 5 && strncmp(operand - 5, "FF00+", 5) == 0)
+            {
+                entry->operand = HIGH_ADDRESS;
+            }
+        }
+        else if (operand[0] == 'd')
+        {
+            entry->operand = isWide ? OFFSET : RELATIVE;
+            entry->length = 2;
+            digits = isWide ? 0 : 4;
+            if (isWide && operand[-1] == '+')
+            {
+                entry->operand = SIGNED_OFFSET;
+                prefixLength--;
+            }
+        }
+
+        entry->isAddress = entry->operand == RELATIVE ||
+                           entry->operand == HIGH_ADDRESS ||
+                           (entry->operand == IMMEDIATE_16 &&
+                            (operand[-1] == '(' || strncmp(mnemonic, "JP", 2) == 0 ||
+                             strncmp(mnemonic, "CALL", 4) == 0));
+
+        const char* suffix = operand + (operand[0] == '\0' ? 0 : (isWide ? 2 : 1));
+        std::string text(mnemonic, prefixLength);
+        if (digits != 0)
+        {
+            text += "$" + std::string(digits, '0');
+        }
+        text += suffix;
+
+        memcpy(entry->text, text.c_str(), text.size() + 1);
+        entry->textLength = (uint8_t)text.size();
+        entry->prefixLength = (uint8_t)prefixLength;
+        entry->operandLength = (uint8_t)(digits == 0 ? 0 : digits + 1);
+        entry->isPlain = entry->operand != OFFSET && entry->operand != SIGNED_OFFSET;
+    }
+
+    char cbTexts[0x100][16];
+};
+
+/* Built before main(), nothing disassembles before that. */
+static const OpcodeTable table;
+
+static const char hexDigits[] = "0123456789ABCDEF";
+
+/**
+ * Appends to a buffer, cutting off what does not fit.
+ */
+struct TextWriter
+{
+    char* text;
+    size_t length;
+    size_t size;
+
+    void write(const char* data, size_t count)
+    {
+        if (count > size - 1 - length)
+        {
+            count = size - 1 - length;
+        }
+        memcpy(text + length, data, count);
+        length += count;
+    }
+
+    /** Writes "$" and the given number of hex digits. */
+    void writeHex(unsigned value, int digits)
+    {
+        char hex[5] = { '$' };
+        for (int i = 0; i < digits; i++)
+        {
+            hex[digits - i] = hexDigits[(value >> (i * 4)) & 0x0F];
+        }
+        write(hex, digits + 1);
+    }
+
+    void writeSigned(int value, bool withPlus)
+    {
+        char number[5];
+        int count = 0;
+        if (value < 0 || withPlus)
+        {
+            number[count++] = value < 0 ? '-' : '+';
+        }
+        unsigned magnitude = value < 0 ? -value : value;
+        if (magnitude >= 100)
+            number[count++] = (char)('0' + magnitude / 100);
+        if (magnitude >= 10)
+            number[count++] = (char)('0' + magnitude / 10 % 10);
+        number[count++] = (char)('0' + magnitude % 10);
+        write(number, count);
+    }
+};
+
+int Z80Disassembler::getLength(data_t opcode)
+{
+    return opcode == 0xCB ? 2 : table.entries[opcode].length;
+}
+
+const char* Z80Disassembler::getMnemonic(int opcode)
+{
+    return table.entries[opcode].mnemonic;
+}
+
+std::string Z80Disassembler::disassemble(const data_t* bytes, uint16_t addr,
+                                         const SymbolTable* symbols, int bank)
+{
+    char text[256];
+    size_t length = disassemble(bytes, addr, text, sizeof(text), symbols, bank);
+    return std::string(text, length);
+}
+
+/**
+ * Disassembles the instructions that need more than their text and hex
+ * digits: those without a text, with an offset, or with a symbol.
+ */
+static size_t disassembleSlowly(const OpcodeEntry& entry, const data_t* bytes,
+                                uint16_t addr, char* text, size_t size,
+                                const SymbolTable* symbols, int bank)
+{
+    TextWriter writer = { text, 0, size };
+    if (entry.mnemonic == NULL)
+    {
+        writer.write("DB ", 3);
+        writer.writeHex(bytes[0], 2);
+        text[writer.length] = '\0';
+        return writer.length;
+    }
+
+    uint16_t value = 0;
+    switch (entry.operand)
+    {
+    case IMMEDIATE_8:
+    case HIGH_ADDRESS:
+        value = bytes[1];
+        break;
+    case IMMEDIATE_16:
+        value = (uint16_t)(bytes[1] | (bytes[2] << 8));
+        break;
+    case RELATIVE:
+        value = (uint16_t)(addr + 2 + (int8_t)bytes[1]);
+        break;
+    }
+
+    const char* name = NULL;
+    if (symbols != NULL && entry.isAddress)
+    {
+        // Operands in the switchable bank are in the same bank as the
+        // instruction, if it is there too.
+        if (entry.operand == HIGH_ADDRESS)
+            name = symbols->getName(0xFF00 | value, -1);
+        else
+            name = symbols->getName(value, (addr >= 0x4000 && addr < 0x8000) ? bank : -1);
+    }
+
+    size_t prefixLength = entry.prefixLength;
+    if (name != NULL && entry.operand == HIGH_ADDRESS)
+    {
+        prefixLength -= 5;
+    }
+    writer.write(entry.text, prefixLength);
+    if (name != NULL)
+        writer.write(name, strlen(name));
+    else if (entry.operand == OFFSET || entry.operand == SIGNED_OFFSET)
+        writer.writeSigned((int8_t)bytes[1], entry.operand == SIGNED_OFFSET);
+    else if (entry.operandLength != 0)
+        writer.writeHex(value, entry.operandLength - 1);
+
+    size_t operandEnd = entry.prefixLength + entry.operandLength;
+    writer.write(entry.text + operandEnd, entry.textLength - operandEnd);
+    text[writer.length] = '\0';
+    return writer.length;
+}
+
+size_t Z80Disassembler::disassemble(const data_t* bytes, uint16_t addr,
+                                    char* text, size_t size,
+                                    const SymbolTable* symbols, int bank)
+{
+    data_t opcode = bytes[0];
+    const OpcodeEntry& entry =
+        table.entries[opcode == 0xCB ? 0x100 + bytes[1] : opcode];
+    if (!entry.isPlain || (symbols != NULL && entry.isAddress) ||
+        size <= ENTRY_TEXT_SIZE)
+    {
+        return disassembleSlowly(entry, bytes, addr, text, size, symbols, bank);
+    }
+
+    // The whole text is copied, then the digits are filled in.
+    memcpy(text, entry.text, ENTRY_TEXT_SIZE);
+    if (entry.operandLength != 0)
+    {
+        char* digits = text + entry.prefixLength + 1;
+        if (entry.operandLength == 5)
+        {
+            uint16_t value = entry.operand == RELATIVE ?
+                             (uint16_t)(addr + 2 + (int8_t)bytes[1]) :
+                             (uint16_t)(bytes[1] | (bytes[2] << 8));
+            memcpy(digits, table.hexPairs[value >> 8], 2);
+            memcpy(digits + 2, table.hexPairs[value & 0xFF], 2);
+        }
+        else
+        {
+            memcpy(digits, table.hexPairs[bytes[1]], 2);
+        }
+    }
+    return entry.textLength;
+}
@@ -0,0 +1,73 @@
+#ifndef _Z80_DISASSEMBLER_H_
+#define _Z80_DISASSEMBLER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+#include "../Memory/MemoryDefs.h"
+
+class SymbolTable;
+
+/**
+ * @brief Turns Game Boy machine code back into assembly.
+ *
+ * The mnemonics come from the opcode table in Z80Cpu.cpp. Operands are
+ * written as hex, and relative jumps as the address they jump to. Opcodes
+ * the Game Boy does not have are written as "DB $xx".
+ *
+ * Every opcode is split into the text before and after its operand once,
+ * into a table, so disassembling an instruction is a table lookup and a few
+ * copies. The versions writing to a buffer do not allocate, for tools that
+ * go through whole ROMs.
+ *
+ * With a SymbolTable, jump targets and memory operands that have a name are
+ * written as that name.
+ *
+ * @ingroup CPU
+ */
+class Z80Disassembler
+{
+public:
+    /**
+     * Gets the number of bytes in the instruction starting with an opcode,
+     * counting the opcode.
+     */
+    static int getLength(data_t opcode);
+
+    /**
+     * Gets the mnemonic of an opcode with placeholders for its operands, as
+     * written in Z80Cpu.cpp, e.g. "JR NZ, d".
+     *
+     * @param opcode The opcode, 0x100 plus the second byte for the CB page.
+     * @return The mnemonic, or NULL if the Game Boy has no such opcode.
+     */
+    static const char* getMnemonic(int opcode);
+
+    /**
+     * Disassembles one instruction.
+     *
+     * @param bytes The instruction, getLength() bytes of it.
+     * @param addr The address of the instruction, for relative jumps.
+     * @param symbols Names for the addresses in operands, or NULL.
+     * @param bank The ROM bank of the instruction, or -1 if it is not known.
+     * @return The instruction, e.g. "JR NZ, $0150".
+     */
+    static std::string disassemble(const data_t* bytes, uint16_t addr,
+                                   const SymbolTable* symbols = NULL,
+                                   int bank = -1);
+
+    /**
+     * Disassembles one instruction into a buffer. Symbols that do not fit
+     * are cut short.
+     *
+     * @param text The buffer, which is always terminated.
+     * @param size The size of the buffer, at least 32 bytes.
+     * @return The number of characters written, not counting the 0.
+     */
+    static size_t disassemble(const data_t* bytes, uint16_t addr, char* text,
+                              size_t size, const SymbolTable* symbols = NULL,
+                              int bank = -1);
+};
+
+#endif
@@ -0,0 +1,92 @@
+#include <string.h>
+
+#include "FarmJob.h"
+#include "../Common/FramePacer.h"
+#include "../Common/Hash.h"
+#include "../Common/SaveState.h"
+#include "../Machine/GBMachine.h"
+#include "../Memory/MemoryLoader.h"
+
+FarmJob::FarmJob(const std::string romFile, uint64_t frames, const InputScript* script)
+{
+    this->romFile = romFile;
+    this->frames = frames;
+    hasScript = script != NULL;
+    if (hasScript)
+    {
+        this->script = *script;
+    }
+
+    success = false;
+    stateHash = 0;
+    frameHash = 0;
+    memset(frame, 0, sizeof(frame));
+    runTime = 0;
+}
+
+void FarmJob::run()
+{
+    uint64_t start = FramePacer::now();
+
+    Memory* mem = MemoryLoader::loadCartridge(romFile);
+    if (mem == NULL)
+    {
+        return;
+    }
+
+    GBMachine machine(mem);
+    machine.getLcd()->init(NULL);
+    if (hasScript)
+    {
+        machine.setInputScript(&script);
+    }
+
+    for (uint64_t i = 0; i < frames; i++)
+    {
+        machine.runFrame();
+    }
+
+    StateWriter state;
+    machine.saveState(&state);
+    stateHash = hashBytes(state.getData(), state.getSize());
+    memcpy(frame, machine.getLcd()->getFrame(), sizeof(frame));
+    frameHash = hashBytes(frame, sizeof(frame));
+
+    success = true;
+    runTime = FramePacer::now() - start;
+}
+
+bool FarmJob::succeeded()
+{
+    return success;
+}
+
+std::string FarmJob::getRomFile()
+{
+    return romFile;
+}
+
+uint64_t FarmJob::getFrames()
+{
+    return frames;
+}
+
+uint64_t FarmJob::getStateHash()
+{
+    return stateHash;
+}
+
+uint64_t FarmJob::getFrameHash()
+{
+    return frameHash;
+}
+
+const uint8_t* FarmJob::getFrame()
+{
+    return frame;
+}
+
+uint64_t FarmJob::getRunTime()
+{
+    return runTime;
+}
@@ -0,0 +1,79 @@
+#ifndef _FARM_JOB_H_
+#define _FARM_JOB_H_
+
+#include <stdint.h>
+#include <string>
+
+#include "../Common/ThreadPool.h"
+#include "../Input/InputScript.h"
+
+/**
+ * @brief Runs one Game Boy from start to finish, for gameboy-farm.
+ *
+ * The job loads a ROM into a machine of its own, runs it for a number of 
+ * frames with an optional input script, and keeps the final state hash and
+ * frame. Jobs share nothing, so any number can run at once on a 
+ * ThreadPool.
+ */
+class FarmJob : public Task
+{
+public:
+    /**
+     * @param romFile The ROM to run.
+     * @param frames Number of frames to run for.
+     * @param script Input script to play, or NULL for no input. The job 
+     * takes a copy.
+     */
+    FarmJob(const std::string romFile, uint64_t frames, const InputScript* script);
+
+    void run();
+
+    /**
+     * Did the job run? False if the ROM could not be loaded.
+     */
+    bool succeeded();
+
+    /**
+     * Gets the ROM the job ran.
+     */
+    std::string getRomFile();
+
+    /**
+     * Gets the number of frames that were run.
+     */
+    uint64_t getFrames();
+
+    /**
+     * Gets the hash of the machine's save state at the end of the run.
+     */
+    uint64_t getStateHash();
+
+    /**
+     * Gets the hash of the last frame.
+     */
+    uint64_t getFrameHash();
+
+    /**
+     * Gets the last frame, one shade per pixel.
+     */
+    const uint8_t* getFrame();
+
+    /**
+     * Gets how long the job took to run, in nanoseconds.
+     */
+    uint64_t getRunTime();
+
+private:
+    std::string romFile;
+    uint64_t frames;
+    InputScript script;
+    bool hasScript;
+
+    bool success;
+    uint64_t stateHash;
+    uint64_t frameHash;
+    uint8_t frame[160 * 144];
+    uint64_t runTime;
+};
+
+#endif
@@ -0,0 +1,124 @@
+#include <fstream>
+#include <sstream>
+
+#include "InputLog.h"
+
+InputLog::InputLog()
+{
+    current = 0;
+}
+
+void InputLog::record(uint64_t cycle, data_t buttons)
+{
+    // If the machine was rewound, what was recorded after it is replaced.
+    while (!entries.empty() && entries.back().cycle > cycle)
+    {
+        entries.pop_back();
+    }
+    current = 0;
+
+    data_t last = entries.empty() ? 0 : entries.back().buttons;
+    if (buttons == last)
+    {
+        return;
+    }
+
+    Entry entry;
+    entry.cycle = cycle;
+    entry.buttons = buttons;
+    entries.push_back(entry);
+}
+
+data_t InputLog::getButtons(uint64_t cycle)
+{
+    if (entries.empty() || cycle < entries[0].cycle)
+    {
+        return 0;
+    }
+
+    // Replays ask for cycles in order, so start from the last entry used.
+    if (current >= entries.size() || entries[current].cycle > cycle)
+    {
+        current = 0;
+    }
+    while (current + 1 < entries.size() && entries[current + 1].cycle <= cycle)
+    {
+        current++;
+    }
+    return entries[current].buttons;
+}
+
+size_t InputLog::getSize()
+{
+    return entries.size();
+}
+
+bool InputLog::save(const std::string fileName)
+{
+    std::ofstream file(fileName.c_str());
+    if (!file.is_open())
+    {
+        error = "Could not open input log " + fileName + ".";
+        return false;
+    }
+
+    file << "# gameboy input log" << std::endl;
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        file << std::dec << entries[i].cycle << " " 
+             << std::hex << (int)entries[i].buttons << std::endl;
+    }
+
+    if (!file.good())
+    {
+        error = "Could not write input log " + fileName + ".";
+        return false;
+    }
+    return true;
+}
+
+bool InputLog::load(const std::string fileName)
+{
+    std::ifstream file(fileName.c_str());
+    if (!file.is_open())
+    {
+        error = "Could not open input log " + fileName + ".";
+        return false;
+    }
+
+    entries.clear();
+    current = 0;
+
+    std::string line;
+    int lineNum = 0;
+    while (std::getline(file, line))
+    {
+        lineNum++;
+        line = line.substr(0, line.find('#'));
+        std::istringstream tokens(line);
+
+        Entry entry;
+        int buttons;
+        if (!(tokens >> entry.cycle))
+        {
+            // Blank line, or just a comment.
+            continue;
+        }
+        if (!(tokens >> std::hex >> buttons) || buttons < 0 || buttons > 0xFF ||
+            (!entries.empty() && entry.cycle < entries.back().cycle))
+        {
+            std::ostringstream message;
+            message << fileName << ":" << lineNum << ": bad input log entry.";
+            error = message.str();
+            return false;
+        }
+        entry.buttons = (data_t)buttons;
+        entries.push_back(entry);
+    }
+    return true;
+}
+
+std::string InputLog::getErrorMessage()
+{
+    return error;
+}
@@ -0,0 +1,88 @@
+#ifndef _INPUT_LOG_H_
+#define _INPUT_LOG_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "../Memory/MemoryDefs.h"
+
+/**
+ * @brief A log of joypad input, timestamped by emulated cycle.
+ *
+ * A log recorded from a session can be replayed to feed the joypad exactly
+ * the same buttons on exactly the same cycles, so the session runs the same
+ * way again, e.g. headless as a benchmark or regression test.
+ *
+ * The file has a line for every change of buttons, giving the cycle of the 
+ * change and the new JoypadButton mask in hex:
+ *
+ *     # gameboy input log
+ *     1403664 80
+ *     1473888 00
+ */
+class InputLog
+{
+public:
+    InputLog();
+
+    /**
+     * Records the buttons held down on a cycle. Nothing is recorded if the
+     * buttons have not changed. Recording an earlier cycle than the last, 
+     * e.g. after rewinding, drops everything recorded after it.
+     *
+     * @param cycle The cycle the buttons were passed to the joypad.
+     * @param buttons Mask of JoypadButton values.
+     */
+    void record(uint64_t cycle, data_t buttons);
+
+    /**
+     * Gets the buttons held down on a cycle.
+     *
+     * @param cycle The cycle.
+     * @return Mask of JoypadButton values.
+     */
+    data_t getButtons(uint64_t cycle);
+
+    /**
+     * Gets the number of changes in the log.
+     */
+    size_t getSize();
+
+    /**
+     * Saves the log to a file.
+     *
+     * @param fileName Name of the file.
+     * @return True if the log was saved, false otherwise.
+     */
+    bool save(const std::string fileName);
+
+    /**
+     * Loads a log from a file, replacing what is in the log.
+     *
+     * @param fileName Name of the file.
+     * @return True if the log was loaded, false otherwise.
+     */
+    bool load(const std::string fileName);
+
+    /**
+     * Gets the error that occurred when saving or loading the log.
+     */
+    std::string getErrorMessage();
+
+private:
+    struct Entry
+    {
+        uint64_t cycle;
+        data_t buttons;
+    };
+
+    std::vector<Entry> entries;
+
+    /* Index of the entry used for the last cycle. */
+    size_t current;
+
+    std::string error;
+};
+
+#endif
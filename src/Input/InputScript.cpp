@@ -0,0 +1,120 @@
+#include <fstream>
+#include <sstream>
+
+#include "InputScript.h"
+#include "../Memory/Customizers/IOMemory.h"
+
+InputScript::InputScript()
+{
+    current = 0;
+}
+
+bool InputScript::load(const std::string fileName)
+{
+    std::ifstream file(fileName.c_str());
+    if (!file.is_open())
+    {
+        error = "Could not open input script " + fileName + ".";
+        return false;
+    }
+
+    entries.clear();
+    current = 0;
+
+    std::string line;
+    int lineNum = 0;
+    while (std::getline(file, line))
+    {
+        lineNum++;
+        line = line.substr(0, line.find('#'));
+        std::istringstream tokens(line);
+
+        Entry entry;
+        if (!(tokens >> entry.frame))
+        {
+            // Blank line, or just a comment.
+            continue;
+        }
+        if (!entries.empty() && entry.frame < entries.back().frame)
+        {
+            std::ostringstream message;
+            message << fileName << ":" << lineNum << ": frames are out of order.";
+            error = message.str();
+            return false;
+        }
+
+        entry.buttons = 0;
+        std::string name;
+        while (tokens >> name)
+        {
+            if (name == "-")
+            {
+                continue;
+            }
+            data_t mask = getButtonMask(name);
+            if (mask == 0)
+            {
+                std::ostringstream message;
+                message << fileName << ":" << lineNum << ": unknown button " << name << ".";
+                error = message.str();
+                return false;
+            }
+            entry.buttons |= mask;
+        }
+        entries.push_back(entry);
+    }
+    return true;
+}
+
+data_t InputScript::getButtons(uint64_t frame)
+{
+    if (entries.empty() || frame < entries[0].frame)
+    {
+        return 0;
+    }
+
+    // Start from the last entry that was used, and move to the last entry 
+    // that starts on or before the frame.
+    if (current >= entries.size() || entries[current].frame > frame)
+    {
+        current = 0;
+    }
+    while (current + 1 < entries.size() && entries[current + 1].frame <= frame)
+    {
+        current++;
+    }
+    return entries[current].buttons;
+}
+
+std::string InputScript::getErrorMessage()
+{
+    return error;
+}
+
+data_t InputScript::getButtonMask(const std::string name)
+{
+    static const struct
+    {
+        const char* name;
+        data_t mask;
+    } buttonNames[] =
+    {
+        { "RIGHT", JOYPAD_RIGHT },
+        { "LEFT", JOYPAD_LEFT },
+        { "UP", JOYPAD_UP },
+        { "DOWN", JOYPAD_DOWN },
+        { "A", JOYPAD_A },
+        { "B", JOYPAD_B },
+        { "SELECT", JOYPAD_SELECT },
+        { "START", JOYPAD_START }
+    };
+
+    for (size_t i = 0; i < sizeof(buttonNames) / sizeof(buttonNames[0]); i++)
+    {
+        if (name == buttonNames[i].name)
+        {
+            return buttonNames[i].mask;
+        }
+    }
+    return 0;
+}
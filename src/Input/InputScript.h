@@ -0,0 +1,75 @@
+#ifndef _INPUT_SCRIPT_H_
+#define _INPUT_SCRIPT_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "../Memory/MemoryDefs.h"
+
+/**
+ * @brief Joypad input read from a file, for running without a player.
+ *
+ * Each line of the file gives the frame the input starts on, followed by the 
+ * buttons held down from then on:
+ *
+ *     # frame  buttons
+ *     0        -
+ *     120      START
+ *     130      -
+ *     200      RIGHT A
+ *
+ * Buttons are RIGHT, LEFT, UP, DOWN, A, B, SELECT and START, and "-" means no
+ * buttons. Lines must be in frame order. Anything after a '#' is ignored.
+ */
+class InputScript
+{
+public:
+    InputScript();
+
+    /**
+     * Loads a script from a file.
+     *
+     * @param fileName Name of the file.
+     * @return True if the script was loaded, false otherwise.
+     */
+    bool load(const std::string fileName);
+
+    /**
+     * Gets the buttons held down on a frame.
+     *
+     * @param frame The frame number.
+     * @return Mask of JoypadButton values.
+     */
+    data_t getButtons(uint64_t frame);
+
+    /**
+     * Gets the error that occurred when loading the script.
+     */
+    std::string getErrorMessage();
+
+    /**
+     * Gets the mask of a button from its name.
+     *
+     * @param name Name of the button, e.g. "START".
+     * @return The button mask, or 0 if there is no such button.
+     */
+    static data_t getButtonMask(const std::string name);
+
+private:
+    struct Entry
+    {
+        uint64_t frame;
+        data_t buttons;
+    };
+
+    std::vector<Entry> entries;
+
+    /* Index of the entry used for the last frame, frames are usually 
+       requested in order. */
+    size_t current;
+
+    std::string error;
+};
+
+#endif
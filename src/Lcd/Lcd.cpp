@@ -1,3 +1,6 @@
+#include <string.h>
+
+#include "../Common/Metrics.h"
 #include "Lcd.h"
 
 #define LCD_ENABLED 0x80
@@ -8,27 +11,94 @@
 #define VBLANK_REQUEST 0x1
 #define VBLANK_ENABLED 0x10
 
+#define FRAME_CYCLES 70224
+
+/**
+ * Length of each mode in cycles, indexed by LcdMode. A scanline takes 456 
+ * cycles, the V-Blank period is 10 scanlines, so a frame takes 70224 cycles.
+ */
+static const int modeLengths[] = 
+{
+    204,    // HBlank
+    456,    // VBlank, per scanline
+    80,     // SearchOAM
+    172     // Transfer
+};
+
 Lcd::Lcd(Memory* mem)
 {
     memory = mem;    
     ioPorts = memory->getIOMemory();
+
+    background = NULL;
+    sprites = NULL;
+    frameCount = 0;
+    frameSkip = 1;
+    skippedFrames = 0;
+    frameRequested = false;
+
+    // Watch LCDC, so the LCD knows when it is switched on or off.
+    lcdPorts = new LcdPorts(ioPorts, this);
+    memory->registerWriteListener(Memory::IOPorts, lcdPorts);
+}
+
+Lcd::~Lcd()
+{
+    memory->registerWriteListener(Memory::IOPorts, ioPorts);
+    delete lcdPorts;
+    delete background;
+    delete sprites;
 }
 
 void Lcd::init(uint32_t* pixels)
 {
     lcdPixels = pixels;
-    background = new LcdBackground(memory, pixels);
-    sprites = new LcdSprites(memory, pixels);
+    memset(lcdFrame, 0, sizeof(lcdFrame));
+    memset(lastFrame, 0, sizeof(lastFrame));
+    memset(lineDirty, 0, sizeof(lineDirty));
+    dirtyLines = 0;
+    if (lcdPixels != NULL)
+    {
+        LcdComponent::convertFrame(lcdFrame, lcdPixels, 0, 144);
+    }
+    background = new LcdBackground(memory, lcdFrame);
+    sprites = new LcdSprites(memory, lcdFrame);
+    
+    dirty = false;
+    clock = 0;
+    nextEventCycle = 0;
     
     currentMode = HBlank;
+    modeCycles = modeLengths[HBlank];
     lcdCycles = 0;
+
+    enabled = (ioPorts->LCDC & LCD_ENABLED) != 0;
+    offCycles = 0;
+    startFrame();
 }
 
 void Lcd::step(int cycles)
 {
-    if (ioPorts->LCDC & LCD_ENABLED)
+    clock += cycles;
+    if (!(ioPorts->LCDC & LCD_ENABLED))
+    {
+        stepOff(cycles);
+        return;
+    }
+    if (!enabled)
+    {
+        // The cycles up to here were spent with the LCD off.
+        switchOn();
+        cycles = 0;
+    }
+
+    lcdCycles += cycles;
+    // The client may step over more than one mode at a time, so keep advancing
+    // until the current mode has not finished yet. Any cycles left over are 
+    // carried into the next mode.
+    while (lcdCycles >= modeCycles)
     {
-        lcdCycles += cycles;
+        lcdCycles -= modeCycles;
         switch (currentMode)
         {
             case HBlank:
@@ -45,6 +115,7 @@ void Lcd::step(int cycles)
                 break;
         }
     }
+    nextEventCycle = clock + (modeCycles - lcdCycles);
 }
 
 bool Lcd::isDirty()
@@ -57,68 +128,211 @@ void Lcd::clean()
     dirty = false;
 }
 
+const uint8_t* Lcd::getFrame()
+{
+    return lcdFrame;
+}
+
+bool Lcd::isLineDirty(int line)
+{
+    return lineDirty[line];
+}
+
+int Lcd::getDirtyLineCount()
+{
+    return dirtyLines;
+}
+
+void Lcd::wake()
+{
+    nextEventCycle = 0;
+}
+
+void Lcd::setFrameSkip(int frames)
+{
+    frameSkip = frames;
+    skippedFrames = 0;
+}
+
+void Lcd::requestFrame()
+{
+    frameRequested = true;
+}
+
+void Lcd::saveState(StateWriter* state)
+{
+    uint8_t mode = (uint8_t)currentMode;
+    state->beginChunk("LCD ");
+    state->write(enabled);
+    state->write(mode);
+    state->write(lcdCycles);
+    state->write(modeCycles);
+    state->write(offCycles);
+    state->write(clock);
+    state->write(nextEventCycle);
+    state->write(frameCount);
+    state->write(skippedFrames);
+    state->write(frameRequested);
+    state->write(renderFrame);
+    state->write(lcdFrame, sizeof(lcdFrame));
+    state->endChunk();
+}
+
+bool Lcd::loadState(StateReader* state)
+{
+    uint8_t mode;
+    // Saved for older versions, but always the length of the mode.
+    int savedModeCycles;
+    if (!state->openChunk("LCD ") ||
+        !state->read(&enabled) ||
+        !state->read(&mode) ||
+        !state->read(&lcdCycles) ||
+        !state->read(&savedModeCycles) ||
+        !state->read(&offCycles) ||
+        !state->read(&clock) ||
+        !state->read(&nextEventCycle) ||
+        !state->read(&frameCount) ||
+        !state->read(&skippedFrames) ||
+        !state->read(&frameRequested) ||
+        !state->read(&renderFrame) ||
+        !state->read(lcdFrame, sizeof(lcdFrame)))
+    {
+        return false;
+    }
+    // A state that is not ours could otherwise index past the mode lengths,
+    // or never finish a mode.
+    if (mode > Transfer)
+    {
+        return false;
+    }
+    currentMode = (LcdMode)mode;
+    modeCycles = modeLengths[mode];
+    return lcdCycles >= 0 && lcdCycles < modeCycles;
+}
+
+void Lcd::startFrame()
+{
+    if (frameSkip > 0)
+    {
+        renderFrame = (skippedFrames == 0);
+        skippedFrames = (skippedFrames + 1) % frameSkip;
+    }
+    else
+    {
+        renderFrame = frameRequested;
+        frameRequested = false;
+    }
+}
+
+void Lcd::stepOff(int cycles)
+{
+    if (enabled)
+    {
+        switchOff();
+        cycles = 0;
+    }
+
+    // Nothing is drawn while the LCD is off, the client is only notified once
+    // a frame so that it still presents something.
+    offCycles += cycles;
+    if (offCycles >= FRAME_CYCLES)
+    {
+        offCycles %= FRAME_CYCLES;
+        frameCount++;
+        dirty = true;
+    }
+    nextEventCycle = clock + (FRAME_CYCLES - offCycles);
+}
+
+void Lcd::switchOn()
+{
+    enabled = true;
+    ioPorts->LY = 0;
+    startFrame();
+    setMode(SearchOAM);
+    lcdCycles = 0;
+    if ((ioPorts->LY == ioPorts->LYC) && (ioPorts->STAT & LCD_STAT_ENABLED))
+    {
+        ioPorts->IFLAGS |= LCD_STAT_REQUEST;
+    }
+}
+
+void Lcd::switchOff()
+{
+    enabled = false;
+    offCycles = 0;
+    ioPorts->LY = 0;
+    setMode(HBlank);
+
+    // Present a blank screen.
+    memset(lcdFrame, 0, sizeof(lcdFrame));
+    presentFrame();
+    dirty = true;
+}
+
 void Lcd::advanceHBlank()
 {
-    if (lcdCycles >= 204)
+    if (ioPorts->LY >= 144)
     {
-        if (ioPorts->LY >= 144)
+        // The LCD could be marked dirty after every scanline has been drawn,
+        // but it seems to make SDL lag if its set to be dirty that often. So
+        // it is set to dirty after every scanline has been drawn, and the LCD
+        // enters V-Blank. Skipped frames have nothing new to show.
+        frameCount++;
+        if (renderFrame)
         {
-            // The LCD could be marked dirty after every scanline has been drawn,
-            // but it seems to make SDL lag if its set to be dirty that often. So
-            // it is set to dirty after every scanline has been drawn, and the LCD
-            // enters V-Blank.
+            presentFrame();
             dirty = true;
-            setMode(VBlank);
-            if (ioPorts->STAT & VBLANK_ENABLED)
-            {
-                ioPorts->IFLAGS |= VBLANK_REQUEST;
-            }
+            GB_METRIC_ADD(Metrics::FRAMES_RENDERED, 1);
         }
         else
         {
-            setMode(SearchOAM);
+            GB_METRIC_ADD(Metrics::FRAMES_SKIPPED, 1);
+        }
+        setMode(VBlank);
+        if (ioPorts->STAT & VBLANK_ENABLED)
+        {
+            ioPorts->IFLAGS |= VBLANK_REQUEST;
         }
     }
+    else
+    {
+        setMode(SearchOAM);
+    }
 }
 
 void Lcd::advanceVBlank()
 {
-    if (lcdCycles >= 465)
+    incrementScanLine();
+    if (ioPorts->LY > 153)
     {
-        lcdCycles = 0;
-        incrementScanLine();
-        if (ioPorts->LY > 153)
-        {
-            ioPorts->LY = 0;
-            setMode(SearchOAM);
-        }
+        ioPorts->LY = 0;
+        startFrame();
+        setMode(SearchOAM);
     }
 }
 
 void Lcd::advanceSearchOam()
 {
-    if (lcdCycles >= 80)
-    {
-        setMode(Transfer);
-    }
+    setMode(Transfer);
 }
 
 void Lcd::advanceTransfer()
 {
-    if (lcdCycles >= 172)
+    setMode(HBlank);
+    
+    if (renderFrame)
     {
-        setMode(HBlank);
-        
         drawScanLine();
-        incrementScanLine();
     }
+    incrementScanLine();
 }
 
 void Lcd::setMode(LcdMode mode)
 {
     currentMode = mode;
-    ioPorts->STAT &= (0xFC | mode);
-    lcdCycles = 0;
+    modeCycles = modeLengths[mode];
+    ioPorts->STAT = (ioPorts->STAT & 0xFC) | mode;
 }
 
 void Lcd::incrementScanLine()
@@ -138,3 +352,25 @@ void Lcd::drawScanLine()
     background->drawScanline();
     sprites->drawScanline();
 }
+
+void Lcd::presentFrame()
+{
+    dirtyLines = 0;
+    for (int line = 0; line < 144; line++)
+    {
+        uint8_t* current = lcdFrame + line * 160;
+        uint8_t* last = lastFrame + line * 160;
+        lineDirty[line] = memcmp(current, last, 160) != 0;
+        if (!lineDirty[line])
+        {
+            continue;
+        }
+        
+        dirtyLines++;
+        memcpy(last, current, 160);
+        if (lcdPixels != NULL)
+        {
+            LcdComponent::convertFrame(lcdFrame, lcdPixels, line, 1);
+        }
+    }
+}
@@ -4,6 +4,8 @@
 #include "LcdInterface.h"
 #include "LcdBackground.h"
 #include "LcdSprites.h"
+#include "LcdPorts.h"
+#include "../Common/SaveState.h"
 #include "../Memory/Memory.h"
 #include "../Memory/Customizers/IOMemory.h"
 
@@ -19,11 +21,57 @@ public:
      * @param mem Memory that the LCD can interface to.
      */
     Lcd(Memory* mem);
+    ~Lcd();
 
     virtual void init(uint32_t* pixels);
     virtual void step(int cycles);
     virtual bool isDirty();
     virtual void clean();
+    virtual const uint8_t* getFrame();
+    virtual bool isLineDirty(int line);
+    virtual int getDirtyLineCount();
+
+    /**
+     * Makes the LCD due to be stepped straight away. This is used when the
+     * LCD is switched on or off, since nothing is scheduled while it is off.
+     */
+    void wake();
+
+    /**
+     * Only render one out of every few frames. The LCD timings, LY, STAT 
+     * and interrupts are still emulated for skipped frames, but nothing is 
+     * drawn and the LCD is not marked dirty.
+     *
+     * @param frames Render one frame out of this many. 1 renders every frame,
+     * 0 only renders frames that are requested with requestFrame().
+     */
+    void setFrameSkip(int frames);
+
+    /**
+     * Render the next frame that starts, regardless of frame skipping.
+     */
+    void requestFrame();
+
+    /**
+     * Writes the LCD's timing and the frame being drawn into an "LCD " 
+     * chunk. Frame skip settings are not saved.
+     */
+    void saveState(StateWriter* state);
+
+    /**
+     * Restores the LCD from its save state chunk. Scanlines that differ 
+     * from the last frame presented are marked dirty when the next frame is
+     * presented, as usual.
+     *
+     * @return True if the state was loaded, false otherwise.
+     */
+    bool loadState(StateReader* state);
+
+    /**
+     * Gets the number of frames the LCD has finished. This counts skipped
+     * frames, and the blank frames shown while the LCD is off.
+     */
+    uint64_t getFrameCount() { return frameCount; }
     
     /**
      * The Game Boy LCD goes through 4 different modes while
@@ -39,38 +87,103 @@ public:
 private:
     Memory* memory;
     IOMemory* ioPorts;
+    /* Registered in front of ioPorts for writes. */
+    LcdPorts* lcdPorts;
     uint32_t* lcdPixels;
+
+    /* The frame being drawn, one shade per pixel. */
+    uint8_t lcdFrame[160 * 144];
+
+    /* The last frame that was presented, to find the scanlines that changed. */
+    uint8_t lastFrame[160 * 144];
+    bool lineDirty[144];
+    int dirtyLines;
     
     LcdBackground* background;
     LcdSprites* sprites;
 
     bool dirty;
+
+    /* Was the LCD on when it was last stepped? */
+    bool enabled;
+
+    /* Frame skipping, see setFrameSkip(). */
+    int frameSkip;
+    int skippedFrames;
+    bool frameRequested;
+
+    /* Number of frames finished. */
+    uint64_t frameCount;
+
+    /* Is the current frame being drawn? */
+    bool renderFrame;
+
+    /* Cycles since the last blank frame, while the LCD is off. */
+    int offCycles;
+    
+    /* Total number of cycles the LCD has been stepped by. */
+    uint64_t clock;
+    
+    /* Cycles spent in the current mode. */
     int lcdCycles;
+
+    /* Length of the current mode in cycles. */
+    int modeCycles;
     LcdMode currentMode;
 
     /**
-     * Advance the LCD when when in HBlank.
+     * Advance the LCD when HBlank has finished.
      */
     void advanceHBlank();
     
     /**
-     * Advance the LCD when when in VBlank.
+     * Advance the LCD when a VBlank scanline has finished.
      */
     void advanceVBlank();
      
     /**
-     * Advance the LCD when when searching OAM memory
+     * Advance the LCD when searching OAM memory has finished.
      */
     void advanceSearchOam();
      
     /**
-     * Advance the LCD when when transfering to the LCD driver.
+     * Advance the LCD when transfering to the LCD driver has finished.
      */
     void advanceTransfer();
 
+    /**
+     * Step the LCD while it is switched off. Nothing is drawn, but a blank 
+     * frame is presented once every frame's worth of cycles.
+     */
+    void stepOff(int cycles);
+
+    /**
+     * Called when the LCD is switched on. Restarts the LCD from the first
+     * scanline.
+     */
+    void switchOn();
+
+    /**
+     * Called when the LCD is switched off. LY is reset and the screen is
+     * cleared.
+     */
+    void switchOff();
+
+    /**
+     * Called when the LCD starts a new frame, decides whether the frame 
+     * will be drawn or skipped.
+     */
+    void startFrame();
+
     void setMode(LcdMode mode);
     void incrementScanLine();
     void drawScanLine();
+
+    /**
+     * Finds the scanlines that changed since the last frame and converts them
+     * into the client's pixels, if it has any.
+     */
+    void presentFrame();
 };
 
 #endif
@@ -4,8 +4,8 @@
 #define TILE_MAP_SELECT 0x4
 #define TILE_DATA_SELECT 0x10
 
-LcdBackground::LcdBackground(Memory* mem, uint32_t* pixels) 
-    : LcdComponent(mem, pixels)  
+LcdBackground::LcdBackground(Memory* mem, uint8_t* frame) 
+    : LcdComponent(mem, frame)  
 {
 }
 
@@ -25,7 +25,7 @@ void LcdBackground::drawScanline()
         paletteIndex |= (tileHigh >> (7 - tileX) & 1) << 1;
         int colorIndex = (ioPorts->BGP >> (paletteIndex * 2)) & 0x3;
 
-        setPixel(lcdPixels, x, ioPorts->LY, getColor(colorIndex));
+        setPixel(lcdFrame, x, ioPorts->LY, colorIndex);
 
         tileX++;
         if (tileX == 8)
@@ -15,9 +15,9 @@ public:
      * Creates the LCD background.
      *
      * @param mem Memory to read VRAM data.
-     * @param pixels Pixels to draw on.
+     * @param frame Frame of shades to draw on.
      */
-    LcdBackground(Memory* mem, uint32_t* pixels);
+    LcdBackground(Memory* mem, uint8_t* frame);
 
     virtual void drawScanline();
 
@@ -1,15 +1,15 @@
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "LcdComponent.h"
 
-LcdComponent::LcdComponent(Memory* mem, uint32_t* pixels)
+LcdComponent::LcdComponent(Memory* mem, uint8_t* frame)
 {
     memory = mem;
     ioPorts = memory->getIOMemory();
-    lcdPixels = pixels;
-}
-
-void LcdComponent::setPixel(uint32_t* pixels, int x, int y, Color color)
-{
-    pixels[y * 160 + x] = color.getColor();
+    lcdFrame = frame;
 }
 
 static Color colorCodeMap[] =
@@ -23,4 +23,56 @@ static Color colorCodeMap[] =
 Color LcdComponent::getColor(int colorCode)
 {
     return colorCodeMap[colorCode];
-}
\ No newline at end of file
+}
+
+void LcdComponent::convertFrame(const uint8_t* frame, uint32_t* pixels, 
+                                int firstLine, int numLines)
+{
+    uint32_t palette[4];
+    for (int i = 0; i < 4; i++)
+    {
+        palette[i] = colorCodeMap[i].getColor();
+    }
+
+    int i = firstLine * 160;
+    int end = (firstLine + numLines) * 160;
+#ifdef __SSE2__
+    // Widen 16 shades at a time to 32 bits, then pick each pixel's color by
+    // comparing its shade against all 4 codes.
+    __m128i zero = _mm_setzero_si128();
+    __m128i codes[4];
+    __m128i colors[4];
+    for (int c = 0; c < 4; c++)
+    {
+        codes[c] = _mm_set1_epi32(c);
+        colors[c] = _mm_set1_epi32((int)palette[c]);
+    }
+    for (; i + 16 <= end; i += 16)
+    {
+        __m128i shades8 = _mm_loadu_si128((const __m128i*)(frame + i));
+        __m128i shades16[2];
+        shades16[0] = _mm_unpacklo_epi8(shades8, zero);
+        shades16[1] = _mm_unpackhi_epi8(shades8, zero);
+        for (int half = 0; half < 2; half++)
+        {
+            __m128i shades32[2];
+            shades32[0] = _mm_unpacklo_epi16(shades16[half], zero);
+            shades32[1] = _mm_unpackhi_epi16(shades16[half], zero);
+            for (int quarter = 0; quarter < 2; quarter++)
+            {
+                __m128i out = zero;
+                for (int c = 0; c < 4; c++)
+                {
+                    __m128i match = _mm_cmpeq_epi32(shades32[quarter], codes[c]);
+                    out = _mm_or_si128(out, _mm_and_si128(match, colors[c]));
+                }
+                _mm_storeu_si128((__m128i*)(pixels + i + half * 8 + quarter * 4), out);
+            }
+        }
+    }
+#endif
+    for (; i < end; i++)
+    {
+        pixels[i] = palette[frame[i] & 0x3];
+    }
+}
@@ -11,7 +11,15 @@
 class LcdComponent
 {
 public:
-    LcdComponent(Memory* mem, uint32_t* pixels);
+    /**
+     * Creates an LCD component.
+     *
+     * @param mem Memory to read VRAM data.
+     * @param frame 160x144 frame of shades to draw on.
+     */
+    LcdComponent(Memory* mem, uint8_t* frame);
+
+    virtual ~LcdComponent() {}
     
     /**
      * Draws the current scanline, e.g LY
@@ -19,16 +27,29 @@ public:
     virtual void drawScanline() = 0;
 
     /**
-     * Sets a pixel to be a certain color.
+     * Sets a pixel to be a certain shade.
      *
-     * @param pixels The array of pixels
+     * @param frame The frame of shades.
      * @param x The x coordinate to set.
      * @param y The y coordinate to set.
-     * @param Color The color to set.
+     * @param colorCode The shade to set, 0 to 3.
      */
-    static void setPixel(uint32_t* pixels, int x, int y, Color color);
+    static void setPixel(uint8_t* frame, int x, int y, int colorCode)
+    {
+        frame[y * 160 + x] = colorCode;
+    }
 
-    static Color getPixel(uint32_t* pixels, int x, int y);
+    /**
+     * Gets the shade of a pixel.
+     *
+     * @param frame The frame of shades.
+     * @param x The x coordinate to get.
+     * @param y The y coordinate to get.
+     */
+    static int getPixel(uint8_t* frame, int x, int y)
+    {
+        return frame[y * 160 + x];
+    }
 
     /**
      * Get a color based on a color code
@@ -37,10 +58,21 @@ public:
      */
     static Color getColor(int colorCode);
 
+    /**
+     * Converts scanlines of a frame of shades into 32-bit pixels.
+     *
+     * @param frame The 160x144 frame of shades.
+     * @param pixels The 160x144 array of pixels to convert to.
+     * @param firstLine The first scanline to convert.
+     * @param numLines The number of scanlines to convert.
+     */
+    static void convertFrame(const uint8_t* frame, uint32_t* pixels, 
+                             int firstLine, int numLines);
+
  protected:
     Memory* memory;
     IOMemory* ioPorts;
-    uint32_t* lcdPixels;
+    uint8_t* lcdFrame;
 };
 
 #endif
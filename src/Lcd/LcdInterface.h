@@ -9,11 +9,15 @@
 class LcdInterface
 {
 public:
+    virtual ~LcdInterface() {}
+
     /**
-     * Initialize the LCD with an array of pixels. The LCD will "draw" on these
-     * pixels
+     * Initialize the LCD with an array of pixels. The LCD draws each frame
+     * as shades, see getFrame(), and converts them into these pixels once the
+     * frame is complete.
      *
-     * @param pixels 160x144 array of pixels.
+     * @param pixels 160x144 array of pixels, or NULL if the client only
+     * needs the shades.
      */
     virtual void init(uint32_t* pixels) = 0;
 
@@ -37,6 +41,49 @@ public:
      * to notify the LCD that it is no longer in a dirty state.
      */
     virtual void clean() = 0;
+
+    /**
+     * Gets the last frame the LCD has drawn, as one byte per pixel holding the
+     * shade (0 to 3) after the palette has been applied. This is a quarter 
+     * of the size of the 32-bit pixels, so it is cheaper to compare, hash or
+     * copy.
+     *
+     * @return 160x144 array of shades.
+     */
+    virtual const uint8_t* getFrame() = 0;
+
+    /**
+     * Checks if a scanline changed in the last frame that was drawn, compared
+     * to the frame before it. Clients only need to update the scanlines that
+     * changed.
+     *
+     * @param line The scanline, 0 to 143.
+     * @return True if the scanline changed, false otherwise.
+     */
+    virtual bool isLineDirty(int line) = 0;
+
+    /**
+     * Gets the number of scanlines that changed in the last frame that was 
+     * drawn. If it is 0 the client does not need to update the screen at all.
+     */
+    virtual int getDirtyLineCount() = 0;
+
+    /**
+     * Gets the cycle at which the LCD next changes mode (OAM search, transfer,
+     * H-Blank, or the next V-Blank line). Stepping the LCD before this cycle
+     * has no visible effect, so the client can accumulate cycles and only call
+     * step() once its own cycle count reaches this value.
+     *
+     * This is deliberately not virtual, the client checks it after every 
+     * instruction.
+     *
+     * @return The absolute cycle, counted over every call to step().
+     */
+    uint64_t getNextEventCycle() { return nextEventCycle; }
+
+protected:
+    /* Absolute cycle of the next mode transition. */
+    uint64_t nextEventCycle;
 };
 
 #endif
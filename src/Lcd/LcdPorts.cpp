@@ -0,0 +1,25 @@
+#include "LcdPorts.h"
+#include "Lcd.h"
+
+#define LCDC_ADDR 0xFF40
+#define LCD_ENABLED 0x80
+
+LcdPorts::LcdPorts(IOMemory* io, Lcd* lcd)
+{
+    ioPorts = io;
+    gbLcd = lcd;
+}
+
+data_t LcdPorts::read(addr_t addr)
+{
+    return ioPorts->read(addr);
+}
+
+void LcdPorts::write(addr_t addr, data_t val)
+{
+    if (addr == LCDC_ADDR && ((ioPorts->LCDC ^ val) & LCD_ENABLED))
+    {
+        gbLcd->wake();
+    }
+    ioPorts->write(addr, val);
+}
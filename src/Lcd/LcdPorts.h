@@ -0,0 +1,37 @@
+#ifndef _LCD_PORTS_H_
+#define _LCD_PORTS_H_
+
+#include "../Memory/MemoryCustomizer.h"
+#include "../Memory/Customizers/IOMemory.h"
+
+class Lcd;
+
+/**
+ * @brief Watches writes to the I/O ports for the LCD.
+ *
+ * Writes are passed through to the I/O ports unchanged. When the LCD is 
+ * switched on or off through LCDC, the LCD is woken up so that it can be
+ * stepped straight away, rather than at its next scheduled event.
+ */
+class LcdPorts : public MemoryCustomizer
+{
+public:
+    /**
+     * Creates the LCD port watcher.
+     *
+     * @param io The I/O ports to pass reads and writes to.
+     * @param lcd The LCD to wake up.
+     */
+    LcdPorts(IOMemory* io, Lcd* lcd);
+
+    // 0xFF00-0xFF7F
+    virtual data_t read(addr_t addr);
+    // 0xFF00-0xFF7F
+    virtual void write(addr_t addr, data_t val);
+
+private:
+    IOMemory* ioPorts;
+    Lcd* gbLcd;
+};
+
+#endif
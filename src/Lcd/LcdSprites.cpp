@@ -1,7 +1,7 @@
 #include "LcdSprites.h"
 
-LcdSprites::LcdSprites(Memory* mem, uint32_t* pixels)
-    : LcdComponent(mem, pixels)
+LcdSprites::LcdSprites(Memory* mem, uint8_t* frame)
+    : LcdComponent(mem, frame)
 {
 }
 
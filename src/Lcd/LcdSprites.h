@@ -8,7 +8,7 @@
 class LcdSprites : public LcdComponent
 {
 public:
-    LcdSprites(Memory* mem, uint32_t* pixels);
+    LcdSprites(Memory* mem, uint8_t* frame);
     virtual void drawScanline();
 };
 
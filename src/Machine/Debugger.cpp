@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <string.h>
+
+#include "Debugger.h"
+
+/**
+ * @brief Checks accesses to an address range against the watchpoints.
+ *
+ * Every access is passed on to the listener that was registered for the
+ * range. Save states are too, so they are the same with or without
+ * watchpoints.
+ */
+class WatchMemory : public MemoryInterface
+{
+public:
+    WatchMemory(MemoryInterface* target, Debugger* debugger)
+        : target(target), debugger(debugger)
+    {
+    }
+
+    data_t read(addr_t addr)
+    {
+        debugger->checkAccess(addr, Debugger::WATCH_READ);
+        return target->read(addr);
+    }
+
+    void write(addr_t addr, data_t val)
+    {
+        debugger->checkAccess(addr, Debugger::WATCH_WRITE);
+        target->write(addr, val);
+    }
+
+    data_t peek(addr_t addr) { return target->peek(addr); }
+
+    void saveState(StateWriter* state) { target->saveState(state); }
+    bool loadState(StateReader* state) { return target->loadState(state); }
+
+    MemoryInterface* getTarget() { return target; }
+
+private:
+    MemoryInterface* target;
+    Debugger* debugger;
+};
+
+Debugger::Debugger(Memory* memory)
+    : memory(memory), breakpoints(0x10000)
+{
+    passBreakpoint = false;
+    memset(watchPages, 0, sizeof(watchPages));
+    for (int i = 0; i < ADDRESS_RANGE_SIZE; i++)
+    {
+        watchReaders[i] = NULL;
+        watchWriters[i] = NULL;
+    }
+    inInstruction = false;
+    stepping = false;
+    reason = NOT_STOPPED;
+    stopAddress = 0;
+    stopAccess = 0;
+}
+
+Debugger::~Debugger()
+{
+    clear();
+}
+
+void Debugger::addBreakpoint(uint16_t addr)
+{
+    breakpoints[addr] = 1;
+}
+
+void Debugger::removeBreakpoint(uint16_t addr)
+{
+    breakpoints[addr] = 0;
+}
+
+void Debugger::addWatchpoint(uint16_t addr, int type)
+{
+    watchpoints[addr] |= type & WATCH_ACCESS;
+    updateWatches();
+}
+
+void Debugger::removeWatchpoint(uint16_t addr, int type)
+{
+    std::map<uint16_t, int>::iterator it = watchpoints.find(addr);
+    if (it == watchpoints.end())
+    {
+        return;
+    }
+    it->second &= ~type;
+    if (it->second == 0)
+    {
+        watchpoints.erase(it);
+    }
+    updateWatches();
+}
+
+void Debugger::clear()
+{
+    std::fill(breakpoints.begin(), breakpoints.end(), 0);
+    watchpoints.clear();
+    updateWatches();
+}
+
+void Debugger::resume()
+{
+    passBreakpoint = reason == BREAKPOINT;
+    reason = NOT_STOPPED;
+    stepping = false;
+}
+
+void Debugger::step()
+{
+    resume();
+    // The instruction runs even if it has a breakpoint, as it was asked for.
+    passBreakpoint = true;
+    stepping = true;
+}
+
+void Debugger::stop(StopReason why, uint16_t addr, int access)
+{
+    reason = why;
+    stopAddress = addr;
+    stopAccess = access;
+    stepping = false;
+}
+
+void Debugger::checkWatchpoint(addr_t addr, int type)
+{
+    std::map<uint16_t, int>::const_iterator it = watchpoints.find(addr);
+    if (it != watchpoints.end() && (it->second & type) && reason == NOT_STOPPED)
+    {
+        stop(WATCHPOINT, addr, type);
+    }
+}
+
+void Debugger::updateWatches()
+{
+    memset(watchPages, 0, sizeof(watchPages));
+    bool watchedRanges[ADDRESS_RANGE_SIZE] = { false };
+    for (std::map<uint16_t, int>::const_iterator it = watchpoints.begin();
+         it != watchpoints.end(); ++it)
+    {
+        watchPages[it->first >> 8] |= it->second;
+        watchedRanges[Memory::getAddressRange(it->first)] = true;
+    }
+
+    // Put the listeners back, then watch them all again.
+    std::vector<WatchMemory*> unused;
+    for (int i = 0; i < ADDRESS_RANGE_SIZE; i++)
+    {
+        Memory::AddressRange range = (Memory::AddressRange)i;
+        if (watchReaders[i] != NULL)
+        {
+            memory->registerReadListener(range, watchReaders[i]->getTarget());
+            unused.push_back(watchReaders[i]);
+            watchReaders[i] = NULL;
+        }
+        if (watchWriters[i] != NULL)
+        {
+            memory->registerWriteListener(range, watchWriters[i]->getTarget());
+            unused.push_back(watchWriters[i]);
+            watchWriters[i] = NULL;
+        }
+    }
+
+    // Memory registered for several ranges, or for reads and writes, has
+    // to stay one object wherever it is registered, or save states would
+    // see several listeners and save it twice. So it is watched everywhere
+    // as soon as one of its ranges is.
+    std::map<MemoryInterface*, WatchMemory*> watches;
+    for (int i = 0; i < ADDRESS_RANGE_SIZE; i++)
+    {
+        if (watchedRanges[i])
+        {
+            Memory::AddressRange range = (Memory::AddressRange)i;
+            watches[memory->getReadListener(range)] = NULL;
+            watches[memory->getWriteListener(range)] = NULL;
+        }
+    }
+    for (std::map<MemoryInterface*, WatchMemory*>::iterator it = watches.begin();
+         it != watches.end(); ++it)
+    {
+        it->second = new WatchMemory(it->first, this);
+    }
+    for (int i = 0; i < ADDRESS_RANGE_SIZE && !watches.empty(); i++)
+    {
+        Memory::AddressRange range = (Memory::AddressRange)i;
+        std::map<MemoryInterface*, WatchMemory*>::iterator reader =
+            watches.find(memory->getReadListener(range));
+        if (reader != watches.end())
+        {
+            watchReaders[i] = reader->second;
+            memory->registerReadListener(range, reader->second);
+        }
+        std::map<MemoryInterface*, WatchMemory*>::iterator writer =
+            watches.find(memory->getWriteListener(range));
+        if (writer != watches.end())
+        {
+            watchWriters[i] = writer->second;
+            memory->registerWriteListener(range, writer->second);
+        }
+    }
+
+    std::sort(unused.begin(), unused.end());
+    unused.erase(std::unique(unused.begin(), unused.end()), unused.end());
+    for (size_t i = 0; i < unused.size(); i++)
+    {
+        delete unused[i];
+    }
+}
@@ -0,0 +1,177 @@
+#ifndef _DEBUGGER_H_
+#define _DEBUGGER_H_
+
+#include <map>
+#include <stdint.h>
+#include <vector>
+
+#include "../Memory/Memory.h"
+
+class WatchMemory;
+
+/**
+ * @brief Breakpoints and watchpoints, as a debug policy.
+ *
+ * The debugger is passed to GBMachine::runUntilWith() or stepWith(), see
+ * DebugPolicy.h. Machines run with the plain runUntil() are not checked at
+ * all.
+ *
+ * Breakpoints stop the machine before the instruction at their address
+ * runs. Watchpoints stop it after the instruction that read or wrote their
+ * address. To watch an address, the listeners of its AddressRange in
+ * Memory are put behind a WatchMemory that checks every access, wherever
+ * else they are registered too, so ranges without watchpoints are accessed
+ * as fast as ever and save states still see each listener once. Inside a watched range,
+ * a table of 256 byte pages rules out most accesses with a single lookup.
+ *
+ * I/O registers are watched the same way, at 0xFF00 to 0xFF7F and 0xFFFF.
+ * Only accesses made by the CPU are seen, not those of the LCD.
+ */
+class Debugger
+{
+public:
+    /** What a watchpoint watches for. */
+    enum WatchType
+    {
+        WATCH_READ = 1,
+        WATCH_WRITE = 2,
+        WATCH_ACCESS = WATCH_READ | WATCH_WRITE
+    };
+
+    /** Why the machine stopped. */
+    enum StopReason
+    {
+        NOT_STOPPED,
+        BREAKPOINT,
+        WATCHPOINT,
+        /** step() finished its instruction. */
+        STEPPED
+    };
+
+    /**
+     * @param memory The memory to watch.
+     */
+    Debugger(Memory* memory);
+
+    /**
+     * Removes every watchpoint, giving Memory its listeners back.
+     */
+    ~Debugger();
+
+    void addBreakpoint(uint16_t addr);
+    void removeBreakpoint(uint16_t addr);
+    bool hasBreakpoint(uint16_t addr) const { return breakpoints[addr] != 0; }
+
+    /**
+     * Watches an address. Adding a watchpoint that is already there adds
+     * the new type to it.
+     *
+     * @param addr The address to watch.
+     * @param type What to watch for, a WatchType.
+     */
+    void addWatchpoint(uint16_t addr, int type);
+
+    /**
+     * Stops watching an address for some types of access.
+     */
+    void removeWatchpoint(uint16_t addr, int type = WATCH_ACCESS);
+
+    /**
+     * Removes every breakpoint and watchpoint.
+     */
+    void clear();
+
+    /**
+     * Lets the machine run again after it stopped. If it stopped at a
+     * breakpoint, that instruction runs this time.
+     */
+    void resume();
+
+    /**
+     * Stops after the next instruction, even if it is at a breakpoint.
+     */
+    void step();
+
+    StopReason getStopReason() const { return reason; }
+
+    /**
+     * Gets the breakpoint, or the watched address, the machine stopped at.
+     */
+    uint16_t getStopAddress() const { return stopAddress; }
+
+    /**
+     * Gets the WatchType of the access that hit a watchpoint.
+     */
+    int getStopAccess() const { return stopAccess; }
+
+    /* The debug policy, see DebugPolicy.h. */
+    bool beforeInstruction(uint16_t pc)
+    {
+        if (reason != NOT_STOPPED)
+        {
+            return true;
+        }
+        if (breakpoints[pc] && !passBreakpoint)
+        {
+            stop(BREAKPOINT, pc, 0);
+            return true;
+        }
+        passBreakpoint = false;
+        inInstruction = true;
+        return false;
+    }
+
+    void afterInstruction()
+    {
+        inInstruction = false;
+        if (stepping && reason == NOT_STOPPED)
+        {
+            stop(STEPPED, 0, 0);
+        }
+    }
+
+    bool isStopped() const { return reason != NOT_STOPPED; }
+
+    /**
+     * Checks an access against the watchpoints. Called by WatchMemory.
+     */
+    void checkAccess(addr_t addr, int type)
+    {
+        if (inInstruction && (watchPages[addr >> 8] & type))
+        {
+            checkWatchpoint(addr, type);
+        }
+    }
+
+private:
+    void stop(StopReason reason, uint16_t addr, int access);
+    void checkWatchpoint(addr_t addr, int type);
+
+    /**
+     * Works out watchPages again, and watches or unwatches the address
+     * ranges that need it.
+     */
+    void updateWatches();
+
+    Memory* memory;
+
+    std::vector<uint8_t> breakpoints;
+    /* Whether to run the next instruction even if it has a breakpoint. */
+    bool passBreakpoint;
+
+    std::map<uint16_t, int> watchpoints;
+    /* The WatchTypes watched in each 256 byte page. */
+    uint8_t watchPages[0x100];
+    /* The WatchMemory in front of each range, or NULL. Ranges and
+       directions sharing a listener share its WatchMemory too. */
+    WatchMemory* watchReaders[ADDRESS_RANGE_SIZE];
+    WatchMemory* watchWriters[ADDRESS_RANGE_SIZE];
+
+    bool inInstruction;
+    bool stepping;
+    StopReason reason;
+    uint16_t stopAddress;
+    int stopAccess;
+};
+
+#endif
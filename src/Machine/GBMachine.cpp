@@ -0,0 +1,136 @@
+#include "../Common/PerfCounters.h"
+#include "GBMachine.h"
+
+GBMachine::GBMachine(Memory* mem)
+{
+    memory = mem;
+    cpu = new Z80Cpu(memory);
+    cpu->init();
+    lcd = new Lcd(memory);
+
+    cycle = 0;
+    lcdCycle = 0;
+    lcdTime = 0;
+
+    playerButtons = 0;
+    inputScript = NULL;
+    recordLog = NULL;
+    replayLog = NULL;
+    runner = NULL;
+    perfCounters = NULL;
+}
+
+GBMachine::~GBMachine()
+{
+    delete lcd;
+    delete cpu;
+    delete memory;
+}
+
+int GBMachine::step()
+{
+    NoDebugPolicy policy;
+    return stepWith(policy);
+}
+
+void GBMachine::runFrame()
+{
+    runUntil(UINT64_MAX);
+}
+
+bool GBMachine::runUntil(uint64_t endCycle)
+{
+    if (perfCounters != NULL)
+    {
+        perfCounters->start();
+    }
+
+    bool frameDone;
+    if (runner != NULL)
+    {
+        frameDone = runner->runUntil(this, endCycle);
+    }
+    else
+    {
+        NoDebugPolicy policy;
+        frameDone = runUntilWith(endCycle, policy);
+    }
+
+    if (perfCounters != NULL)
+    {
+        perfCounters->stop();
+    }
+    return frameDone;
+}
+
+void GBMachine::setButtons(data_t buttons)
+{
+    playerButtons = buttons;
+}
+
+void GBMachine::setInputScript(InputScript* script)
+{
+    inputScript = script;
+}
+
+void GBMachine::recordInput(InputLog* log)
+{
+    recordLog = log;
+}
+
+void GBMachine::replayInput(InputLog* log)
+{
+    replayLog = log;
+}
+
+void GBMachine::saveState(StateWriter* state)
+{
+    state->clear();
+
+    state->beginChunk("MACH");
+    state->write(cycle);
+    state->write(lcdCycle);
+    state->write(playerButtons);
+    state->endChunk();
+
+    cpu->saveState(state);
+    lcd->saveState(state);
+    memory->saveState(state);
+}
+
+bool GBMachine::loadState(StateReader* state)
+{
+    if (!state->isValid())
+    {
+        return false;
+    }
+
+    if (!state->openChunk("MACH") ||
+        !state->read(&cycle) ||
+        !state->read(&lcdCycle) ||
+        !state->read(&playerButtons))
+    {
+        return false;
+    }
+    return cpu->loadState(state) && lcd->loadState(state) && 
+           memory->loadState(state);
+}
+
+void GBMachine::sampleInput()
+{
+    data_t buttons = playerButtons;
+    if (inputScript != NULL)
+    {
+        buttons |= inputScript->getButtons(lcd->getFrameCount());
+    }
+    if (replayLog != NULL)
+    {
+        buttons = replayLog->getButtons(cycle);
+    }
+    memory->getIOMemory()->setButtons(buttons);
+
+    if (recordLog != NULL)
+    {
+        recordLog->record(cycle, buttons);
+    }
+}
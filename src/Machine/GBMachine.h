@@ -0,0 +1,267 @@
+#ifndef _GB_MACHINE_H_
+#define _GB_MACHINE_H_
+
+#include <stdint.h>
+
+#include "../Common/Metrics.h"
+#include "../Common/SaveState.h"
+#include "../Cpu/DebugPolicy.h"
+#include "../Cpu/Z80Cpu.h"
+#include "../Input/InputLog.h"
+#include "../Input/InputScript.h"
+#include "../Lcd/Lcd.h"
+#include "../Memory/Memory.h"
+
+class GBMachine;
+class PerfCounters;
+
+/**
+ * Takes over running a machine, e.g. to run it under a debugger.
+ */
+class MachineRunner
+{
+public:
+    virtual ~MachineRunner() {}
+
+    /**
+     * Runs the machine in place of GBMachine::runUntil(), with the same
+     * parameters and result.
+     */
+    virtual bool runUntil(GBMachine* machine, uint64_t endCycle) = 0;
+};
+
+/**
+ * @brief A complete Game Boy, made up of its memory, CPU and LCD.
+ *
+ * The machine keeps the CPU and LCD in step with each other. The CPU is 
+ * stepped one instruction at a time, the LCD is only stepped once the CPU 
+ * reaches the LCD's next event.
+ *
+ * Input is sampled once a frame, at the start of runFrame() or runUntil().
+ *
+ * The LCD still has to be initialized by the window that displays it.
+ */
+class GBMachine
+{
+public:
+    /**
+     * Creates a Game Boy for a cartridge.
+     *
+     * @param mem Memory with the cartridge loaded. The machine takes 
+     * ownership of it.
+     */
+    GBMachine(Memory* mem);
+    ~GBMachine();
+
+    /**
+     * Executes a single instruction, and steps the LCD if it is due.
+     *
+     * @return Number of cycles the instruction took.
+     */
+    int step();
+
+    /**
+     * Executes a single instruction like step(), checking with a debug
+     * policy first.
+     *
+     * @param policy The debug policy, see DebugPolicy.h.
+     * @return Number of cycles the instruction took, 0 if the policy
+     * stopped before it.
+     */
+    template<class DebugPolicy>
+    int stepWith(DebugPolicy& policy);
+
+    /**
+     * Runs until the LCD finishes a frame. Frames count whether they are 
+     * rendered, skipped, or blank because the LCD is off.
+     */
+    void runFrame();
+
+    /**
+     * Runs until the LCD finishes a frame, or the machine reaches a cycle.
+     *
+     * @param endCycle Cycle to stop at.
+     * @return True if a frame was finished, false if the cycle was reached
+     * first.
+     */
+    bool runUntil(uint64_t endCycle);
+
+    /**
+     * Runs like runUntil(), checking with a debug policy around every
+     * instruction, and stopping early if the policy says so.
+     *
+     * @param endCycle Cycle to stop at.
+     * @param policy The debug policy, see DebugPolicy.h.
+     * @return True if a frame was finished, false if the cycle was reached
+     * or the policy stopped the machine first.
+     */
+    template<class DebugPolicy>
+    bool runUntilWith(uint64_t endCycle, DebugPolicy& policy);
+
+    /**
+     * Sets the joypad buttons the player is holding down. They are passed
+     * to the joypad when the next frame starts.
+     *
+     * @param buttons Mask of JoypadButton values.
+     */
+    void setButtons(data_t buttons);
+
+    /**
+     * Sets a script of buttons to hold down on each frame, on top of the 
+     * player's buttons.
+     *
+     * @param script The input script, or NULL for none.
+     */
+    void setInputScript(InputScript* script);
+
+    /**
+     * Records the buttons passed to the joypad.
+     *
+     * @param log The log to record to, or NULL to stop recording.
+     */
+    void recordInput(InputLog* log);
+
+    /**
+     * Replays the buttons recorded in a log, instead of the player's and 
+     * the script's buttons.
+     *
+     * @param log The log to replay, or NULL to stop replaying.
+     */
+    void replayInput(InputLog* log);
+
+    /**
+     * Writes a snapshot of the whole machine into a save state. The 
+     * cartridge ROM is not included, so a state can only be loaded into a
+     * machine running the same game.
+     *
+     * @param state The state to write to, which is cleared first.
+     */
+    void saveState(StateWriter* state);
+
+    /**
+     * Restores the machine from a save state. If the state can't be loaded
+     * the machine may be left part way between the two states.
+     *
+     * @param state The state to load.
+     * @return True if the state was loaded, false otherwise, in which case
+     * state->getErrorMessage() says why.
+     */
+    bool loadState(StateReader* state);
+
+    /**
+     * Gets the number of cycles the machine has run for.
+     */
+    uint64_t getCycle() { return cycle; }
+
+    /**
+     * Hands runFrame() and runUntil() over to a runner, which is checked
+     * once per call.
+     *
+     * @param runner The runner, or NULL to run the machine directly.
+     */
+    void setRunner(MachineRunner* runner) { this->runner = runner; }
+
+    /**
+     * Counts host CPU events around every call to runFrame() and
+     * runUntil(), leaving out the time in between.
+     *
+     * @param counters The counters, or NULL to stop counting. They are opened
+     * by the thread the machine runs on.
+     */
+    void setPerfCounters(PerfCounters* counters) { perfCounters = counters; }
+
+    Memory* getMemory() { return memory; }
+    Z80Cpu* getCpu() { return cpu; }
+    Lcd* getLcd() { return lcd; }
+
+private:
+    /**
+     * Passes the player's and the script's buttons to the joypad.
+     */
+    void sampleInput();
+
+    Memory* memory;
+    Z80Cpu* cpu;
+    Lcd* lcd;
+
+    /* Cycles run by the CPU, and how far the LCD has been stepped. */
+    uint64_t cycle;
+    uint64_t lcdCycle;
+
+    /* Host time spent stepping the LCD, for the metrics. */
+    uint64_t lcdTime;
+
+    /* Input */
+    data_t playerButtons;
+    InputScript* inputScript;
+    InputLog* recordLog;
+    InputLog* replayLog;
+
+    MachineRunner* runner;
+    PerfCounters* perfCounters;
+};
+
+template<class DebugPolicy>
+int GBMachine::stepWith(DebugPolicy& policy)
+{
+    int cycles = cpu->stepWith(policy);
+    cycle += cycles;
+    
+    // The LCD only needs to be stepped when it is about to change mode.
+    if (cycle >= lcd->getNextEventCycle())
+    {
+#ifdef GB_METRICS
+        uint64_t lcdStart = Metrics::now();
+#endif
+        lcd->step((int)(cycle - lcdCycle));
+        lcdCycle = cycle;
+#ifdef GB_METRICS
+        lcdTime += Metrics::now() - lcdStart;
+#endif
+    }
+    return cycles;
+}
+
+template<class DebugPolicy>
+bool GBMachine::runUntilWith(uint64_t endCycle, DebugPolicy& policy)
+{
+    sampleInput();
+
+#ifdef GB_METRICS
+    uint64_t startTime = Metrics::now();
+    uint64_t startCycle = cycle;
+    uint64_t instructions = 0;
+    lcdTime = 0;
+#endif
+
+    uint64_t frame = lcd->getFrameCount();
+    bool frameDone = false;
+    while (cycle < endCycle)
+    {
+        stepWith(policy);
+#ifdef GB_METRICS
+        instructions++;
+#endif
+        if (lcd->getFrameCount() != frame)
+        {
+            frameDone = true;
+            break;
+        }
+        if (policy.isStopped())
+        {
+            break;
+        }
+    }
+
+#ifdef GB_METRICS
+    // Counted once per call, rather than per instruction.
+    uint64_t time = Metrics::now() - startTime;
+    GB_METRIC_ADD(Metrics::INSTRUCTIONS, instructions);
+    GB_METRIC_ADD(Metrics::CYCLES, cycle - startCycle);
+    GB_METRIC_ADD(Metrics::LCD_NS, lcdTime);
+    GB_METRIC_ADD(Metrics::CPU_NS, time - lcdTime);
+#endif
+    return frameDone;
+}
+
+#endif
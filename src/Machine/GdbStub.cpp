@@ -0,0 +1,674 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "../Cpu/CpuProfiler.h"
+#include "../Cpu/Z80Disassembler.h"
+#include "GdbStub.h"
+
+// Signals in stop replies.
+#define SIGNAL_INT 2
+#define SIGNAL_TRAP 5
+
+// The longest packet GDB is told it can send, which it also keeps its memory
+// reads to. GDB reads the size as hex.
+#define PACKET_SIZE 0x1000
+
+// Most bytes an 'm' reply holds: two hex digits each, inside the '$', '#'
+// and checksum of the packet.
+#define MAX_READ ((PACKET_SIZE - 4) / 2)
+
+// Registers of GDB's z80 target: AF, BC, DE, HL, SP, PC, IX, IY, the four
+// shadow pairs and IR, 16 bits each.
+#define REGISTER_COUNT 13
+
+static const char hexDigits[] = "0123456789abcdef";
+
+static std::string toHex(const data_t* data, size_t size)
+{
+    std::string hex;
+    for (size_t i = 0; i < size; i++)
+    {
+        hex += hexDigits[data[i] >> 4];
+        hex += hexDigits[data[i] & 0x0F];
+    }
+    return hex;
+}
+
+/**
+ * Parses a hex number, stopping at the first character that is not hex.
+ *
+ * @param text The number, moved past it.
+ */
+static uint32_t parseHex(const char** text)
+{
+    char* end;
+    uint32_t value = (uint32_t)strtoul(*text, &end, 16);
+    *text = end;
+    return value;
+}
+
+static data_t parseHexByte(const char* text)
+{
+    char byte[3] = { text[0], text[1], '\0' };
+    return (data_t)strtoul(byte, NULL, 16);
+}
+
+GdbStub::GdbStub(GBMachine* machine)
+    : machine(machine), debugger(machine->getMemory())
+{
+    listenFd = -1;
+    connectionFd = -1;
+    halted = true;
+    stopSignal = SIGNAL_TRAP;
+    killed = false;
+    trace = NULL;
+    symbols = NULL;
+}
+
+GdbStub::~GdbStub()
+{
+    closeConnection();
+#ifndef _WIN32
+    if (listenFd >= 0)
+    {
+        close(listenFd);
+        if (!socketPath.empty())
+        {
+            unlink(socketPath.c_str());
+        }
+    }
+#endif
+}
+
+bool GdbStub::listen(const std::string& address)
+{
+#ifdef _WIN32
+    error = "The GDB stub is not supported on this platform.";
+    return false;
+#else
+    bool isPort = !address.empty() &&
+                  address.find_first_not_of("0123456789") == std::string::npos;
+    int fd;
+    if (isPort)
+    {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons((uint16_t)atoi(address.c_str()));
+        if (fd < 0 || bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0)
+        {
+            error = "Could not listen on port " + address + ": " + strerror(errno);
+            if (fd >= 0)
+                close(fd);
+            return false;
+        }
+    }
+    else
+    {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (address.size() >= sizeof(addr.sun_path))
+        {
+            error = "The socket path " + address + " is too long.";
+            return false;
+        }
+        strcpy(addr.sun_path, address.c_str());
+
+        // Only a socket left behind by an earlier run is replaced.
+        struct stat info;
+        if (lstat(address.c_str(), &info) == 0 && S_ISSOCK(info.st_mode))
+        {
+            unlink(address.c_str());
+        }
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0)
+        {
+            error = "Could not listen on " + address + ": " + strerror(errno);
+            if (fd >= 0)
+                close(fd);
+            return false;
+        }
+        socketPath = address;
+    }
+
+    if (::listen(fd, 1) != 0)
+    {
+        error = "Could not listen on " + address + ": " + strerror(errno);
+        close(fd);
+        return false;
+    }
+    listenFd = fd;
+    return true;
+#endif
+}
+
+bool GdbStub::waitForClient()
+{
+#ifdef _WIN32
+    return false;
+#else
+    int fd = accept(listenFd, NULL, NULL);
+    if (fd < 0)
+    {
+        error = std::string("Could not accept a connection: ") + strerror(errno);
+        return false;
+    }
+    // Packets are small and answered one at a time.
+    int noDelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    setConnection(fd);
+    return true;
+#endif
+}
+
+void GdbStub::setConnection(int fd)
+{
+    connectionFd = fd;
+    received.clear();
+    halted = true;
+    stopSignal = SIGNAL_TRAP;
+}
+
+void GdbStub::setTrace(CpuTrace* trace, const std::string& fileName)
+{
+    this->trace = trace;
+    traceFile = fileName;
+}
+
+void GdbStub::setSymbols(const SymbolTable* symbols)
+{
+    this->symbols = symbols;
+}
+
+std::string GdbStub::getErrorMessage()
+{
+    return error;
+}
+
+bool GdbStub::runUntil(GBMachine* gb, uint64_t endCycle)
+{
+    if (killed)
+    {
+        return false;
+    }
+
+    while (true)
+    {
+        if (connectionFd < 0)
+        {
+            // GDB is gone, so the machine runs as if it was never there.
+            NoDebugPolicy policy;
+            return gb->runUntilWith(endCycle, policy);
+        }
+
+        if (halted)
+        {
+            if (!serve())
+            {
+                return false;
+            }
+            continue;
+        }
+
+        bool frameDone = gb->runUntilWith(endCycle, debugger);
+        if (debugger.isStopped())
+        {
+            halted = true;
+            stopSignal = SIGNAL_TRAP;
+            dumpTrace();
+            sendPacket(getStopReply());
+            continue;
+        }
+
+        // The socket is only checked between frames, so the machine runs at
+        // full speed in between.
+        if (pollInterrupt())
+        {
+            halted = true;
+            stopSignal = SIGNAL_INT;
+            sendPacket(getStopReply());
+        }
+        return frameDone;
+    }
+}
+
+bool GdbStub::serve()
+{
+    std::string packet;
+    while (readPacket(&packet))
+    {
+        char command = packet.empty() ? '\0' : packet[0];
+        if (command == 'c')
+        {
+            debugger.resume();
+            halted = false;
+            return true;
+        }
+        else if (command == 's')
+        {
+            debugger.step();
+            halted = false;
+            return true;
+        }
+        else if (command == 'k')
+        {
+            closeConnection();
+            killed = true;
+            return false;
+        }
+        else if (command == 'D')
+        {
+            sendPacket("OK");
+            closeConnection();
+            return true;
+        }
+        else if (command != '\x03')
+        {
+            sendPacket(handle(packet));
+        }
+    }
+
+    // The connection was closed without detaching.
+    closeConnection();
+    return true;
+}
+
+std::string GdbStub::handle(const std::string& packet)
+{
+    const char* args = packet.c_str() + 1;
+    Memory* memory = machine->getMemory();
+    Z80Registers* registers = machine->getCpu()->GetRegisters();
+
+    switch (packet[0])
+    {
+    case '?':
+        return getStopReply();
+
+    case 'g':
+        return readRegisters();
+
+    case 'G':
+        writeRegisters(args);
+        return "OK";
+
+    case 'p':
+    {
+        uint32_t reg = parseHex(&args);
+        std::string all = readRegisters();
+        if (reg >= REGISTER_COUNT)
+        {
+            return "E01";
+        }
+        return all.substr(reg * 4, 4);
+    }
+
+    case 'P':
+    {
+        uint32_t reg = parseHex(&args);
+        if (reg >= REGISTER_COUNT || *args != '=' || strlen(args + 1) < 4)
+        {
+            return "E01";
+        }
+        uint16_t value = parseHexByte(args + 1) | (parseHexByte(args + 3) << 8);
+        RegisterPair* pairs[] = { &registers->AF, &registers->BC, &registers->DE,
+                                  &registers->HL, &registers->SP, &registers->PC };
+        if (reg < sizeof(pairs) / sizeof(pairs[0]))
+        {
+            pairs[reg]->val = value;
+        }
+        return "OK";
+    }
+
+    case 'm':
+    {
+        uint32_t addr = parseHex(&args);
+        args++;
+        uint32_t length = parseHex(&args);
+        if (length > MAX_READ)
+        {
+            // Replies may be shorter than asked for, GDB reads the rest.
+            length = MAX_READ;
+        }
+        std::string hex;
+        for (uint32_t i = 0; i < length; i++)
+        {
+            // Peeked, so GDB looking does not count as the game reading.
+            data_t value = memory->peek((addr_t)(addr + i));
+            hex += toHex(&value, 1);
+        }
+        return hex;
+    }
+
+    case 'M':
+    {
+        uint32_t addr = parseHex(&args);
+        args++;
+        uint32_t length = parseHex(&args);
+        if (*args != ':' || strlen(args + 1) < length * 2)
+        {
+            return "E01";
+        }
+        args++;
+        for (uint32_t i = 0; i < length; i++)
+        {
+            memory->write((addr_t)(addr + i), parseHexByte(args + i * 2));
+        }
+        return "OK";
+    }
+
+    case 'Z':
+    case 'z':
+    {
+        uint32_t type = parseHex(&args);
+        args++;
+        uint16_t addr = (uint16_t)parseHex(&args);
+        bool insert = packet[0] == 'Z';
+        static const int watchTypes[] =
+        {
+            0, 0, Debugger::WATCH_WRITE, Debugger::WATCH_READ,
+            Debugger::WATCH_ACCESS
+        };
+        if (type > 4)
+        {
+            return "";
+        }
+        if (type <= 1)
+        {
+            if (insert)
+                debugger.addBreakpoint(addr);
+            else
+                debugger.removeBreakpoint(addr);
+        }
+        else if (insert)
+        {
+            debugger.addWatchpoint(addr, watchTypes[type]);
+        }
+        else
+        {
+            debugger.removeWatchpoint(addr, watchTypes[type]);
+        }
+        return "OK";
+    }
+
+    case 'H':
+        return "OK";
+
+    case 'q':
+        if (packet.compare(0, 10, "qSupported") == 0)
+        {
+            char reply[32];
+            snprintf(reply, sizeof(reply), "PacketSize=%x", PACKET_SIZE);
+            return reply;
+        }
+        if (packet.compare(0, 9, "qAttached") == 0)
+            return "1";
+        if (packet.compare(0, 6, "qRcmd,") == 0)
+            return runMonitorCommand(packet.substr(6));
+        if (packet == "qC")
+            return "QC1";
+        if (packet == "qfThreadInfo")
+            return "m1";
+        if (packet == "qsThreadInfo")
+            return "l";
+        return "";
+    }
+
+    // Anything else is not supported.
+    return "";
+}
+
+std::string GdbStub::runMonitorCommand(const std::string& command)
+{
+    std::string text;
+    for (size_t i = 0; i + 1 < command.size(); i += 2)
+    {
+        text += (char)parseHexByte(command.c_str() + i);
+    }
+
+    std::string output;
+    if (text.compare(0, 5, "disas") == 0)
+    {
+        int count = atoi(text.c_str() + 5);
+        if (count <= 0)
+        {
+            count = 8;
+        }
+        Memory* memory = machine->getMemory();
+        uint16_t addr = machine->getCpu()->GetRegisters()->PC.val;
+        for (int i = 0; i < count; i++)
+        {
+            data_t bytes[3];
+            for (int b = 0; b < 3; b++)
+            {
+                bytes[b] = memory->peek((addr_t)(addr + b));
+            }
+            const char* label = symbols != NULL ? symbols->getName(addr) : NULL;
+            if (label != NULL)
+            {
+                output += std::string(label) + ":\n";
+            }
+            char line[256];
+            snprintf(line, sizeof(line), "%s  %s\n",
+                     CpuProfiler::formatAddress(addr).c_str(),
+                     Z80Disassembler::disassemble(bytes, addr, symbols).c_str());
+            output += line;
+            addr += Z80Disassembler::getLength(bytes[0]);
+        }
+    }
+    else
+    {
+        output = "Commands: disas [count]\n";
+    }
+
+    // Console output goes in its own packet, before the reply.
+    sendPacket("O" + toHex((const data_t*)output.data(), output.size()));
+    return "OK";
+}
+
+std::string GdbStub::getStopReply()
+{
+    char reply[32];
+    if (stopSignal == SIGNAL_TRAP &&
+        debugger.getStopReason() == Debugger::WATCHPOINT)
+    {
+        int access = debugger.getStopAccess();
+        const char* kind = access == Debugger::WATCH_READ ? "rwatch" : "watch";
+        snprintf(reply, sizeof(reply), "T%02x%s:%04x;", stopSignal, kind,
+                 debugger.getStopAddress());
+    }
+    else
+    {
+        snprintf(reply, sizeof(reply), "S%02x", stopSignal);
+    }
+    return reply;
+}
+
+std::string GdbStub::readRegisters()
+{
+    Z80Registers* registers = machine->getCpu()->GetRegisters();
+    uint16_t values[REGISTER_COUNT] =
+    {
+        registers->AF.val, registers->BC.val, registers->DE.val,
+        registers->HL.val, registers->SP.val, registers->PC.val
+    };
+    data_t bytes[REGISTER_COUNT * 2];
+    for (int i = 0; i < REGISTER_COUNT; i++)
+    {
+        bytes[i * 2] = values[i] & 0xFF;
+        bytes[i * 2 + 1] = values[i] >> 8;
+    }
+    return toHex(bytes, sizeof(bytes));
+}
+
+void GdbStub::writeRegisters(const std::string& hex)
+{
+    Z80Registers* registers = machine->getCpu()->GetRegisters();
+    RegisterPair* pairs[] = { &registers->AF, &registers->BC, &registers->DE,
+                              &registers->HL, &registers->SP, &registers->PC };
+    for (size_t i = 0; i < sizeof(pairs) / sizeof(pairs[0]); i++)
+    {
+        if (hex.size() < (i + 1) * 4)
+        {
+            break;
+        }
+        const char* value = hex.c_str() + i * 4;
+        pairs[i]->val = parseHexByte(value) | (parseHexByte(value + 2) << 8);
+    }
+}
+
+bool GdbStub::readPacket(std::string* packet)
+{
+#ifdef _WIN32
+    return false;
+#else
+    while (connectionFd >= 0)
+    {
+        // Acknowledgements of what was sent are not checked.
+        while (!received.empty() && (received[0] == '+' || received[0] == '-'))
+        {
+            received.erase(0, 1);
+        }
+        if (!received.empty() && received[0] == '\x03')
+        {
+            received.erase(0, 1);
+            *packet = "\x03";
+            return true;
+        }
+
+        size_t start = received.find('$');
+        size_t end = received.find('#', start);
+        if (start != std::string::npos && end != std::string::npos &&
+            end + 3 <= received.size())
+        {
+            std::string body = received.substr(start + 1, end - start - 1);
+            data_t checksum = parseHexByte(received.c_str() + end + 1);
+            received.erase(0, end + 3);
+
+            data_t sum = 0;
+            for (size_t i = 0; i < body.size(); i++)
+            {
+                sum += (data_t)body[i];
+            }
+            if (sum != checksum)
+            {
+                send(connectionFd, "-", 1, MSG_NOSIGNAL);
+                continue;
+            }
+            send(connectionFd, "+", 1, MSG_NOSIGNAL);
+            *packet = body;
+            return true;
+        }
+
+        char buffer[1024];
+        ssize_t n = recv(connectionFd, buffer, sizeof(buffer), 0);
+        if (n <= 0)
+        {
+            return false;
+        }
+        received.append(buffer, n);
+    }
+    return false;
+#endif
+}
+
+bool GdbStub::pollInterrupt()
+{
+#ifdef _WIN32
+    return false;
+#else
+    struct pollfd fds;
+    fds.fd = connectionFd;
+    fds.events = POLLIN;
+    if (poll(&fds, 1, 0) <= 0)
+    {
+        return false;
+    }
+
+    char buffer[1024];
+    ssize_t n = recv(connectionFd, buffer, sizeof(buffer), 0);
+    if (n <= 0)
+    {
+        closeConnection();
+        return false;
+    }
+    received.append(buffer, n);
+
+    size_t interrupt = received.find('\x03');
+    if (interrupt == std::string::npos)
+    {
+        return false;
+    }
+    received.erase(interrupt, 1);
+    return true;
+#endif
+}
+
+bool GdbStub::sendPacket(const std::string& packet)
+{
+#ifdef _WIN32
+    return false;
+#else
+    data_t sum = 0;
+    for (size_t i = 0; i < packet.size(); i++)
+    {
+        sum += (data_t)packet[i];
+    }
+    std::string framed = "$" + packet + "#" + toHex(&sum, 1);
+
+    size_t sent = 0;
+    while (sent < framed.size())
+    {
+        ssize_t n = send(connectionFd, framed.data() + sent,
+                         framed.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+        {
+            return false;
+        }
+        sent += n;
+    }
+    return true;
+#endif
+}
+
+void GdbStub::closeConnection()
+{
+#ifndef _WIN32
+    if (connectionFd >= 0)
+    {
+        close(connectionFd);
+    }
+#endif
+    connectionFd = -1;
+    received.clear();
+    debugger.clear();
+    debugger.resume();
+    halted = false;
+}
+
+void GdbStub::dumpTrace()
+{
+    Debugger::StopReason reason = debugger.getStopReason();
+    if (trace != NULL &&
+        (reason == Debugger::BREAKPOINT || reason == Debugger::WATCHPOINT))
+    {
+        trace->save(traceFile.c_str());
+    }
+}
@@ -0,0 +1,153 @@
+#ifndef _GDB_STUB_H_
+#define _GDB_STUB_H_
+
+#include <string>
+
+#include "../Cpu/CpuTrace.h"
+#include "../Cpu/SymbolTable.h"
+#include "Debugger.h"
+#include "GBMachine.h"
+
+/**
+ * @brief Lets GDB debug a running machine, over the remote serial protocol.
+ *
+ * The stub listens on a TCP port on localhost or on a Unix socket, and
+ * takes over running the machine once GDB connects. It supports reading
+ * and writing the registers and memory, single steps, continuing, and
+ * breakpoints and watchpoints through a Debugger.
+ *
+ * Registers are laid out as GDB's z80 target has them, so connect with
+ * "set architecture z80" then "target remote localhost:<port>". AF, BC,
+ * DE, HL, SP and PC are the Game Boy's, the rest are always 0.
+ *
+ * GDB's z80 disassembler does not know the Game Boy's own opcodes, so
+ * "monitor disas [count]" disassembles from PC with Z80Disassembler instead.
+ *
+ * While the machine is stopped, the stub waits for GDB. While it continues,
+ * it runs at full speed and only checks the socket for an interrupt at the
+ * end of every frame.
+ */
+class GdbStub : public MachineRunner
+{
+public:
+    /**
+     * @param machine The machine to debug.
+     */
+    GdbStub(GBMachine* machine);
+    ~GdbStub();
+
+    /**
+     * Listens for GDB.
+     *
+     * @param address A port number to listen on localhost, or the path of
+     * a Unix socket.
+     * @return false if it could not listen, see getErrorMessage().
+     */
+    bool listen(const std::string& address);
+
+    /**
+     * Waits until GDB connects. The machine starts out stopped, so that
+     * breakpoints can be set before it runs.
+     *
+     * @return false if no connection could be accepted.
+     */
+    bool waitForClient();
+
+    /**
+     * Talks to GDB over a socket that is already connected.
+     */
+    void setConnection(int fd);
+
+    /**
+     * Writes a trace to a file whenever a breakpoint or watchpoint is hit.
+     *
+     * @param trace The trace, or NULL for none.
+     * @param fileName The file to write it to.
+     */
+    void setTrace(CpuTrace* trace, const std::string& fileName);
+
+    /**
+     * Names the addresses in "monitor disas" with symbols.
+     *
+     * @param symbols The symbols, or NULL for none.
+     */
+    void setSymbols(const SymbolTable* symbols);
+
+    /**
+     * Runs the machine as GDB tells it to, see MachineRunner.
+     *
+     * @return True if a frame was finished, false if the end cycle was
+     * reached, or GDB killed the machine.
+     */
+    bool runUntil(GBMachine* machine, uint64_t endCycle);
+
+    std::string getErrorMessage();
+
+private:
+    /**
+     * Answers GDB until it tells the machine to run.
+     *
+     * @return false if GDB killed the machine.
+     */
+    bool serve();
+
+    /**
+     * Reads the next packet, acknowledging it.
+     *
+     * @param packet Set to the packet, or to "\x03" for an interrupt.
+     * @return false if the connection was closed.
+     */
+    bool readPacket(std::string* packet);
+
+    /**
+     * Checks, without waiting, whether GDB asked to interrupt the machine.
+     */
+    bool pollInterrupt();
+
+    bool sendPacket(const std::string& packet);
+
+    /**
+     * Handles a packet that does not make the machine run.
+     *
+     * @return The reply.
+     */
+    std::string handle(const std::string& packet);
+
+    /**
+     * Runs a "monitor" command, sending its output to GDB.
+     *
+     * @param command The command, hex encoded as GDB sends it.
+     */
+    std::string runMonitorCommand(const std::string& command);
+
+    std::string getStopReply();
+    std::string readRegisters();
+    void writeRegisters(const std::string& hex);
+    void closeConnection();
+
+    /**
+     * Writes the trace, if there is one, after stopping at a breakpoint or
+     * watchpoint.
+     */
+    void dumpTrace();
+
+    GBMachine* machine;
+    Debugger debugger;
+
+    int listenFd;
+    int connectionFd;
+    std::string socketPath;
+    std::string received;
+
+    /* Whether GDB has the machine stopped, and the signal it stopped with. */
+    bool halted;
+    int stopSignal;
+    bool killed;
+
+    CpuTrace* trace;
+    std::string traceFile;
+    const SymbolTable* symbols;
+    std::string error;
+};
+
+#endif
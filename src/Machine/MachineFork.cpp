@@ -0,0 +1,196 @@
+#include "MachineFork.h"
+
+#ifndef _WIN32
+#include <errno.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+MachineFork::MachineFork(GBMachine* machine)
+{
+    gbMachine = machine;
+}
+
+#ifdef _WIN32
+
+bool MachineFork::run(int children, ForkJob* job)
+{
+    error = "Forking is not supported on Windows.";
+    return false;
+}
+
+#else
+
+/**
+ * Writes all of a buffer to a pipe.
+ */
+static bool writeAll(int fd, const uint8_t* data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t written = write(fd, data, size);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+bool MachineFork::run(int children, ForkJob* job)
+{
+    results.assign(children, std::vector<uint8_t>());
+    error.clear();
+
+    std::vector<pid_t> pids(children, -1);
+    std::vector<int> pipes(children, -1);
+    bool ok = true;
+
+    for (int i = 0; i < children; i++)
+    {
+        int fds[2];
+        if (pipe(fds) != 0)
+        {
+            error = "Could not create a pipe for a child.";
+            ok = false;
+            break;
+        }
+
+        pid_t pid = fork();
+        if (pid < 0)
+        {
+            close(fds[0]);
+            close(fds[1]);
+            error = "Could not fork a child.";
+            ok = false;
+            break;
+        }
+        if (pid == 0)
+        {
+            // The child: close the other children's pipes, run the job and 
+            // send back the result. _exit() skips destructors and atexit 
+            // handlers that belong to the parent, and an exception must not
+            // unwind into the parent's code either.
+            close(fds[0]);
+            for (int j = 0; j < i; j++)
+            {
+                close(pipes[j]);
+            }
+            try
+            {
+                std::vector<uint8_t> result;
+                job->run(gbMachine, i, &result);
+                bool sent = result.empty() || 
+                            writeAll(fds[1], &result[0], result.size());
+                close(fds[1]);
+                _exit(sent ? 0 : 1);
+            }
+            catch (...)
+            {
+                _exit(1);
+            }
+        }
+
+        close(fds[1]);
+        pids[i] = pid;
+        pipes[i] = fds[0];
+    }
+
+    // Read every pipe at once, so a child never blocks on a full pipe while
+    // the parent waits on another.
+    std::vector<struct pollfd> polls;
+    std::vector<int> owners;
+    for (int i = 0; i < children; i++)
+    {
+        if (pipes[i] >= 0)
+        {
+            struct pollfd p;
+            p.fd = pipes[i];
+            p.events = POLLIN;
+            p.revents = 0;
+            polls.push_back(p);
+            owners.push_back(i);
+        }
+    }
+    uint8_t buffer[65536];
+    size_t open = polls.size();
+    while (open > 0)
+    {
+        if (poll(&polls[0], polls.size(), -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            error = "Could not read from the children.";
+            ok = false;
+            break;
+        }
+        for (size_t i = 0; i < polls.size(); i++)
+        {
+            if (polls[i].fd < 0 || polls[i].revents == 0)
+            {
+                continue;
+            }
+            ssize_t count = read(polls[i].fd, buffer, sizeof(buffer));
+            if (count > 0)
+            {
+                std::vector<uint8_t>& result = results[owners[i]];
+                result.insert(result.end(), buffer, buffer + count);
+            }
+            else if (count == 0 || errno != EINTR)
+            {
+                close(polls[i].fd);
+                polls[i].fd = -1;
+                open--;
+            }
+        }
+    }
+    for (size_t i = 0; i < polls.size(); i++)
+    {
+        if (polls[i].fd >= 0)
+        {
+            close(polls[i].fd);
+        }
+    }
+
+    for (int i = 0; i < children; i++)
+    {
+        if (pids[i] < 0)
+        {
+            continue;
+        }
+        int status = 0;
+        pid_t waited;
+        do
+        {
+            waited = waitpid(pids[i], &status, 0);
+        } while (waited < 0 && errno == EINTR);
+        if (waited < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            error = "A child did not finish.";
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+#endif
+
+const std::vector<uint8_t>& MachineFork::getResult(int child)
+{
+    return results[child];
+}
+
+std::string MachineFork::getErrorMessage()
+{
+    return error;
+}
@@ -0,0 +1,78 @@
+#ifndef _MACHINE_FORK_H_
+#define _MACHINE_FORK_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "GBMachine.h"
+
+/**
+ * Work done by each child of a MachineFork.
+ */
+class ForkJob
+{
+public:
+    virtual ~ForkJob() {}
+
+    /**
+     * Runs in each child process, on the child's own copy of the machine.
+     *
+     * @param machine The child's machine, in the state it was forked in.
+     * @param child Index of the child, e.g. to choose its input.
+     * @param[out] result Anything to send back to the parent.
+     */
+    virtual void run(GBMachine* machine, int child, std::vector<uint8_t>* result) = 0;
+};
+
+/**
+ * @brief Forks a running machine into several children that carry on 
+ * independently.
+ *
+ * Each child is a process made with fork(), so it starts with the exact 
+ * state of the machine without copying anything: the OS shares every page 
+ * of memory copy-on-write, and only the pages a child writes to are copied. 
+ * This makes exploring many branches from one state cheap, e.g. trying 
+ * different input from the same point in a game.
+ *
+ * Children run at the same time, and send their results back to the parent
+ * through a pipe. Nothing a child does changes the parent's machine.
+ *
+ * Forking only copies the thread that calls fork(), so it should be done 
+ * from a process running headless.
+ */
+class MachineFork
+{
+public:
+    /**
+     * @param machine The machine to fork.
+     */
+    MachineFork(GBMachine* machine);
+
+    /**
+     * Forks the machine, runs a job in every child, and waits for them all
+     * to finish.
+     *
+     * @param children Number of children.
+     * @param job The job to run in each child.
+     * @return True if every child finished, false otherwise.
+     */
+    bool run(int children, ForkJob* job);
+
+    /**
+     * Gets the result sent back by a child.
+     */
+    const std::vector<uint8_t>& getResult(int child);
+
+    /**
+     * Gets the reason a fork failed.
+     */
+    std::string getErrorMessage();
+
+private:
+    GBMachine* gbMachine;
+    std::vector<std::vector<uint8_t> > results;
+    std::string error;
+};
+
+#endif
@@ -0,0 +1,192 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "RewindBuffer.h"
+#include "../Common/DeltaCompression.h"
+
+RewindBuffer::RewindBuffer(size_t budget, int keyframeInterval)
+{
+    ring.resize(budget);
+    this->keyframeInterval = keyframeInterval < 1 ? 1 : keyframeInterval;
+    clear();
+}
+
+void RewindBuffer::capture(GBMachine* machine)
+{
+    machine->saveState(&writer);
+    const uint8_t* state = writer.getData();
+    size_t stateSize = writer.getSize();
+
+    // A keyframe is needed when the last one is too old, or there is nothing
+    // to make a delta against.
+    bool keyframe = entries.empty() || sinceKeyframe + 1 >= keyframeInterval ||
+                    keyframeState.size() != stateSize;
+
+    encoded.resize(getMaxDeltaSize(stateSize));
+    size_t size = encodeDelta(state, keyframe ? NULL : &keyframeState[0], 
+                              stateSize, &encoded[0]);
+    size_t offset = allocate(size);
+    if (offset == SIZE_MAX)
+    {
+        return;
+    }
+    if (!keyframe && entries.empty())
+    {
+        // Making space dropped the keyframe the delta was made against.
+        keyframe = true;
+        size = encodeDelta(state, NULL, stateSize, &encoded[0]);
+        offset = allocate(size);
+        if (offset == SIZE_MAX)
+        {
+            return;
+        }
+    }
+
+    memcpy(&ring[offset], &encoded[0], size);
+    Entry entry;
+    entry.offset = offset;
+    entry.size = size;
+    entry.keyframe = keyframe;
+    entries.push_back(entry);
+    usedBytes += size;
+
+    if (keyframe)
+    {
+        keyframeState.assign(state, state + stateSize);
+        sinceKeyframe = 0;
+    }
+    else
+    {
+        sinceKeyframe++;
+    }
+}
+
+bool RewindBuffer::rewind(GBMachine* machine)
+{
+    if (entries.empty())
+    {
+        return false;
+    }
+
+    Entry entry = entries.back();
+    entries.pop_back();
+    usedBytes -= entry.size;
+
+    decoded.resize(keyframeState.size());
+    bool decodedOk = decodeDelta(&ring[entry.offset], entry.size, 
+                                 entry.keyframe ? NULL : &keyframeState[0],
+                                 &decoded[0], decoded.size());
+
+    // Rewinding past a keyframe means the deltas before it are against the
+    // keyframe before that.
+    if (entry.keyframe)
+    {
+        if (!loadKeyframe())
+        {
+            keyframeState.clear();
+        }
+    }
+    else
+    {
+        sinceKeyframe--;
+    }
+
+    if (!decodedOk)
+    {
+        return false;
+    }
+    StateReader reader(&decoded[0], decoded.size());
+    return machine->loadState(&reader);
+}
+
+void RewindBuffer::clear()
+{
+    entries.clear();
+    usedBytes = 0;
+    sinceKeyframe = 0;
+    keyframeState.clear();
+}
+
+size_t RewindBuffer::getCount()
+{
+    return entries.size();
+}
+
+size_t RewindBuffer::getUsedBytes()
+{
+    return usedBytes;
+}
+
+size_t RewindBuffer::allocate(size_t size)
+{
+    if (size > ring.size())
+    {
+        return SIZE_MAX;
+    }
+
+    while (!entries.empty())
+    {
+        size_t tail = entries.front().offset;
+        size_t head = entries.back().offset + entries.back().size;
+        if (head > tail)
+        {
+            // The states are in one piece, use the end of the ring, or wrap
+            // around to the start.
+            if (ring.size() - head >= size)
+            {
+                return head;
+            }
+            if (tail >= size)
+            {
+                return 0;
+            }
+        }
+        else if (tail - head >= size)
+        {
+            // The states wrap around, use the gap in the middle.
+            return head;
+        }
+        dropOldest();
+    }
+    return 0;
+}
+
+void RewindBuffer::dropOldest()
+{
+    usedBytes -= entries.front().size;
+    entries.pop_front();
+
+    // Deltas are no use without their keyframe.
+    while (!entries.empty() && !entries.front().keyframe)
+    {
+        usedBytes -= entries.front().size;
+        entries.pop_front();
+    }
+    if (entries.empty())
+    {
+        keyframeState.clear();
+        sinceKeyframe = 0;
+    }
+}
+
+bool RewindBuffer::loadKeyframe()
+{
+    sinceKeyframe = 0;
+    for (size_t i = entries.size(); i > 0; i--)
+    {
+        const Entry& entry = entries[i - 1];
+        if (entry.keyframe)
+        {
+            std::vector<uint8_t> state(keyframeState.size());
+            if (!decodeDelta(&ring[entry.offset], entry.size, NULL, 
+                             &state[0], state.size()))
+            {
+                return false;
+            }
+            keyframeState.swap(state);
+            return true;
+        }
+        sinceKeyframe++;
+    }
+    return false;
+}
@@ -0,0 +1,107 @@
+#ifndef _REWIND_BUFFER_H_
+#define _REWIND_BUFFER_H_
+
+#include <deque>
+#include <vector>
+
+#include "GBMachine.h"
+
+/**
+ * @brief Keeps recent states of a machine so that it can be run backwards.
+ *
+ * A state is captured once a frame and stored compressed in a ring buffer
+ * of a fixed size. When the buffer is full the oldest states are dropped, so
+ * the budget decides how far back the machine can go, e.g. 64 MB holds
+ * well over a minute.
+ *
+ * Every few states a keyframe is stored, which is the whole save state run
+ * length encoded. The states in between are stored as the XOR delta from 
+ * the keyframe before them, which is mostly zeros, so they only take a few 
+ * KB each. See DeltaCompression.h.
+ */
+class RewindBuffer
+{
+public:
+    /**
+     * Creates a rewind buffer. All of the memory is allocated up front.
+     *
+     * @param budget Memory for compressed states, in bytes.
+     * @param keyframeInterval Store a keyframe every this many states.
+     */
+    RewindBuffer(size_t budget, int keyframeInterval = 60);
+
+    /**
+     * Captures the current state of a machine.
+     */
+    void capture(GBMachine* machine);
+
+    /**
+     * Loads the last state that was captured into a machine, and drops it
+     * from the buffer.
+     *
+     * @return True if a state was loaded, false if there are none left.
+     */
+    bool rewind(GBMachine* machine);
+
+    /**
+     * Drops every state.
+     */
+    void clear();
+
+    /**
+     * Gets the number of states in the buffer.
+     */
+    size_t getCount();
+
+    /**
+     * Gets the number of bytes used by the states in the buffer.
+     */
+    size_t getUsedBytes();
+
+private:
+    struct Entry
+    {
+        size_t offset;
+        size_t size;
+        bool keyframe;
+    };
+
+    /**
+     * Finds space for a state, dropping the oldest states until it fits.
+     *
+     * @return Offset of the space in the ring, or SIZE_MAX if the state is
+     * bigger than the whole budget.
+     */
+    size_t allocate(size_t size);
+
+    /**
+     * Drops the oldest state, and any deltas that depended on it.
+     */
+    void dropOldest();
+
+    /**
+     * Decompresses the newest keyframe into keyframeState, so deltas can be
+     * made against it.
+     */
+    bool loadKeyframe();
+
+    /* Compressed states */
+    std::vector<uint8_t> ring;
+    std::deque<Entry> entries;
+    size_t usedBytes;
+
+    int keyframeInterval;
+
+    /* Number of deltas stored since the last keyframe. */
+    int sinceKeyframe;
+
+    /* The newest keyframe, uncompressed. */
+    std::vector<uint8_t> keyframeState;
+
+    /* Scratch space for saving, compressing and loading states. */
+    StateWriter writer;
+    std::vector<uint8_t> encoded;
+    std::vector<uint8_t> decoded;
+};
+
+#endif
@@ -1,6 +1,7 @@
 #include <iostream>
 
 #include "BasicMemory.h"
+#include "../../Common/SaveState.h"
 
 BasicMemory::BasicMemory( addr_t start, addr_t end ) {
     if( end < start )
@@ -26,3 +27,13 @@ data_t BasicMemory::read( addr_t addr ) {
 void BasicMemory::write( addr_t addr, data_t val ) {
     mem[addr-offset] = val;
 }
+
+void BasicMemory::saveState( StateWriter* state ) {
+    state->write( mem, size );
+}
+
+bool BasicMemory::loadState( StateReader* state ) {
+    if( state->getChunkSize() != size )
+        return false;
+    return state->read( mem, size );
+}
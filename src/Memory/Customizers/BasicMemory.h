@@ -22,6 +22,9 @@ public:
     virtual data_t read( addr_t addr );
     virtual void write( addr_t addr, data_t val );
 
+    virtual void saveState( StateWriter* state );
+    virtual bool loadState( StateReader* state );
+
 protected:
     data_t* mem;
     size_t size;
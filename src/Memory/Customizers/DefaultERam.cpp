@@ -1,21 +1,48 @@
 #include "DefaultERam.h"
+#include "../../Common/SaveState.h"
+
+// Without a memory bank controller, only one bank of RAM can be addressed.
+#define ERAM_BANK_SIZE 0x2000
 
 DefaultERam::DefaultERam( Memory* mem ) {
-    eram = new data_t[mem->header->romSize];
+    size = mem->header->ramSize;
+    if( size > ERAM_BANK_SIZE )
+        size = ERAM_BANK_SIZE;
+    eram = new data_t[size];
+
+    // set to 0 for consistency
+    for( size_t i = 0; i < size; i++ )
+        eram[i] = 0;
     eRamEnabled = false;
 }
 
 DefaultERam::~DefaultERam() {
-    delete eram;
+    delete[] eram;
 }
 
 data_t DefaultERam::read( addr_t addr ) {
+    // Addresses past the end of the RAM, if any, read as an open bus.
+    if( (size_t)(addr-0xA000) >= size )
+        return 0xFF;
     return eram[addr-0xA000];
 }
 
 void DefaultERam::write( addr_t addr, data_t val ) {
-    if( 0xA000 <= addr && addr <= 0xBFFF )
-        eram[addr-0xA000] = val;
+    if( 0xA000 <= addr && addr <= 0xBFFF ) {
+        if( (size_t)(addr-0xA000) < size )
+            eram[addr-0xA000] = val;
+    }
     else
         eRamEnabled = ( val == 0xA0 ) ? true : false;
 }
+
+void DefaultERam::saveState( StateWriter* state ) {
+    state->write( eRamEnabled );
+    state->write( eram, size );
+}
+
+bool DefaultERam::loadState( StateReader* state ) {
+    if( state->getChunkSize() != sizeof(eRamEnabled) + size )
+        return false;
+    return state->read( &eRamEnabled ) && state->read( eram, size );
+}
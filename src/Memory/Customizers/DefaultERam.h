@@ -5,7 +5,9 @@
 #include "../MemoryCustomizer.h"
 
 /**
- * External RAM implementation
+ * External RAM implementation. The RAM is as big as the cartridge header
+ * says, up to the one 8 KB bank that can be addressed without a memory bank
+ * controller.
  */
 class DefaultERam : public MemoryCustomizer {
 
@@ -19,8 +21,12 @@ public:
     // 0xA000 - 0xBFFF
     virtual void write( addr_t addr, data_t val );
 
+    virtual void saveState( StateWriter* state );
+    virtual bool loadState( StateReader* state );
+
 protected:
     data_t* eram;
+    size_t size;
     bool eRamEnabled;
 };
 
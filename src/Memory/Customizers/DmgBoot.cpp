@@ -1,4 +1,5 @@
 #include "../../Common/Config.h"
+#include "../../Common/SaveState.h"
 #include "DmgBoot.h"
 
 /**
@@ -59,3 +60,13 @@ bool DmgBoot::isEnabled()
 {
     return enabled;
 }
+
+void DmgBoot::saveState(StateWriter* state)
+{
+    state->write(enabled);
+}
+
+bool DmgBoot::loadState(StateReader* state)
+{
+    return state->read(&enabled);
+}
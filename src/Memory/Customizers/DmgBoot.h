@@ -15,6 +15,9 @@ public:
 
     virtual data_t read(addr_t addr);
     virtual void write(addr_t addr, data_t val);
+
+    virtual void saveState(StateWriter* state);
+    virtual bool loadState(StateReader* state);
     
     /**
      * Is DMG boot enabled?
@@ -1,9 +1,33 @@
 #include "../../Common/Config.h"
+#include "../../Common/SaveState.h"
 #include "IOMemory.h"
 
+#define JOYPAD_DIRECTIONS 0x10
+#define JOYPAD_BUTTONS 0x20
+#define JOYPAD_REQUEST 0x10
+
+/**
+ * Every register, in the order they are saved.
+ */
+static data_t IOMemory::* const ioRegisters[] =
+{
+    &IOMemory::JOYP, &IOMemory::SD, &IOMemory::SC, &IOMemory::DIV,
+    &IOMemory::TIMA, &IOMemory::TMA, &IOMemory::TAC, &IOMemory::IFLAGS,
+    &IOMemory::NR10, &IOMemory::NR11, &IOMemory::NR12, &IOMemory::NR13,
+    &IOMemory::NR14, &IOMemory::NR21, &IOMemory::NR22, &IOMemory::NR23,
+    &IOMemory::NR24, &IOMemory::NR30, &IOMemory::NR31, &IOMemory::NR32,
+    &IOMemory::NR33, &IOMemory::NR34, &IOMemory::NR41, &IOMemory::NR42,
+    &IOMemory::NR43, &IOMemory::NR44, &IOMemory::NR50, &IOMemory::NR51,
+    &IOMemory::NR52, &IOMemory::LCDC, &IOMemory::STAT, &IOMemory::SCY,
+    &IOMemory::SCX, &IOMemory::LY, &IOMemory::LYC, &IOMemory::BGP,
+    &IOMemory::OBP0, &IOMemory::OBP1, &IOMemory::WY, &IOMemory::WX
+};
+static const size_t NUM_IO_REGISTERS = sizeof(ioRegisters) / sizeof(ioRegisters[0]);
+
 IOMemory::IOMemory() 
 {
     JOYP = 0;
+    buttons = 0;
     SD = 0;
     SC = 0;
     DIV = 0;
@@ -43,6 +67,7 @@ IOMemory::IOMemory()
     OBP1 = 0;
     WY = 0;
     WX = 0;
+    memset(WaveRam, 0, sizeof(WaveRam));
 }
 
 data_t IOMemory::read( addr_t addr ) 
@@ -55,7 +80,7 @@ data_t IOMemory::read( addr_t addr )
     switch(addr)
     {
         case 0xFF00:
-            return JOYP;
+            return 0xC0 | JOYP | getJoypadLines();
         case 0xFF01:
             return SD;
         case 0xFF02:
@@ -149,8 +174,17 @@ void IOMemory::write( addr_t addr, data_t val )
     switch(addr)
     {
         case 0xFF00:
-            JOYP = val & 0xFFF0; // Bits 3-0 read-only
+        {
+            data_t oldLines = getJoypadLines();
+            JOYP = val & 0x30; // Bits 3-0 read-only
+
+            // Selecting a row with a button held pulls its line low too.
+            if (oldLines & ~getJoypadLines())
+            {
+                IFLAGS |= JOYPAD_REQUEST;
+            }
             break;
+        }
         case 0xFF01:
             SD = val;
             break;
@@ -270,3 +304,59 @@ void IOMemory::write( addr_t addr, data_t val )
             break;
     }
 }
+
+void IOMemory::setButtons( data_t pressed )
+{
+    data_t oldLines = getJoypadLines();
+    buttons = pressed;
+    
+    // Request an interrupt if any line went from high to low.
+    if (oldLines & ~getJoypadLines())
+    {
+        IFLAGS |= JOYPAD_REQUEST;
+    }
+}
+
+data_t IOMemory::getButtons()
+{
+    return buttons;
+}
+
+data_t IOMemory::getJoypadLines()
+{
+    data_t lines = 0x0F;
+    // A row is selected by clearing its bit.
+    if (!(JOYP & JOYPAD_DIRECTIONS))
+    {
+        lines &= ~(buttons & 0x0F);
+    }
+    if (!(JOYP & JOYPAD_BUTTONS))
+    {
+        lines &= ~(buttons >> 4);
+    }
+    return lines;
+}
+
+void IOMemory::saveState( StateWriter* state )
+{
+    for (size_t i = 0; i < NUM_IO_REGISTERS; i++)
+    {
+        state->write(this->*ioRegisters[i]);
+    }
+    state->write(WaveRam, sizeof(WaveRam));
+    state->write(buttons);
+}
+
+bool IOMemory::loadState( StateReader* state )
+{
+    if (state->getChunkSize() != NUM_IO_REGISTERS + sizeof(WaveRam) + 1)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < NUM_IO_REGISTERS; i++)
+    {
+        state->read(&(this->*ioRegisters[i]));
+    }
+    state->read(WaveRam, sizeof(WaveRam));
+    return state->read(&buttons);
+}
@@ -3,11 +3,26 @@
 
 #include "../MemoryCustomizer.h"
 
+/**
+ * Buttons of the joypad, as a bit mask.
+ */
+enum JoypadButton
+{
+    JOYPAD_RIGHT =  0x01,
+    JOYPAD_LEFT =   0x02,
+    JOYPAD_UP =     0x04,
+    JOYPAD_DOWN =   0x08,
+    JOYPAD_A =      0x10,
+    JOYPAD_B =      0x20,
+    JOYPAD_SELECT = 0x40,
+    JOYPAD_START =  0x80
+};
+
 /**
  * @brief Memory behavior for the IO ports
  * 
  * Currently this class just emulates which bits can be 
- * read and which can be written.
+ * read and which can be written, and the joypad.
  */
 class IOMemory : public MemoryCustomizer {
 
@@ -16,6 +31,23 @@ public:
     
     virtual data_t read( addr_t addr );
     virtual void write( addr_t addr, data_t val );
+
+    /**
+     * Sets which joypad buttons are held down. Reading JOYP returns the 
+     * buttons of the rows that are selected. If a button in a selected row
+     * is newly pressed, the joypad interrupt is requested.
+     *
+     * @param pressed Mask of JoypadButton values that are held down.
+     */
+    void setButtons( data_t pressed );
+
+    /**
+     * Gets the joypad buttons that are held down.
+     */
+    data_t getButtons();
+
+    virtual void saveState( StateWriter* state );
+    virtual bool loadState( StateReader* state );
     
     // IO Registers, reading and writing will modify these registers.
     data_t JOYP;         // 0xFF00
@@ -47,7 +79,7 @@ public:
     data_t NR50;         // 0xFF24
     data_t NR51;         // 0xFF25  
     data_t NR52;         // 0xFF26
-    data_t WaveRam[0xF]; // 0xFF30-0xFF3F
+    data_t WaveRam[0x10];// 0xFF30-0xFF3F
     data_t LCDC;         // 0xFF40
     data_t STAT;         // 0xFF41
     data_t SCY;          // 0xFF42
@@ -59,6 +91,16 @@ public:
     data_t OBP1;         // 0xFF49
     data_t WY;           // 0xFF4A
     data_t WX;           // 0xFF4B
+
+private:
+    /**
+     * Gets the lower 4 bits of JOYP, which are low for every pressed button
+     * in the selected rows.
+     */
+    data_t getJoypadLines();
+
+    /* Joypad buttons that are held down. */
+    data_t buttons;
 };
 
 #endif
@@ -1,4 +1,6 @@
 #include "VRam.h"
+#include "../../Common/Metrics.h"
+#include "../../Common/SaveState.h"
 
 VRam::VRam( Memory* m ) {
     memObj = m;
@@ -18,10 +20,23 @@ VRam::~VRam() {
 data_t VRam::read( addr_t addr ) {
     // recursion with depth 1 in memObj
     if( ((memObj->read(0xFF41)&0x03) == 3) && ((memObj->read(0xFF40)&0x80) == 0x80) )
+    {
+        GB_METRIC_ADD(Metrics::VRAM_REJECTS, 1);
         return 0xFF;
+    }
     return mem[addr-0x8000];
 }
 
 void VRam::write( addr_t addr, data_t val ) {
     mem[addr-0x8000] = val;
 }
+
+void VRam::saveState( StateWriter* state ) {
+    state->write( mem, size );
+}
+
+bool VRam::loadState( StateReader* state ) {
+    if( state->getChunkSize() != size )
+        return false;
+    return state->read( mem, size );
+}
@@ -1,5 +1,8 @@
+#include <algorithm>
 #include <iostream>
 
+#include "../Common/Metrics.h"
+#include "../Common/SaveState.h"
 #include "CartridgeHeader.h"
 #include "Memory.h"
 #include "Customizers/BasicMemory.h"
@@ -10,6 +13,15 @@
 #include "Customizers/LazyMemory.h"
 #include "Customizers/VRam.h"
 
+/**
+ * Save state chunk ids for each address range.
+ */
+static const char* rangeChunks[ADDRESS_RANGE_SIZE] = 
+{
+    "ROM0", "ROM1", "ROM2", "ROM3", "VRAM", "ERAM", "WRM0", 
+    "WRM1", "ECHO", "OAM ", "NUSE", "IO  ", "HRAM", "IE  "
+};
+
 /** 
  * Create a new {@code Memory} object from the given gameboy cartridge file.
  * 
@@ -93,6 +105,7 @@ Memory::~Memory() {
  */
 data_t Memory::read( addr_t addr ) 
 {
+    GB_METRIC_ADD(Metrics::MEMORY_READS + getAddressRange(addr), 1);
     if (dmg->isEnabled() && addr <= 0xFF)
         return dmg->read(addr);
     // ROM
@@ -138,6 +151,21 @@ data_t Memory::read( addr_t addr )
 }
 
 
+/**
+ * Read the given address like {@code read}, but skip the metrics and let 
+ * the listeners skip anything they do on reads, e.g. checking watchpoints.
+ *
+ * @param addr The address whose value is requested
+ * @return The value at {@code addr}
+ */
+data_t Memory::peek( addr_t addr )
+{
+    if (dmg->isEnabled() && addr <= 0xFF)
+        return dmg->peek(addr);
+    return readListeners[getAddressRange(addr)]->peek( addr );
+}
+
+
 /**
  * Write the given value to the given address in the gameboy's memory space.
  *
@@ -189,6 +217,30 @@ void Memory::write( addr_t addr, data_t val )
         writeListeners[IReg]->write( addr, val );
 }
 
+Memory::AddressRange Memory::getAddressRange( addr_t addr ) {
+    if( addr <= 0x7FFF )
+        return (AddressRange)(RomBank0_1 + (addr >> 13));
+    else if( addr <= 0x9FFF )
+        return VRAM;
+    else if( addr <= 0xBFFF )
+        return ERam;
+    else if( addr <= 0xCFFF )
+        return WRam0;
+    else if( addr <= 0xDFFF )
+        return WRam1;
+    else if( addr <= 0xFDFF )
+        return ECHORAM;
+    else if( addr <= 0xFE9F )
+        return Oam;
+    else if( addr <= 0xFEFF )
+        return NonUseable;
+    else if( addr <= 0xFF7F )
+        return IOPorts;
+    else if( addr <= 0xFFFE )
+        return HRam;
+    return IReg;
+}
+
 void Memory::registerListener( AddressRange range, MemoryInterface* mem ) {
     registerReadListener( range, mem );
     registerWriteListener( range, mem );
@@ -202,7 +254,66 @@ void Memory::registerWriteListener( AddressRange range, MemoryInterface* mem ) {
     writeListeners[range] = mem;
 }
 
+MemoryInterface* Memory::getReadListener( AddressRange range ) {
+    return readListeners[range];
+}
+
+MemoryInterface* Memory::getWriteListener( AddressRange range ) {
+    return writeListeners[range];
+}
+
 IOMemory* Memory::getIOMemory()
 {
     return ioMem;
 }
+
+void Memory::saveState( StateWriter* state )
+{
+    // Memory can be registered for several ranges, or for reads and writes
+    // separately, but it is only saved once.
+    MemoryInterface* saved[ADDRESS_RANGE_SIZE * 2];
+    int numSaved = 0;
+    for( int i = 0; i < ADDRESS_RANGE_SIZE * 2; i++ ) {
+        int range = i % ADDRESS_RANGE_SIZE;
+        MemoryInterface* listener = i < ADDRESS_RANGE_SIZE ? 
+            readListeners[range] : writeListeners[range];
+        if( std::find( saved, saved + numSaved, listener ) != saved + numSaved )
+            continue;
+        saved[numSaved++] = listener;
+
+        state->beginChunk( rangeChunks[range] );
+        listener->saveState( state );
+        state->endChunk();
+    }
+
+    state->beginChunk( "BOOT" );
+    dmg->saveState( state );
+    state->endChunk();
+}
+
+bool Memory::loadState( StateReader* state )
+{
+    MemoryInterface* loaded[ADDRESS_RANGE_SIZE * 2];
+    int numLoaded = 0;
+    for( int i = 0; i < ADDRESS_RANGE_SIZE * 2; i++ ) {
+        int range = i % ADDRESS_RANGE_SIZE;
+        MemoryInterface* listener = i < ADDRESS_RANGE_SIZE ? 
+            readListeners[range] : writeListeners[range];
+        if( std::find( loaded, loaded + numLoaded, listener ) != loaded + numLoaded )
+            continue;
+        loaded[numLoaded++] = listener;
+
+        // Memory without any state doesn't have a chunk.
+        if( !state->openChunk( rangeChunks[range] ) )
+            continue;
+        if( !listener->loadState( state ) ) {
+            state->setErrorMessage( std::string( "Could not load the " ) + 
+                                    rangeChunks[range] + " chunk." );
+            return false;
+        }
+    }
+
+    if( !state->openChunk( "BOOT" ) || !dmg->loadState( state ) )
+        return false;
+    return true;
+}
@@ -10,9 +10,6 @@
 
 const int ADDRESSABLE_MEMORY_SIZE = 0x10000;
 
-// number of elements in the AddressRange enum
-const int ADDRESS_RANGE_SIZE = 14;
-
 
 /**
  * @file Memory.h
@@ -46,6 +43,8 @@ public:
     virtual data_t read( addr_t addr );
     // write val to addr
     virtual void write( addr_t addr, data_t val );
+    // read from addr without counting it or passing watchpoints
+    virtual data_t peek( addr_t addr );
 
     enum AddressRange {
         // 0x0000-0x1FFF
@@ -97,11 +96,34 @@ public:
      */
     void registerReadListener( AddressRange range, MemoryInterface* mem );
     void registerWriteListener( AddressRange range, MemoryInterface* mem );
+
+    /**
+     * Gets the listeners registered for a range, e.g. to put something in
+     * front of them.
+     */
+    MemoryInterface* getReadListener( AddressRange range );
+    MemoryInterface* getWriteListener( AddressRange range );
+
+    /**
+     * Finds the range an address is in.
+     */
+    static AddressRange getAddressRange( addr_t addr );
    
     /**
      * Gets the I/O Ports, which are required for a lot of the Game Boy components.
      */
     IOMemory *getIOMemory();
+
+    /**
+     * Writes a save state chunk for each address range with any state, and 
+     * one for the boot ROM. Chunks are named after their address range.
+     */
+    virtual void saveState( StateWriter* state );
+
+    /**
+     * Loads every chunk written by @c saveState.
+     */
+    virtual bool loadState( StateReader* state );
 protected:
 
     // for now, I'll allocate enough space for all addresses to make things easy
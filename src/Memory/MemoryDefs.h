@@ -7,6 +7,9 @@ const int KB_SIZE = 0x400;
 typedef uint8_t data_t;
 typedef uint16_t addr_t;
 
+// number of elements in the Memory::AddressRange enum
+const int ADDRESS_RANGE_SIZE = 14;
+
 enum BankingMode {
     ROM_BANKING_MODE = 0x00,
     RAM_BANKING_MODE = 0x01
@@ -6,6 +6,9 @@
 #include "MemoryDefs.h"
 #include "MemoryInterface.h"
 
+class StateReader;
+class StateWriter;
+
 /**
  * @file memory.h
  *
@@ -15,6 +18,8 @@ class MemoryInterface {
 
 public:
 
+    virtual ~MemoryInterface() {}
+
     /**
      * Read according to the gameboy's memory map.
      * 
@@ -30,6 +35,33 @@ public:
      * @param val The value to write at {@code addr}
      */
     virtual void write( addr_t addr, data_t data) = 0;
+
+    /**
+     * Read without being seen, for tools that look at memory the program 
+     * never asked for. Memory that does nothing but return its contents on
+     * a read doesn't need to override this.
+     *
+     * @param addr The address of memory requested
+     * @return The value {@code read} would return
+     */
+    virtual data_t peek( addr_t addr ) { return read( addr ); }
+
+    /**
+     * Write anything that would be lost when the memory is recreated, e.g.
+     * the contents of RAM, into a save state chunk. Memory without any 
+     * state doesn't need to write anything.
+     *
+     * @param state The save state, with a chunk open for this memory.
+     */
+    virtual void saveState( StateWriter* state ) {}
+
+    /**
+     * Restore what was written by @c saveState.
+     *
+     * @param state The save state, with this memory's chunk open.
+     * @return True if the state was loaded, false otherwise.
+     */
+    virtual bool loadState( StateReader* state ) { return true; }
 };
 
 #endif
@@ -0,0 +1,44 @@
+#include <iomanip>
+
+#include "FrameHashLog.h"
+#include "../Common/Hash.h"
+#include "../Machine/GBMachine.h"
+
+FrameHashLog::FrameHashLog(std::ostream* out)
+{
+    this->out = out;
+    lastHash = 0;
+    machine = NULL;
+    lastStateHash = 0;
+}
+
+void FrameHashLog::setMachine(GBMachine* machine)
+{
+    this->machine = machine;
+}
+
+void FrameHashLog::presentFrame(const uint32_t* pixels, Lcd* lcd, uint64_t frame)
+{
+    // Hash the shades, they don't depend on the palette used for the pixels.
+    lastHash = hashBytes(lcd->getFrame(), 160 * 144);
+    *out << std::dec << frame << " " << std::hex << std::setw(16) 
+         << std::setfill('0') << lastHash;
+    if (machine != NULL)
+    {
+        machine->saveState(&state);
+        lastStateHash = hashBytes(state.getData(), state.getSize());
+        *out << " " << std::setw(16) << lastStateHash;
+    }
+    // The log may be stdout, leave it writing decimal for everyone else.
+    *out << std::dec << std::setfill(' ') << "\n";
+}
+
+uint64_t FrameHashLog::getLastHash()
+{
+    return lastHash;
+}
+
+uint64_t FrameHashLog::getLastStateHash()
+{
+    return lastStateHash;
+}
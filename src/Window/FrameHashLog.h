@@ -0,0 +1,66 @@
+#ifndef _FRAME_HASH_LOG_H_
+#define _FRAME_HASH_LOG_H_
+
+#include <ostream>
+
+#include "GBHeadlessWindow.h"
+#include "../Common/SaveState.h"
+
+class GBMachine;
+
+/**
+ * Writes a hash of every frame presented by a GBHeadlessWindow, one line per
+ * frame:
+ *
+ *     <frame> <hash>
+ *
+ * Two runs that drew the same frames write the same lines, so a replayed 
+ * session can be checked against the original with diff.
+ *
+ * With a machine, the hash of its whole state follows on every line, covering
+ * the CPU registers, the I/O registers and every RAM region:
+ *
+ *     <frame> <hash> <state hash>
+ *
+ * This also catches runs that drew the same frames but went different ways,
+ * e.g. in RAM the screen does not show yet.
+ */
+class FrameHashLog : public FrameSink
+{
+public:
+    /**
+     * @param out Where to write the hashes.
+     */
+    FrameHashLog(std::ostream* out);
+
+    /**
+     * Also hashes the state of a machine every frame.
+     *
+     * @param machine The machine drawing the frames, or NULL to only hash
+     * the frames.
+     */
+    void setMachine(GBMachine* machine);
+
+    void presentFrame(const uint32_t* pixels, Lcd* lcd, uint64_t frame);
+
+    /**
+     * Gets the hash of the last frame that was presented.
+     */
+    uint64_t getLastHash();
+
+    /**
+     * Gets the hash of the state after the last frame, or 0 without a
+     * machine.
+     */
+    uint64_t getLastStateHash();
+
+private:
+    std::ostream* out;
+    uint64_t lastHash;
+    GBMachine* machine;
+    /* Kept between frames, so saving the state does not allocate. */
+    StateWriter state;
+    uint64_t lastStateHash;
+};
+
+#endif
@@ -0,0 +1,77 @@
+#include "../Common/Metrics.h"
+#include "GBHeadlessWindow.h"
+
+GBHeadlessWindow::GBHeadlessWindow()
+{
+    gbMachine = NULL;
+    frameSink = NULL;
+    frameLimit = 0;
+    cycleLimit = 0;
+    frames = 0;
+}
+
+bool GBHeadlessWindow::init(GBMachine* machine)
+{
+    gbMachine = machine;
+    gbMachine->getLcd()->init(pixels);
+    return true;
+}
+
+void GBHeadlessWindow::loop()
+{
+    Lcd* lcd = gbMachine->getLcd();
+    uint64_t endCycle = cycleLimit == 0 ? UINT64_MAX : cycleLimit;
+
+    while (frameLimit == 0 || frames < frameLimit)
+    {
+        if (!gbMachine->runUntil(endCycle))
+        {
+            break;
+        }
+        frames++;
+        if (lcd->isDirty())
+        {
+            if (frameSink != NULL)
+            {
+#ifdef GB_METRICS
+                uint64_t startTime = Metrics::now();
+#endif
+                frameSink->presentFrame(pixels, lcd, lcd->getFrameCount());
+#ifdef GB_METRICS
+                GB_METRIC_ADD(Metrics::PRESENT_NS, Metrics::now() - startTime);
+#endif
+            }
+            lcd->clean();
+        }
+    }
+}
+
+std::string GBHeadlessWindow::getErrorMessage()
+{
+    return error;
+}
+
+void GBHeadlessWindow::setFrameLimit(uint64_t frames)
+{
+    frameLimit = frames;
+}
+
+void GBHeadlessWindow::setCycleLimit(uint64_t cycles)
+{
+    cycleLimit = cycles;
+}
+
+void GBHeadlessWindow::setFrameSink(FrameSink* sink)
+{
+    frameSink = sink;
+}
+
+const uint32_t* GBHeadlessWindow::getPixels()
+{
+    return pixels;
+}
+
+uint64_t GBHeadlessWindow::getFrameCount()
+{
+    return frames;
+}
@@ -0,0 +1,88 @@
+#ifndef _GB_HEADLESS_WINDOW_H_
+#define _GB_HEADLESS_WINDOW_H_
+
+#include "GBWindow.h"
+
+/**
+ * Receives the frames presented by a GBHeadlessWindow.
+ */
+class FrameSink
+{
+public:
+    virtual ~FrameSink() {}
+
+    /**
+     * Called every time the LCD presents a frame.
+     *
+     * @param pixels 160x144 array of 32-bit pixels.
+     * @param lcd The LCD, for its shades and dirty scanlines.
+     * @param frame Number of frames the LCD has finished, including this one.
+     */
+    virtual void presentFrame(const uint32_t* pixels, Lcd* lcd, uint64_t frame) = 0;
+};
+
+/**
+ * Game Boy window without a display. Frames are drawn into a buffer in 
+ * memory and can be passed on to a FrameSink. This is meant for running
+ * on machines without a display, where setting up SDL is pure overhead.
+ */
+class GBHeadlessWindow : public ::GBWindow
+{
+public:
+    GBHeadlessWindow();
+
+    bool init(GBMachine *machine);
+    void loop();
+    std::string getErrorMessage();
+
+    /**
+     * Stop the loop after a number of frames. Frames are counted whether 
+     * they are rendered or skipped.
+     *
+     * @param frames Number of frames, or 0 to run without a limit.
+     */
+    void setFrameLimit(uint64_t frames);
+
+    /**
+     * Stop the loop once the machine has run for a number of cycles.
+     *
+     * @param cycles Number of cycles, or 0 to run without a limit.
+     */
+    void setCycleLimit(uint64_t cycles);
+
+    /**
+     * Set where to send each frame that is presented.
+     *
+     * @param sink The frame sink, or NULL to only keep the last frame.
+     */
+    void setFrameSink(FrameSink* sink);
+
+    /**
+     * Gets the last frame that was presented.
+     *
+     * @return 160x144 array of 32-bit pixels.
+     */
+    const uint32_t* getPixels();
+
+    /**
+     * Gets the number of frames that were run by the loop.
+     */
+    uint64_t getFrameCount();
+
+private:
+    /* The Game Boy */
+    GBMachine *gbMachine;
+
+    /* The screen */
+    uint32_t pixels[160 * 144];
+
+    FrameSink* frameSink;
+    uint64_t frameLimit;
+    uint64_t cycleLimit;
+    uint64_t frames;
+
+    /* Stores any error. */
+    std::string error;
+};
+
+#endif
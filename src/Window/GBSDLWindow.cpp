@@ -1,6 +1,19 @@
+#include <string.h>
+
+#include "../Common/Metrics.h"
 #include "GBSDLWindow.h"
 
-bool GBSDLWindow::init(CpuBase* cpu, LcdInterface* lcd)
+#define DEFAULT_REWIND_BUDGET (64 * 1024 * 1024)
+
+GBSDLWindow::GBSDLWindow()
+{
+    initialized = false;
+    speed = 1;
+    rewindBuffer = NULL;
+    rewindBudget = DEFAULT_REWIND_BUDGET;
+}
+
+bool GBSDLWindow::init(GBMachine* machine)
 {
     if (SDL_Init(SDL_INIT_EVERYTHING) != 0)
     {
@@ -18,10 +31,20 @@ bool GBSDLWindow::init(CpuBase* cpu, LcdInterface* lcd)
         return false;
     }
 
-    gbCpu = cpu;
+    gbMachine = machine;
+
+    // The emulation thread only draws shades, the window converts them.
+    gbLcd = gbMachine->getLcd();
+    gbLcd->init(NULL);
+
+    if (rewindBudget > 0)
+    {
+        rewindBuffer = new RewindBuffer(rewindBudget);
+    }
 
-    gbLcd = lcd;
-    gbLcd->init((uint32_t*)screen->pixels);
+    memset(shown, 0, sizeof(shown));
+    LcdComponent::convertFrame(shown, (uint32_t*)screen->pixels, 0, 144);
+    SDL_Flip(screen);
     
     initialized = true;
     return true;
@@ -32,9 +55,12 @@ void GBSDLWindow::loop()
     bool running = true;
     SDL_Event event;
 
+    emulating = true;
+    SDL_Thread *thread = SDL_CreateThread(emulationThread, this);
+
     while (running)
     {
-        if (SDL_PollEvent(&event))
+        while (SDL_PollEvent(&event))
         {
             switch (event.type)
             {
@@ -42,18 +68,177 @@ void GBSDLWindow::loop()
                     running = false;
                     break;
                 case SDL_KEYDOWN:
-                    // TODO Handle key presses.
+                case SDL_KEYUP:
+                    InputEvent inputEvent;
+                    inputEvent.key = event.key.keysym.sym;
+                    inputEvent.pressed = event.type == SDL_KEYDOWN;
+                    pendingInput.push_back(inputEvent);
                     break;
             }
         }
-        int cycles = gbCpu->step();
-        gbLcd->step(cycles);
+        sendInput();
+
+        if (frames.update())
+        {
+            present(frames.getFrontBuffer());
+        }
+        else
+        {
+            SDL_Delay(1);
+        }
+    }
+
+    emulating = false;
+    SDL_WaitThread(thread, NULL);
+}
+
+void GBSDLWindow::sendInput()
+{
+    // The emulation thread empties the queue every frame, so anything left
+    // over goes on a later pass of the loop.
+    while (!pendingInput.empty() && input.push(pendingInput.front()))
+    {
+        pendingInput.pop_front();
+    }
+}
+
+int GBSDLWindow::emulationThread(void *window)
+{
+    ((GBSDLWindow*)window)->emulate();
+    return 0;
+}
+
+void GBSDLWindow::emulate()
+{
+    data_t buttons = 0;
+    bool rewinding = false;
+    while (emulating)
+    {
+        // Input is only sampled once a frame.
+        InputEvent event;
+        while (input.pop(&event))
+        {
+            if (event.key == SDLK_TAB)
+                pacer.setSpeed(event.pressed ? 0 : speed);
+            else if (event.key == SDLK_r)
+                rewinding = event.pressed && rewindBuffer != NULL;
+            else if (event.pressed)
+                buttons |= getButton(event.key);
+            else
+                buttons &= ~getButton(event.key);
+        }
+        gbMachine->setButtons(buttons);
+
+        if (rewinding)
+        {
+            // Show each state as it is rewound through.
+            if (rewindBuffer->rewind(gbMachine))
+            {
+                memcpy(frames.getBackBuffer()->shades, gbLcd->getFrame(), 
+                       sizeof(Frame));
+                frames.publish();
+            }
+            pacer.waitForFrame();
+            continue;
+        }
+
+        gbMachine->runFrame();
+        if (rewindBuffer != NULL)
+        {
+            rewindBuffer->capture(gbMachine);
+        }
         if (gbLcd->isDirty())
         {
-            SDL_Flip(screen);
+            if (gbLcd->getDirtyLineCount() != 0)
+            {
+                memcpy(frames.getBackBuffer()->shades, gbLcd->getFrame(), 
+                       sizeof(Frame));
+                frames.publish();
+            }
             gbLcd->clean();
         }
+
+        pacer.waitForFrame();
+    }
+}
+
+data_t GBSDLWindow::getButton(SDLKey key)
+{
+    switch (key)
+    {
+        case SDLK_RIGHT:
+            return JOYPAD_RIGHT;
+        case SDLK_LEFT:
+            return JOYPAD_LEFT;
+        case SDLK_UP:
+            return JOYPAD_UP;
+        case SDLK_DOWN:
+            return JOYPAD_DOWN;
+        case SDLK_x:
+            return JOYPAD_A;
+        case SDLK_z:
+            return JOYPAD_B;
+        case SDLK_BACKSPACE:
+            return JOYPAD_SELECT;
+        case SDLK_RETURN:
+            return JOYPAD_START;
+        default:
+            return 0;
+    }
+}
+
+void GBSDLWindow::present(const Frame *frame)
+{
+#ifdef GB_METRICS
+    uint64_t startTime = Metrics::now();
+#endif
+
+    // Update each run of changed scanlines as one rectangle.
+    SDL_Rect rects[144];
+    int numRects = 0;
+    for (int line = 0; line < 144; line++)
+    {
+        const uint8_t *shades = frame->shades + line * 160;
+        if (memcmp(shown + line * 160, shades, 160) == 0)
+        {
+            continue;
+        }
+        memcpy(shown + line * 160, shades, 160);
+        LcdComponent::convertFrame(shown, (uint32_t*)screen->pixels, line, 1);
+
+        if (numRects > 0 && 
+            rects[numRects - 1].y + rects[numRects - 1].h == line)
+        {
+            rects[numRects - 1].h++;
+        }
+        else
+        {
+            rects[numRects].x = 0;
+            rects[numRects].y = line;
+            rects[numRects].w = 160;
+            rects[numRects].h = 1;
+            numRects++;
+        }
     }
+    if (numRects > 0)
+    {
+        SDL_UpdateRects(screen, numRects, rects);
+    }
+
+#ifdef GB_METRICS
+    GB_METRIC_ADD(Metrics::PRESENT_NS, Metrics::now() - startTime);
+#endif
+}
+
+void GBSDLWindow::setSpeed(int multiplier)
+{
+    speed = multiplier;
+    pacer.setSpeed(speed);
+}
+
+void GBSDLWindow::setRewindBudget(size_t bytes)
+{
+    rewindBudget = bytes;
 }
 
 std::string GBSDLWindow::getErrorMessage()
@@ -67,6 +252,7 @@ GBSDLWindow::~GBSDLWindow()
     {
         cleanUp();
     }
+    delete rewindBuffer;
 }
 
 void GBSDLWindow::cleanUp()
@@ -1,40 +1,144 @@
 #ifndef _GB_SDL_WINDOW_H_
 #define _GB_SDL_WINDOW_H_
 
+#include <atomic>
+#include <deque>
+
 #include "SDL.h"
 
 #include "GBWindow.h"
+#include "../Common/FramePacer.h"
+#include "../Common/SpscQueue.h"
+#include "../Common/TripleBuffer.h"
+#include "../Machine/RewindBuffer.h"
 
 /**
  * Game Boy window implemented using SDL. SDL will take care
  * of displaying graphics and handling input.
+ *
+ * The Game Boy runs on its own thread, so that presenting a frame never
+ * holds up the CPU. Finished frames are passed to the window's thread 
+ * through a triple buffer, and input goes back the other way through a 
+ * queue. Neither thread ever waits on the other.
+ *
+ * The emulation thread is paced to the speed of a real Game Boy, or a 
+ * multiple of it. Holding Tab runs it as fast as possible, and holding R 
+ * runs it backwards through the states kept in a RewindBuffer.
  */
 class GBSDLWindow : public ::GBWindow
 {
 public:
-    GBSDLWindow() { initialized = false; }
+    GBSDLWindow();
     ~GBSDLWindow();
 
-    bool init(CpuBase *cpu, LcdInterface *lcd);
+    bool init(GBMachine *machine);
     void loop();
     std::string getErrorMessage();
+
+    /**
+     * Sets how many times faster than a Game Boy to run. Must be called
+     * before loop().
+     *
+     * @param multiplier The speed, e.g. 1, 2, 4 or 8. 0 does not throttle.
+     */
+    void setSpeed(int multiplier);
+
+    /**
+     * Sets how much memory to keep for rewinding. Must be called before 
+     * init().
+     *
+     * @param bytes Memory for rewind states, or 0 to not allow rewinding.
+     */
+    void setRewindBudget(size_t bytes);
 private:
+    /**
+     * A frame of shades, passed from the emulation thread.
+     */
+    struct Frame
+    {
+        uint8_t shades[160 * 144];
+    };
+
+    /**
+     * A key press or release, passed to the emulation thread.
+     */
+    struct InputEvent
+    {
+        SDLKey key;
+        bool pressed;
+    };
+
+    /**
+     * Gets the joypad button a key is mapped to.
+     *
+     * @return The button mask, or 0 if the key is not mapped.
+     */
+    static data_t getButton(SDLKey key);
+
     /**
      * Shut down SDL.
      */
     void cleanUp();
 
+    /**
+     * Runs the Game Boy until the window is closed. Runs on the emulation
+     * thread.
+     */
+    void emulate();
+
+    /**
+     * Passes on as many of the pending input events as the queue takes, 
+     * oldest first. Runs on the window's thread.
+     */
+    void sendInput();
+
+    /**
+     * Entry point of the emulation thread.
+     */
+    static int emulationThread(void *window);
+
+    /**
+     * Updates the scanlines of the screen that changed since the last frame
+     * that was presented.
+     */
+    void present(const Frame *frame);
+
     /* Has the window been initialized? */
     bool initialized;
 
     /* The SDL screen */
     SDL_Surface *screen;
 
-    /* The Cpu */
-    CpuBase *gbCpu;
+    /* The Game Boy */
+    GBMachine *gbMachine;
     
     /* The LCD */
-    LcdInterface *gbLcd;
+    Lcd *gbLcd;
+
+    /* Frames from the emulation thread. */
+    TripleBuffer<Frame> frames;
+
+    /* Input for the emulation thread. */
+    SpscQueue<InputEvent, 64> input;
+
+    /* Input the queue had no room for yet, kept so no release is lost. */
+    std::deque<InputEvent> pendingInput;
+
+    /* Paces the emulation thread. */
+    FramePacer pacer;
+
+    /* Speed to go back to when fast-forward is released. */
+    int speed;
+
+    /* States to rewind through, NULL if rewinding is off. */
+    RewindBuffer *rewindBuffer;
+    size_t rewindBudget;
+
+    /* Cleared to stop the emulation thread. */
+    std::atomic<bool> emulating;
+
+    /* The last frame that was presented. */
+    uint8_t shown[160 * 144];
 
     /* Stores any error. */
     std::string error;
@@ -2,8 +2,7 @@
 #define _GB_WINDOW_H_
 
 #include <string>
-#include "../Cpu/CpuBase.h"
-#include "../Lcd/LcdInterface.h"
+#include "../Machine/GBMachine.h"
 
 /**
  * Window that will be displatyed for a Gameboy Game.
@@ -11,10 +10,13 @@
 class GBWindow
 {
 public:
+    virtual ~GBWindow() {}
+
     /**
-     * Initialize the window with a cpu.
+     * Initialize the window with the Game Boy it runs. The window is 
+     * responsible for initializing the LCD.
      */
-    virtual bool init(CpuBase *cpu, LcdInterface* lcd) = 0;
+    virtual bool init(GBMachine *machine) = 0;
 
     /**
      * Window loop. Keeps the game running until the game exits, or 
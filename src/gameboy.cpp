@@ -1,59 +1,548 @@
+#include <fstream>
+#include <signal.h>
 #include <iostream>
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
+#include <string>
 
 #include "Common/Config.h"
-#include "Cpu/Z80Cpu.h"
+#include "Common/Metrics.h"
+#include "Common/MetricsExporter.h"
+#include "Common/PerfCounters.h"
+#include "Common/SaveState.h"
+#include "Cpu/CpuProfiler.h"
+#include "Cpu/CpuTrace.h"
+#include "Cpu/SymbolTable.h"
+#include "Input/InputLog.h"
+#include "Input/InputScript.h"
+#include "Machine/GBMachine.h"
+#include "Machine/GdbStub.h"
 #include "Memory/Memory.h"
 #include "Memory/MemoryLoader.h"
-#include "Lcd/Lcd.h"
+#include "Window/FrameHashLog.h"
+#include "Window/GBHeadlessWindow.h"
 #include "Window/GBSDLWindow.h"
 
-#include <stdint.h>
-
-#define MEM_SIZE 0xFFFF
-
 static void usage()
 {
-    fprintf(stderr, "Usage: gameboy <rom file>\n");
+    fprintf(stderr, "Usage: gameboy [options] <rom file>\n"
+                    "Options:\n"
+                    "  --headless       Run without a display.\n"
+                    "  --frames <n>     Exit after n frames, headless only.\n"
+                    "  --cycles <n>     Exit after n cycles, headless only.\n"
+                    "  --frameskip <n>  Only render one out of every n frames.\n"
+                    "                   0 does not render any frames.\n"
+                    "  --speed <n>      Run n times faster than a Game Boy.\n"
+                    "                   0 runs as fast as possible. Defaults\n"
+                    "                   to 1, headless runs are never paced.\n"
+                    "  --rewind <MB>    Memory to keep for rewinding with R,\n"
+                    "                   defaults to 64. 0 turns rewinding off.\n"
+                    "  --input <file>   Hold down the buttons given in an input\n"
+                    "                   script.\n"
+                    "  --record <file>  Record the joypad input to a log.\n"
+                    "  --replay <file>  Replay the joypad input in a log.\n"
+                    "  --load-state <file>\n"
+                    "                   Start from a save state.\n"
+                    "  --save-state <file>\n"
+                    "                   Save the state of the Game Boy on exit.\n"
+                    "  --hash-frames <file>\n"
+                    "                   Write a hash of every frame, headless\n"
+                    "                   only. - writes to stdout.\n"
+                    "  --hash-state     Also write a hash of the whole state,\n"
+                    "                   registers and RAM, after every frame.\n"
+                    "  --skip-boot      Start the cartridge straight away,\n"
+                    "                   without the boot ROM checking its logo.\n"
+                    "  --profile <prefix>\n"
+                    "                   Write an opcode and address histogram\n"
+                    "                   to <prefix>.txt, and call stacks for a\n"
+                    "                   flame graph to <prefix>.folded. Needs a\n"
+                    "                   build with GB_PROFILER.\n"
+                    "  --sym <file>     Name the addresses in the profile and\n"
+                    "                   in GDB's \"monitor disas\" with the\n"
+                    "                   symbols in an RGBDS .sym file.\n"
+                    "  --metrics <file> Write the metrics to a file every\n"
+                    "                   second, as JSON if it ends in .json.\n"
+                    "                   Needs a build with GB_METRICS.\n"
+                    "  --metrics-socket <path>\n"
+                    "                   Answer connections to a Unix socket\n"
+                    "                   with the metrics as JSON. Needs a\n"
+                    "                   build with GB_METRICS.\n"
+                    "  --perf-counters  Count the host CPU's cycles, instructions,\n"
+                    "                   branch and cache misses while emulating,\n"
+                    "                   and print them per Game Boy cycle on\n"
+                    "                   exit. Needs Linux perf events.\n"
+                    "  --trace <file>   Keep a trace of the last instructions,\n"
+                    "                   and write it to a file on exit, on a\n"
+                    "                   crash and on SIGUSR1. Read it with\n"
+                    "                   gameboy-trace. Needs a build with\n"
+                    "                   GB_TRACE.\n"
+                    "  --trace-size <n> Number of instructions to keep,\n"
+                    "                   defaults to 65536.\n"
+                    "  --gdb <port|path>\n"
+                    "                   Wait for GDB to connect to a port on\n"
+                    "                   localhost or to a Unix socket, and let\n"
+                    "                   it debug the Game Boy. With --trace,\n"
+                    "                   the trace is written at every\n"
+                    "                   breakpoint and watchpoint.\n");
     exit(EXIT_FAILURE);
 }
 
+/** The trace the signal handlers write, and where to. */
+static CpuTrace *signalTrace = NULL;
+static const char *signalTraceFile = NULL;
+
+/** The signals a trace is written on before the process dies. */
+static const int crashSignals[] = { SIGSEGV, SIGILL, SIGFPE, SIGABRT };
+static const size_t crashSignalCount = 
+    sizeof(crashSignals) / sizeof(crashSignals[0]);
+
+/**
+ * Has the CPU write the trace when asked to with SIGUSR1. The CPU may be
+ * running on another thread, so it writes the trace itself between two
+ * instructions rather than having it change under the write.
+ */
+static void dumpTrace(int)
+{
+    signalTrace->requestSave(signalTraceFile);
+}
+
+/**
+ * Writes the trace after a crash, then crashes as before.
+ */
+static void dumpTraceOnCrash(int sig)
+{
+    signalTrace->save(signalTraceFile);
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+/**
+ * Writes a trace to a file on a crash, and whenever SIGUSR1 is received.
+ */
+static void installTraceHandlers(CpuTrace *trace, const char *fileName)
+{
+    signalTrace = trace;
+    signalTraceFile = fileName;
+
+    for (size_t i = 0; i < crashSignalCount; i++)
+    {
+        signal(crashSignals[i], dumpTraceOnCrash);
+    }
+#ifdef SIGUSR1
+    signal(SIGUSR1, dumpTrace);
+#endif
+}
+
+/**
+ * Puts the default handlers back, so that the trace can be freed.
+ */
+static void removeTraceHandlers()
+{
+    if (signalTrace == NULL)
+    {
+        return;
+    }
+#ifdef SIGUSR1
+    signal(SIGUSR1, SIG_DFL);
+#endif
+    for (size_t i = 0; i < crashSignalCount; i++)
+    {
+        signal(crashSignals[i], SIG_DFL);
+    }
+    signalTrace = NULL;
+    signalTraceFile = NULL;
+}
+
+/**
+ * Parses the number following an option.
+ */
+static uint64_t parseNumber(int argc, char **argv, int *i)
+{
+    if (*i + 1 >= argc)
+    {
+        usage();
+    }
+    (*i)++;
+
+    char *end;
+    uint64_t value = strtoull(argv[*i], &end, 0);
+    if (*end != '\0')
+    {
+        usage();
+    }
+    return value;
+}
+
 int main(int argc, char **argv)
 {
-    if (argc != 2)
+    const char *romFile = NULL;
+    bool headless = false;
+    uint64_t frames = 0;
+    uint64_t cycles = 0;
+    int frameSkip = 1;
+    int speed = 1;
+    uint64_t rewindMB = 64;
+    const char *inputFile = NULL;
+    const char *recordFile = NULL;
+    const char *replayFile = NULL;
+    const char *hashFile = NULL;
+    bool hashState = false;
+    const char *loadStateFile = NULL;
+    const char *saveStateFile = NULL;
+    bool skipBoot = false;
+    const char *profilePrefix = NULL;
+    const char *symbolFile = NULL;
+    const char *metricsFile = NULL;
+    const char *metricsSocket = NULL;
+    bool countPerf = false;
+    const char *traceFile = NULL;
+    uint64_t traceSize = 65536;
+    const char *gdbAddress = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--headless") == 0)
+            headless = true;
+        else if (strcmp(argv[i], "--frames") == 0)
+            frames = parseNumber(argc, argv, &i);
+        else if (strcmp(argv[i], "--cycles") == 0)
+            cycles = parseNumber(argc, argv, &i);
+        else if (strcmp(argv[i], "--frameskip") == 0)
+            frameSkip = (int)parseNumber(argc, argv, &i);
+        else if (strcmp(argv[i], "--speed") == 0)
+            speed = (int)parseNumber(argc, argv, &i);
+        else if (strcmp(argv[i], "--rewind") == 0)
+            rewindMB = parseNumber(argc, argv, &i);
+        else if (strcmp(argv[i], "--input") == 0 && i + 1 < argc)
+            inputFile = argv[++i];
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+            recordFile = argv[++i];
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+            replayFile = argv[++i];
+        else if (strcmp(argv[i], "--load-state") == 0 && i + 1 < argc)
+            loadStateFile = argv[++i];
+        else if (strcmp(argv[i], "--save-state") == 0 && i + 1 < argc)
+            saveStateFile = argv[++i];
+        else if (strcmp(argv[i], "--hash-frames") == 0 && i + 1 < argc)
+            hashFile = argv[++i];
+        else if (strcmp(argv[i], "--hash-state") == 0)
+            hashState = true;
+        else if (strcmp(argv[i], "--skip-boot") == 0)
+            skipBoot = true;
+        else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+            profilePrefix = argv[++i];
+        else if (strcmp(argv[i], "--sym") == 0 && i + 1 < argc)
+            symbolFile = argv[++i];
+        else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc)
+            metricsFile = argv[++i];
+        else if (strcmp(argv[i], "--metrics-socket") == 0 && i + 1 < argc)
+            metricsSocket = argv[++i];
+        else if (strcmp(argv[i], "--perf-counters") == 0)
+            countPerf = true;
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+            traceFile = argv[++i];
+        else if (strcmp(argv[i], "--trace-size") == 0)
+            traceSize = parseNumber(argc, argv, &i);
+        else if (strcmp(argv[i], "--gdb") == 0 && i + 1 < argc)
+            gdbAddress = argv[++i];
+        else if (argv[i][0] == '-' || romFile != NULL)
+            usage();
+        else
+            romFile = argv[i];
+    }
+    if (romFile == NULL)
     {
         usage();
     }
-    
+
+    if (hashState && hashFile == NULL)
+    {
+        std::cerr << "--hash-state needs --hash-frames." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+#ifndef GB_PROFILER
+    if (profilePrefix != NULL)
+    {
+        std::cerr << "--profile needs a build with GB_PROFILER turned on." 
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+#endif
+#ifndef GB_TRACE
+    if (traceFile != NULL)
+    {
+        std::cerr << "--trace needs a build with GB_TRACE turned on." 
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+#endif
+#ifndef GB_METRICS
+    if (metricsFile != NULL || metricsSocket != NULL)
+    {
+        std::cerr << "--metrics needs a build with GB_METRICS turned on." 
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+#endif
+
+    SymbolTable symbols;
+    if (symbolFile != NULL && !symbols.load(symbolFile))
+    {
+        std::cerr << symbols.getErrorMessage() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    InputScript inputScript;
+    if (inputFile != NULL && !inputScript.load(inputFile))
+    {
+        std::cerr << inputScript.getErrorMessage() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    InputLog replayLog;
+    if (replayFile != NULL && !replayLog.load(replayFile))
+    {
+        std::cerr << replayLog.getErrorMessage() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::ofstream hashFileStream;
+    std::ostream *hashOut = &std::cout;
+    if (hashFile != NULL && strcmp(hashFile, "-") != 0)
+    {
+        hashFileStream.open(hashFile);
+        if (!hashFileStream.is_open())
+        {
+            std::cerr << "Could not open " << hashFile << "." << std::endl;
+            return EXIT_FAILURE;
+        }
+        hashOut = &hashFileStream;
+    }
+    FrameHashLog hashLog(hashOut);
+
+    // The boot ROM is only mapped in by memory created after this.
+    Config::DmgEnabled = !skipBoot;
+
     // Create Game Boy memory
-    Memory* mem = MemoryLoader::loadCartridge( argv[1] );
-     
+    Memory* mem = MemoryLoader::loadCartridge( romFile );
+    if (mem == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+
     std::cout << mem->header->desc << std::endl;
-    
-    // Create Game Boy CPU.
-    CpuBase *cpu = new Z80Cpu(mem);
-    cpu->init();
-    
-    // Create Game Boy LCD.
-    LcdInterface *lcd = new Lcd(mem);
-    
+
+    // Create the Game Boy.
+    GBMachine *machine = new GBMachine(mem);
+    machine->getLcd()->setFrameSkip(frameSkip);
+    if (inputFile != NULL)
+    {
+        machine->setInputScript(&inputScript);
+    }
+    InputLog recordLog;
+    if (recordFile != NULL)
+    {
+        machine->recordInput(&recordLog);
+    }
+    if (replayFile != NULL)
+    {
+        machine->replayInput(&replayLog);
+    }
+    CpuProfiler profiler;
+    if (profilePrefix != NULL)
+    {
+        machine->getCpu()->setProfiler(&profiler);
+    }
+
     // Create the window.
-    GBWindow *window = new GBSDLWindow();
-    if (!window->init(cpu, lcd))
+    GBWindow *window;
+    if (headless)
+    {
+        GBHeadlessWindow *headlessWindow = new GBHeadlessWindow();
+        headlessWindow->setFrameLimit(frames);
+        headlessWindow->setCycleLimit(cycles);
+        if (hashFile != NULL)
+        {
+            headlessWindow->setFrameSink(&hashLog);
+            if (hashState)
+            {
+                hashLog.setMachine(machine);
+            }
+        }
+        window = headlessWindow;
+    }
+    else
+    {
+        GBSDLWindow *sdlWindow = new GBSDLWindow();
+        sdlWindow->setSpeed(speed);
+        sdlWindow->setRewindBudget((size_t)rewindMB * 1024 * 1024);
+        window = sdlWindow;
+    }
+
+    if (!window->init(machine))
     {
         std::cerr << window->getErrorMessage() << std::endl;
+        delete window;
+        delete machine;
+        return EXIT_FAILURE;
+    }
+
+    // The state is loaded after the window is set up, since that starts the
+    // LCD from scratch.
+    if (loadStateFile != NULL)
+    {
+        StateReader state(loadStateFile);
+        if (!machine->loadState(&state))
+        {
+            std::cerr << state.getErrorMessage() << std::endl;
+            delete window;
+            delete machine;
+            return EXIT_FAILURE;
+        }
+    }
+
+    CpuTrace *trace = NULL;
+    if (traceFile != NULL)
+    {
+        trace = new CpuTrace((size_t)traceSize);
+        trace->setCycle(machine->getCycle());
+        machine->getCpu()->setTrace(trace);
+        installTraceHandlers(trace, traceFile);
+    }
+
+    GdbStub *gdbStub = NULL;
+    if (gdbAddress != NULL)
+    {
+        gdbStub = new GdbStub(machine);
+        bool connected = gdbStub->listen(gdbAddress);
+        if (connected)
+        {
+            std::cout << "Waiting for GDB on " << gdbAddress << "." << std::endl;
+            connected = gdbStub->waitForClient();
+        }
+        if (!connected)
+        {
+            std::cerr << gdbStub->getErrorMessage() << std::endl;
+            removeTraceHandlers();
+            delete gdbStub;
+            delete window;
+            delete machine;
+            delete trace;
+            return EXIT_FAILURE;
+        }
+        if (trace != NULL)
+        {
+            gdbStub->setTrace(trace, traceFile);
+        }
+        if (symbolFile != NULL)
+        {
+            gdbStub->setSymbols(&symbols);
+        }
+        machine->setRunner(gdbStub);
+    }
+
+    MetricsExporter metrics;
+    if (metricsFile != NULL)
+    {
+        metrics.setFile(metricsFile);
+    }
+    if (metricsSocket != NULL && !metrics.listen(metricsSocket))
+    {
+        std::cerr << metrics.getErrorMessage() << std::endl;
+        removeTraceHandlers();
+        delete gdbStub;
+        delete window;
+        delete machine;
+        delete trace;
+        return EXIT_FAILURE;
+    }
+    if (metricsFile != NULL || metricsSocket != NULL)
+    {
+        metrics.start();
+    }
+
+    // Opened by the machine's thread, which may not be this one.
+    PerfCounters perfCounters;
+    if (countPerf)
+    {
+        machine->setPerfCounters(&perfCounters);
     }
 
     // Game Boy Loop.
     window->loop();
+    metrics.stop();
+
+    if (headless)
+    {
+        std::cout << "Ran " << machine->getLcd()->getFrameCount() << " frames, "
+                  << machine->getCycle() << " cycles." << std::endl;
+    }
+
+    if (countPerf)
+    {
+        uint64_t guestInstructions = 0;
+#ifdef GB_METRICS
+        Metrics::Snapshot snapshot;
+        Metrics::snapshot(&snapshot);
+        guestInstructions = snapshot.total[Metrics::INSTRUCTIONS];
+#endif
+        if (perfCounters.getSliceCount() == 0)
+        {
+            std::cerr << perfCounters.getErrorMessage() << std::endl;
+        }
+        else
+        {
+            perfCounters.writeText(std::cout, machine->getCycle(), guestInstructions);
+        }
+    }
+
+    if (recordFile != NULL && !recordLog.save(recordFile))
+    {
+        std::cerr << recordLog.getErrorMessage() << std::endl;
+    }
+
+    if (trace != NULL && !trace->save(traceFile))
+    {
+        std::cerr << "Could not write the trace to " << traceFile << "." 
+                  << std::endl;
+    }
+
+    if (profilePrefix != NULL)
+    {
+        std::string prefix = profilePrefix;
+        std::ofstream histogram((prefix + ".txt").c_str());
+        const SymbolTable* profileSymbols = symbolFile != NULL ? &symbols : NULL;
+        profiler.writeHistogram(histogram, 50, profileSymbols);
+        std::ofstream folded((prefix + ".folded").c_str());
+        profiler.writeFoldedStacks(folded, profileSymbols);
+        if (!histogram.good() || !folded.good())
+        {
+            std::cerr << "Could not write the profile to " << prefix << "." 
+                      << std::endl;
+        }
+    }
+
+    if (saveStateFile != NULL)
+    {
+        StateWriter state;
+        machine->saveState(&state);
+        if (!state.save(saveStateFile))
+        {
+            std::cerr << "Could not save state to " << saveStateFile << "." 
+                      << std::endl;
+        }
+    }
 
-    // Free resources.
+    // Free resources. The stub gives the memory its listeners back first, 
+    // and no signal may reach the trace once it is gone.
+    removeTraceHandlers();
+    delete gdbStub;
     delete window;
-    delete mem;
-    delete cpu;
-    delete lcd;
+    delete machine;
+    delete trace;
 
     return 0;
 }
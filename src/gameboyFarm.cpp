@@ -0,0 +1,204 @@
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "Common/Config.h"
+#include "Common/FramePacer.h"
+#include "Common/MetricsExporter.h"
+#include "Common/ThreadPool.h"
+#include "Farm/FarmJob.h"
+#include "Input/InputScript.h"
+
+static void usage()
+{
+    fprintf(stderr, "Usage: gameboy-farm [options] <rom file>...\n"
+                    "Runs many Game Boys at once, and reports how fast they ran.\n"
+                    "Options:\n"
+                    "  --instances <n>  Run n instances of each ROM, defaults to 1.\n"
+                    "  --frames <n>     Run each instance for n frames, defaults\n"
+                    "                   to 600.\n"
+                    "  --threads <n>    Run on n threads, defaults to one per core.\n"
+                    "  --input <file>   Hold down the buttons given in an input\n"
+                    "                   script.\n"
+                    "  --save-frames <prefix>\n"
+                    "                   Save the last frame of each instance to\n"
+                    "                   <prefix><instance>.pgm.\n"
+                    "  --skip-boot      Start the cartridges straight away,\n"
+                    "                   without the boot ROM checking their logo.\n"
+                    "  --metrics <file> Write the metrics of every thread to a\n"
+                    "                   file every second, as JSON if it ends\n"
+                    "                   in .json. Needs a build with GB_METRICS.\n");
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Parses the number following an option.
+ */
+static uint64_t parseNumber(int argc, char **argv, int *i)
+{
+    if (*i + 1 >= argc)
+    {
+        usage();
+    }
+    (*i)++;
+
+    char *end;
+    uint64_t value = strtoull(argv[*i], &end, 0);
+    if (*end != '\0')
+    {
+        usage();
+    }
+    return value;
+}
+
+/**
+ * Saves a frame of shades as a greyscale PGM image, with shade 0 as white.
+ */
+static bool saveFrame(const std::string fileName, const uint8_t *frame)
+{
+    FILE *file = fopen(fileName.c_str(), "wb");
+    if (file == NULL)
+    {
+        return false;
+    }
+    fprintf(file, "P5\n160 144\n3\n");
+    for (int i = 0; i < 160 * 144; i++)
+    {
+        fputc(3 - (frame[i] & 3), file);
+    }
+    return fclose(file) == 0;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<const char*> romFiles;
+    uint64_t instances = 1;
+    uint64_t frames = 600;
+    int threads = 0;
+    const char *inputFile = NULL;
+    const char *framePrefix = NULL;
+    bool skipBoot = false;
+    const char *metricsFile = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--instances") == 0)
+            instances = parseNumber(argc, argv, &i);
+        else if (strcmp(argv[i], "--frames") == 0)
+            frames = parseNumber(argc, argv, &i);
+        else if (strcmp(argv[i], "--threads") == 0)
+            threads = (int)parseNumber(argc, argv, &i);
+        else if (strcmp(argv[i], "--input") == 0 && i + 1 < argc)
+            inputFile = argv[++i];
+        else if (strcmp(argv[i], "--save-frames") == 0 && i + 1 < argc)
+            framePrefix = argv[++i];
+        else if (strcmp(argv[i], "--skip-boot") == 0)
+            skipBoot = true;
+        else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc)
+            metricsFile = argv[++i];
+        else if (argv[i][0] == '-')
+            usage();
+        else
+            romFiles.push_back(argv[i]);
+    }
+    if (romFiles.empty() || instances == 0)
+    {
+        usage();
+    }
+
+#ifndef GB_METRICS
+    if (metricsFile != NULL)
+    {
+        std::cerr << "--metrics needs a build with GB_METRICS turned on." 
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+#endif
+
+    InputScript inputScript;
+    if (inputFile != NULL && !inputScript.load(inputFile))
+    {
+        std::cerr << inputScript.getErrorMessage() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Set before any job creates its memory.
+    Config::DmgEnabled = !skipBoot;
+
+    std::vector<FarmJob*> jobs;
+    for (size_t i = 0; i < romFiles.size(); i++)
+    {
+        for (uint64_t j = 0; j < instances; j++)
+        {
+            jobs.push_back(new FarmJob(romFiles[i], frames, 
+                                       inputFile != NULL ? &inputScript : NULL));
+        }
+    }
+
+    MetricsExporter metrics;
+    if (metricsFile != NULL)
+    {
+        metrics.setFile(metricsFile);
+        metrics.start();
+    }
+
+    // Run every job.
+    ThreadPool pool(threads);
+    uint64_t start = FramePacer::now();
+    for (size_t i = 0; i < jobs.size(); i++)
+    {
+        pool.submit(jobs[i]);
+    }
+    pool.wait();
+    uint64_t elapsed = FramePacer::now() - start;
+    metrics.stop();
+
+    // Report the results.
+    int failed = 0;
+    uint64_t totalFrames = 0;
+    for (size_t i = 0; i < jobs.size(); i++)
+    {
+        FarmJob *job = jobs[i];
+        if (!job->succeeded())
+        {
+            std::cout << i << " " << job->getRomFile() << " failed" << std::endl;
+            failed++;
+            continue;
+        }
+        totalFrames += job->getFrames();
+
+        std::cout << i << " " << job->getRomFile() << std::hex << std::setfill('0')
+                  << " state " << std::setw(16) << job->getStateHash()
+                  << " frame " << std::setw(16) << job->getFrameHash()
+                  << std::dec << std::setfill(' ') << " "
+                  << job->getRunTime() / 1000000 << " ms" << std::endl;
+
+        if (framePrefix != NULL)
+        {
+            std::ostringstream fileName;
+            fileName << framePrefix << i << ".pgm";
+            if (!saveFrame(fileName.str(), job->getFrame()))
+            {
+                std::cerr << "Could not save " << fileName.str() << "." << std::endl;
+            }
+        }
+    }
+
+    double seconds = elapsed / 1e9;
+    std::cout << jobs.size() << " instances on " << pool.getThreadCount() 
+              << " threads ran " << totalFrames << " frames in " 
+              << std::fixed << std::setprecision(3) << seconds << " s, "
+              << std::setprecision(1) << totalFrames / seconds 
+              << " frames/s." << std::endl;
+
+    for (size_t i = 0; i < jobs.size(); i++)
+    {
+        delete jobs[i];
+    }
+    return failed == 0 ? 0 : EXIT_FAILURE;
+}
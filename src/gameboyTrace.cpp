@@ -0,0 +1,98 @@
+#include <iomanip>
+#include <iostream>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "Cpu/CpuProfiler.h"
+#include "Cpu/CpuTrace.h"
+#include "Cpu/SymbolTable.h"
+#include "Cpu/Z80Disassembler.h"
+
+static void usage()
+{
+    fprintf(stderr, "Usage: gameboy-trace [options] <trace file>\n"
+                    "Prints a trace written by gameboy --trace, one instruction\n"
+                    "per line with the registers from before it ran.\n"
+                    "Options:\n"
+                    "  --last <n>       Only print the last n instructions.\n"
+                    "  --sym <file>     Name addresses with the symbols in an\n"
+                    "                   RGBDS .sym file.\n");
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv)
+{
+    const char *traceFile = NULL;
+    uint64_t last = 0;
+    const char *symbolFile = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--last") == 0 && i + 1 < argc)
+            last = strtoull(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "--sym") == 0 && i + 1 < argc)
+            symbolFile = argv[++i];
+        else if (argv[i][0] == '-' || traceFile != NULL)
+            usage();
+        else
+            traceFile = argv[i];
+    }
+    if (traceFile == NULL)
+    {
+        usage();
+    }
+
+    std::vector<TraceEntry> entries;
+    uint64_t first;
+    std::string error;
+    if (!CpuTrace::load(traceFile, &entries, &first, &error))
+    {
+        std::cerr << error << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    SymbolTable symbols;
+    if (symbolFile != NULL && !symbols.load(symbolFile))
+    {
+        std::cerr << symbols.getErrorMessage() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    size_t start = 0;
+    if (last != 0 && last < entries.size())
+    {
+        start = entries.size() - (size_t)last;
+    }
+    std::cout << "Instructions " << first + start << " to "
+              << first + entries.size() << ":" << std::endl;
+
+    for (size_t i = start; i < entries.size(); i++)
+    {
+        const TraceEntry& entry = entries[i];
+        const char* label = symbols.getName(entry.pc);
+        if (label != NULL)
+        {
+            std::cout << label << ":" << std::endl;
+        }
+        int length = Z80Disassembler::getLength(entry.bytes[0]);
+        char bytes[16] = "";
+        for (int b = 0; b < length; b++)
+        {
+            snprintf(bytes + b * 3, sizeof(bytes) - b * 3, "%02X ", entry.bytes[b]);
+        }
+        char registers[64];
+        snprintf(registers, sizeof(registers),
+                 "AF=%04X BC=%04X DE=%04X HL=%04X SP=%04X",
+                 entry.af, entry.bc, entry.de, entry.hl, entry.sp);
+
+        std::cout << std::setw(12) << entry.cycle << "  "
+                  << CpuProfiler::formatAddress(entry.pc) << "  "
+                  << std::left << std::setw(10) << bytes
+                  << std::setw(18) << Z80Disassembler::disassemble(entry.bytes, entry.pc, &symbols)
+                  << std::right << registers << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,269 @@
+#include <iostream>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "Common/FileUtils.h"
+#include "Common/Metrics.h"
+#include "Common/ThreadPool.h"
+#include "Cpu/SymbolTable.h"
+#include "Cpu/Z80Disassembler.h"
+
+#define BANK_SIZE 0x4000
+
+static void usage()
+{
+    fprintf(stderr, "Usage: gbdis [options] <rom file>\n"
+                    "Disassembles every bank of a ROM, one instruction per line,\n"
+                    "with the banks split over several threads.\n"
+                    "Options:\n"
+                    "  --sym <file>     Name addresses with the symbols in an\n"
+                    "                   RGBDS .sym file, and print them as labels.\n"
+                    "  --out <file>     Write to a file instead of stdout.\n"
+                    "  --bank <n>       Only disassemble bank n.\n"
+                    "  --threads <n>    Run on n threads, defaults to one per core.\n"
+                    "  --stats          Print how fast the ROM was disassembled.\n");
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Parses the number following an option.
+ */
+static uint64_t parseNumber(int argc, char **argv, int *i)
+{
+    if (*i + 1 >= argc)
+    {
+        usage();
+    }
+    (*i)++;
+
+    char *end;
+    uint64_t value = strtoull(argv[*i], &end, 0);
+    if (*end != '\0')
+    {
+        usage();
+    }
+    return value;
+}
+
+static const char hexDigits[] = "0123456789ABCDEF";
+
+static char *writeHex(char *out, unsigned value, int digits)
+{
+    for (int i = digits - 1; i >= 0; i--)
+    {
+        out[i] = hexDigits[value & 0x0F];
+        value >>= 4;
+    }
+    return out + digits;
+}
+
+/**
+ * Disassembles one bank into text, from the start of the bank to its end.
+ * Instructions that would run past the end of the bank are written as
+ * bytes.
+ */
+class BankTask : public Task
+{
+public:
+    BankTask(const data_t *rom, int bank, const SymbolTable *symbols)
+        : rom(rom), bank(bank), symbols(symbols)
+    {
+    }
+
+    void run()
+    {
+        const data_t *data = rom + (size_t)bank * BANK_SIZE;
+        uint16_t base = bank == 0 ? 0x0000 : 0x4000;
+        text.reserve(BANK_SIZE * 24);
+
+        char line[320];
+        int offset = 0;
+        while (offset < BANK_SIZE)
+        {
+            uint16_t addr = (uint16_t)(base + offset);
+            const char *label = symbols != NULL ? symbols->getName(addr, bank) : NULL;
+            if (label != NULL)
+            {
+                text += label;
+                text += ":\n";
+            }
+
+            int length = Z80Disassembler::getLength(data[offset]);
+            if (offset + length > BANK_SIZE)
+            {
+                length = 1;
+            }
+
+            // BB:AAAA  XX XX XX  instruction
+            char *out = writeHex(line, bank, 2);
+            *out++ = ':';
+            out = writeHex(out, addr, 4);
+            *out++ = ' ';
+            *out++ = ' ';
+            for (int i = 0; i < 3; i++)
+            {
+                if (i < length)
+                {
+                    out = writeHex(out, data[offset + i], 2);
+                }
+                else
+                {
+                    *out++ = ' ';
+                    *out++ = ' ';
+                }
+                *out++ = ' ';
+            }
+            *out++ = ' ';
+
+            if (length == 1 && Z80Disassembler::getLength(data[offset]) > 1)
+            {
+                memcpy(out, "DB $", 4);
+                out = writeHex(out + 4, data[offset], 2);
+            }
+            else
+            {
+                out += Z80Disassembler::disassemble(data + offset, addr, out,
+                                                    line + sizeof(line) - 1 - out,
+                                                    symbols, bank);
+            }
+            *out++ = '\n';
+            text.append(line, out - line);
+            offset += length;
+        }
+    }
+
+    std::string text;
+
+private:
+    const data_t *rom;
+    int bank;
+    const SymbolTable *symbols;
+};
+
+int main(int argc, char **argv)
+{
+    const char *romFile = NULL;
+    const char *symbolFile = NULL;
+    const char *outFile = NULL;
+    int onlyBank = -1;
+    int threads = 0;
+    bool stats = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--sym") == 0 && i + 1 < argc)
+            symbolFile = argv[++i];
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+            outFile = argv[++i];
+        else if (strcmp(argv[i], "--bank") == 0)
+            onlyBank = (int)parseNumber(argc, argv, &i);
+        else if (strcmp(argv[i], "--threads") == 0)
+            threads = (int)parseNumber(argc, argv, &i);
+        else if (strcmp(argv[i], "--stats") == 0)
+            stats = true;
+        else if (argv[i][0] == '-' || romFile != NULL)
+            usage();
+        else
+            romFile = argv[i];
+    }
+    if (romFile == NULL)
+    {
+        usage();
+    }
+
+    SymbolTable symbols;
+    if (symbolFile != NULL && !symbols.load(symbolFile))
+    {
+        std::cerr << symbols.getErrorMessage() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    size_t length;
+    char *file = readFileToBuffer(romFile, &length);
+    if (file == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    if (length == 0)
+    {
+        std::cerr << romFile << " is empty." << std::endl;
+        delete[] file;
+        return EXIT_FAILURE;
+    }
+    // The last bank is padded with zeros if the ROM is cut short.
+    int bankCount = (int)((length + BANK_SIZE - 1) / BANK_SIZE);
+    std::vector<data_t> rom((size_t)bankCount * BANK_SIZE, 0);
+    memcpy(&rom[0], file, length);
+    delete[] file;
+
+    if (onlyBank >= bankCount)
+    {
+        std::cerr << romFile << " only has " << bankCount << " banks." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    FILE *out = stdout;
+    if (outFile != NULL)
+    {
+        out = fopen(outFile, "w");
+        if (out == NULL)
+        {
+            std::cerr << "Could not open " << outFile << "." << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    uint64_t start = Metrics::now();
+    std::vector<BankTask*> tasks;
+    for (int bank = 0; bank < bankCount; bank++)
+    {
+        if (onlyBank < 0 || bank == onlyBank)
+        {
+            tasks.push_back(new BankTask(&rom[0], bank,
+                                         symbolFile != NULL ? &symbols : NULL));
+        }
+    }
+    {
+        ThreadPool pool(threads);
+        for (size_t i = 0; i < tasks.size(); i++)
+        {
+            pool.submit(tasks[i]);
+        }
+        pool.wait();
+    }
+    uint64_t elapsed = Metrics::now() - start;
+
+    bool written = true;
+    size_t textSize = 0;
+    for (size_t i = 0; i < tasks.size(); i++)
+    {
+        const std::string &text = tasks[i]->text;
+        written &= fwrite(text.data(), 1, text.size(), out) == text.size();
+        textSize += text.size();
+        delete tasks[i];
+    }
+    if (outFile != NULL)
+    {
+        written &= fclose(out) == 0;
+    }
+    if (!written)
+    {
+        std::cerr << "Could not write the disassembly." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (stats)
+    {
+        double seconds = elapsed / 1e9;
+        double romMB = tasks.size() * (double)BANK_SIZE / (1024 * 1024);
+        fprintf(stderr, "Disassembled %d banks, %.2f MB of ROM into %.2f MB of "
+                        "text, in %.2f ms (%.0f MB/s).\n",
+                (int)tasks.size(), romMB, textSize / (1024.0 * 1024.0),
+                seconds * 1000, seconds > 0 ? romMB / seconds : 0.0);
+    }
+    return 0;
+}
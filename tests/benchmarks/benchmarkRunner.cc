@@ -0,0 +1,119 @@
+#include <iomanip>
+#include <time.h>
+#include <unistd.h>
+
+#include "benchmarkRunner.h"
+
+/** No benchmark is run for more iterations than this. */
+#define MAX_ITERATIONS 1000000000ull
+
+static uint64_t getTime(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * Writes a string as a JSON string.
+ */
+static void writeString(std::ostream& out, const std::string& str)
+{
+    out << '"';
+    for (size_t i = 0; i < str.size(); i++)
+    {
+        if (str[i] == '"' || str[i] == '\\')
+        {
+            out << '\\';
+        }
+        out << str[i];
+    }
+    out << '"';
+}
+
+BenchmarkRunner::BenchmarkRunner(uint64_t minTime, const std::string& filter)
+    : minTime(minTime), filter(filter)
+{
+}
+
+void BenchmarkRunner::run(const std::string& name, Benchmark* benchmark)
+{
+    if (name.find(filter) == std::string::npos)
+    {
+        return;
+    }
+
+    // Warm up the caches first.
+    benchmark->run(1);
+
+    uint64_t iterations = 1;
+    while (true)
+    {
+        uint64_t realStart = getTime(CLOCK_MONOTONIC);
+        uint64_t cpuStart = getTime(CLOCK_PROCESS_CPUTIME_ID);
+        benchmark->run(iterations);
+        uint64_t cpuTime = getTime(CLOCK_PROCESS_CPUTIME_ID) - cpuStart;
+        uint64_t realTime = getTime(CLOCK_MONOTONIC) - realStart;
+
+        if (realTime >= minTime || iterations >= MAX_ITERATIONS)
+        {
+            Result result;
+            result.name = name;
+            result.iterations = iterations;
+            result.realTime = (double)realTime / iterations;
+            result.cpuTime = (double)cpuTime / iterations;
+            results.push_back(result);
+            return;
+        }
+
+        // Aim a bit past the minimum time, but don't grow too quickly since
+        // short runs are noisy.
+        double scale = realTime == 0 ? 10.0 : 1.4 * minTime / realTime;
+        if (scale > 10.0)
+        {
+            scale = 10.0;
+        }
+        uint64_t next = (uint64_t)(iterations * scale);
+        iterations = next > iterations ? next : iterations + 1;
+        if (iterations > MAX_ITERATIONS)
+        {
+            iterations = MAX_ITERATIONS;
+        }
+    }
+}
+
+void BenchmarkRunner::writeJson(std::ostream& out,
+                                const std::string& executable) const
+{
+    char date[64];
+    time_t now = time(NULL);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", localtime(&now));
+
+    out << "{\n"
+        << "  \"context\": {\n"
+        << "    \"date\": ";
+    writeString(out, date);
+    out << ",\n    \"executable\": ";
+    writeString(out, executable);
+    out << ",\n    \"num_cpus\": " << sysconf(_SC_NPROCESSORS_ONLN) << ",\n"
+        << "    \"library_build_type\": \"release\"\n"
+        << "  },\n"
+        << "  \"benchmarks\": [";
+
+    out << std::fixed << std::setprecision(3);
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const Result& result = results[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\n      \"name\": ";
+        writeString(out, result.name);
+        out << ",\n      \"run_name\": ";
+        writeString(out, result.name);
+        out << ",\n      \"run_type\": \"iteration\",\n"
+            << "      \"iterations\": " << result.iterations << ",\n"
+            << "      \"real_time\": " << result.realTime << ",\n"
+            << "      \"cpu_time\": " << result.cpuTime << ",\n"
+            << "      \"time_unit\": \"ns\"\n"
+            << "    }";
+    }
+    out << "\n  ]\n}\n";
+}
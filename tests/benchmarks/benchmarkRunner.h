@@ -0,0 +1,73 @@
+#ifndef _BENCHMARK_RUNNER_H_
+#define _BENCHMARK_RUNNER_H_
+
+#include <ostream>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * A piece of code to time.
+ */
+class Benchmark
+{
+public:
+    virtual ~Benchmark() {}
+
+    /**
+     * Runs the code being timed.
+     *
+     * @param iterations Number of times to run it.
+     */
+    virtual void run(uint64_t iterations) = 0;
+};
+
+/**
+ * Times benchmarks and reports the results as JSON, in the same layout as
+ * Google Benchmark's --benchmark_format=json, so the same tools can compare
+ * runs.
+ */
+class BenchmarkRunner
+{
+public:
+    /**
+     * Creates the runner.
+     *
+     * @param minTime Minimum time to run each benchmark for, in nanoseconds.
+     * @param filter Only benchmarks with this in their name are run. An empty
+     *     filter runs all of them.
+     */
+    BenchmarkRunner(uint64_t minTime, const std::string& filter);
+
+    /**
+     * Runs a benchmark for more and more iterations, until it takes at least
+     * the minimum time.
+     *
+     * @param name Name to report the benchmark under.
+     * @param benchmark The benchmark to run.
+     */
+    void run(const std::string& name, Benchmark* benchmark);
+
+    /**
+     * Writes the results of every benchmark that was run as JSON.
+     *
+     * @param out Where to write the results.
+     * @param executable Name of the benchmark executable.
+     */
+    void writeJson(std::ostream& out, const std::string& executable) const;
+
+private:
+    struct Result
+    {
+        std::string name;
+        uint64_t iterations;
+        double realTime;    //!< Nanoseconds per iteration.
+        double cpuTime;     //!< Nanoseconds of CPU time per iteration.
+    };
+
+    uint64_t minTime;
+    std::string filter;
+    std::vector<Result> results;
+};
+
+#endif
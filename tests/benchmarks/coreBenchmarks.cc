@@ -0,0 +1,459 @@
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "../../src/Common/Config.h"
+#include "../../src/Common/Hash.h"
+#include "../../src/Cpu/Z80Cpu.h"
+#include "../../src/Cpu/Z80Disassembler.h"
+#include "../../src/Lcd/LcdBackground.h"
+#include "../../src/Machine/GBMachine.h"
+#include "../../src/Memory/CartridgeHeader.h"
+#include "../../src/Memory/Memory.h"
+#include "../../src/Memory/MemoryLoader.h"
+#include "../unittests/testCartridge.h"
+#include "benchmarkRunner.h"
+
+#define CODE_ADDR 0xC000
+#define DATA_ADDR 0xC100
+
+/** Results that are read are stored here, so they are not optimized out. */
+static volatile data_t sink;
+
+/**
+ * Opcodes that the Game Boy does not have.
+ */
+static bool isIllegalOpcode(int op)
+{
+    static const int illegal[] =
+    {
+        0xD3, 0xDB, 0xDD, 0xE3, 0xE4, 0xEB, 0xEC, 0xED, 0xF4, 0xFC, 0xFD
+    };
+    for (size_t i = 0; i < sizeof(illegal) / sizeof(illegal[0]); i++)
+    {
+        if (op == illegal[i])
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Times a single instruction. The instruction is run from work RAM, and its
+ * operands point back into work RAM, so it can be run over and over. Every
+ * iteration also puts the registers back, which costs the same for every
+ * opcode.
+ */
+class OpcodeBenchmark : public Benchmark
+{
+public:
+    OpcodeBenchmark(int opcode, bool cbPage)
+        : memory(createTestMemory()), cpu(memory)
+    {
+        cpu.init();
+
+        int addr = CODE_ADDR;
+        if (cbPage)
+        {
+            memory->write(addr++, 0xCB);
+        }
+        memory->write(addr++, opcode);
+        // Immediate operands: DATA_ADDR for 16 bits, 0 for 8 bits.
+        memory->write(addr++, DATA_ADDR & 0xFF);
+        memory->write(addr++, DATA_ADDR >> 8);
+
+        registers = *cpu.GetRegisters();
+        registers.PC = CODE_ADDR;
+        registers.SP = 0xDFF0;
+        registers.BC = DATA_ADDR + 0x80;
+        registers.DE = DATA_ADDR;
+        registers.HL = DATA_ADDR;
+    }
+
+    ~OpcodeBenchmark()
+    {
+        delete memory;
+    }
+
+    void run(uint64_t iterations)
+    {
+        Z80Registers* cpuRegisters = cpu.GetRegisters();
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            *cpuRegisters = registers;
+            cpu.step();
+        }
+    }
+
+private:
+    Memory* memory;
+    Z80Cpu cpu;
+    Z80Registers registers;
+};
+
+/**
+ * Times reading from, or writing to, one address.
+ */
+class MemoryBenchmark : public Benchmark
+{
+public:
+    MemoryBenchmark(addr_t addr, bool write)
+        : memory(createTestMemory()), addr(addr), write(write)
+    {
+    }
+
+    ~MemoryBenchmark()
+    {
+        delete memory;
+    }
+
+    void run(uint64_t iterations)
+    {
+        if (write)
+        {
+            for (uint64_t i = 0; i < iterations; i++)
+            {
+                memory->write(addr, 0);
+            }
+        }
+        else
+        {
+            for (uint64_t i = 0; i < iterations; i++)
+            {
+                sink = memory->read(addr);
+            }
+        }
+    }
+
+private:
+    Memory* memory;
+    addr_t addr;
+    bool write;
+};
+
+/**
+ * Times drawing a scanline of background tiles, going down the screen one
+ * line per iteration.
+ */
+class ScanlineBenchmark : public Benchmark
+{
+public:
+    ScanlineBenchmark()
+        : memory(createTestMemory()), background(memory, frame)
+    {
+        IOMemory* ioPorts = memory->getIOMemory();
+        ioPorts->LCDC = 0x91;
+        ioPorts->BGP = 0xE4;
+
+        // Give every tile a different pattern, and use all of them.
+        for (int addr = 0x8000; addr < 0x9000; addr++)
+        {
+            memory->write(addr, (addr * 37) >> 3);
+        }
+        for (int addr = 0x9800; addr < 0x9C00; addr++)
+        {
+            memory->write(addr, addr & 0xFF);
+        }
+    }
+
+    ~ScanlineBenchmark()
+    {
+        delete memory;
+    }
+
+    void run(uint64_t iterations)
+    {
+        IOMemory* ioPorts = memory->getIOMemory();
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            ioPorts->LY = i % 144;
+            background.drawScanline();
+        }
+    }
+
+private:
+    Memory* memory;
+    uint8_t frame[160 * 144];
+    LcdBackground background;
+};
+
+/**
+ * Times a whole frame of a cartridge.
+ */
+class FrameBenchmark : public Benchmark
+{
+public:
+    /**
+     * @param mem Memory with the cartridge loaded, owned by the benchmark.
+     */
+    FrameBenchmark(Memory* mem)
+    {
+        machine = new GBMachine(mem);
+        machine->getLcd()->init(NULL);
+    }
+
+    ~FrameBenchmark()
+    {
+        delete machine;
+    }
+
+    /**
+     * Creates memory for a program that keeps writing to video memory with
+     * the LCD on.
+     */
+    static Memory* createVideoProgram()
+    {
+        static const data_t program[] =
+        {
+            0x3E, 0x91,         // LD A, 0x91
+            0xE0, 0x40,         // LDH (0x40), A
+            0x21, 0x00, 0x80,   // LD HL, 0x8000
+            0x3C,               // loop: INC A
+            0x22,               // LD (HL+), A
+            0xEA, 0x00, 0xC0,   // LD (0xC000), A
+            0x18, 0xF9          // JR loop
+        };
+        return createTestMemory(program, sizeof(program));
+    }
+
+    void run(uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            machine->runFrame();
+        }
+    }
+
+private:
+    GBMachine* machine;
+};
+
+/**
+ * Times parsing the header of a 32KB cartridge.
+ */
+class CartridgeHeaderBenchmark : public Benchmark
+{
+public:
+    CartridgeHeaderBenchmark()
+    {
+        memset(cart, 0, TEST_CART_SIZE);
+        memcpy(cart + 0x134, "BENCHMARK", 9);
+    }
+
+    void run(uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            CartridgeHeader header(cart, TEST_CART_SIZE);
+            sink = header.desc.size();
+        }
+    }
+
+private:
+    data_t cart[TEST_CART_SIZE];
+};
+
+/**
+ * Times disassembling a 16KB bank of random bytes, one iteration per bank.
+ */
+class DisassemblerBenchmark : public Benchmark
+{
+public:
+    DisassemblerBenchmark()
+    {
+        uint32_t seed = 1;
+        for (int i = 0; i < BANK_SIZE + 2; i++)
+        {
+            seed = seed * 1103515245 + 12345;
+            bank[i] = (data_t)(seed >> 16);
+        }
+    }
+
+    void run(uint64_t iterations)
+    {
+        char text[64];
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            for (int offset = 0; offset < BANK_SIZE; )
+            {
+                Z80Disassembler::disassemble(bank + offset, 0x4000 + offset,
+                                             text, sizeof(text));
+                sink = text[0];
+                offset += Z80Disassembler::getLength(bank[offset]);
+            }
+        }
+    }
+
+private:
+    static const int BANK_SIZE = 0x4000;
+    data_t bank[BANK_SIZE + 2];
+};
+
+/**
+ * Hashes a frame of shades, as --hash-frames does for every frame.
+ */
+class HashBenchmark : public Benchmark
+{
+public:
+    HashBenchmark()
+    {
+        for (int i = 0; i < FRAME_SIZE; i++)
+        {
+            frame[i] = (data_t)(i * 7 % 4);
+        }
+    }
+
+    void run(uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            sink = (data_t)hashBytes(frame, FRAME_SIZE);
+        }
+    }
+
+private:
+    static const int FRAME_SIZE = 160 * 144;
+    data_t frame[FRAME_SIZE];
+};
+
+static void usage()
+{
+    fprintf(stderr, "Usage: coreBenchmarks [options]\n"
+                    "Times the core of the emulator, and writes the results\n"
+                    "as JSON.\n"
+                    "Options:\n"
+                    "  --filter <text>  Only run benchmarks with text in their\n"
+                    "                   name.\n"
+                    "  --min-time <ms>  Run each benchmark for at least this\n"
+                    "                   long, defaults to 10.\n"
+                    "  --out <file>     Write the results to a file instead of\n"
+                    "                   stdout.\n"
+                    "  --rom <file>     Also time whole frames of a cartridge,\n"
+                    "                   such as the workloads made by\n"
+                    "                   tests/make/generateWorkloadCarts.py.\n"
+                    "                   Can be given more than once.\n");
+    exit(EXIT_FAILURE);
+}
+
+static std::string hexName(const char* prefix, int value)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%s0x%02X", prefix, value);
+    return name;
+}
+
+int main(int argc, char **argv)
+{
+    std::string filter;
+    uint64_t minTimeMs = 10;
+    const char* outFile = NULL;
+    std::vector<std::string> romFiles;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+            filter = argv[++i];
+        else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+            minTimeMs = strtoull(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+            outFile = argv[++i];
+        else if (strcmp(argv[i], "--rom") == 0 && i + 1 < argc)
+            romFiles.push_back(argv[++i]);
+        else
+            usage();
+    }
+
+    // None of the cartridges have a logo for the boot ROM to check.
+    Config::DmgEnabled = false;
+
+    BenchmarkRunner runner(minTimeMs * 1000000, filter);
+
+    for (int op = 0; op < 0x100; op++)
+    {
+        if (op == 0xCB || isIllegalOpcode(op))
+        {
+            continue;
+        }
+        OpcodeBenchmark benchmark(op, false);
+        runner.run(hexName("Opcode/", op), &benchmark);
+    }
+    for (int op = 0; op < 0x100; op++)
+    {
+        OpcodeBenchmark benchmark(op, true);
+        runner.run(hexName("Opcode/CB/", op), &benchmark);
+    }
+
+    static const struct
+    {
+        const char* name;
+        addr_t addr;
+    } regions[ADDRESS_RANGE_SIZE] =
+    {
+        { "RomBank0_1", 0x0100 }, { "RomBank0_2", 0x2100 },
+        { "RomBanks_1", 0x4100 }, { "RomBanks_2", 0x6100 },
+        { "VRAM", 0x8100 },       { "ERam", 0xA100 },
+        { "WRam0", 0xC100 },      { "WRam1", 0xD100 },
+        { "ECHORAM", 0xE100 },    { "Oam", 0xFE10 },
+        { "NonUseable", 0xFEB0 }, { "IOPorts", 0xFF42 },
+        { "HRam", 0xFF90 },       { "IReg", 0xFFFF }
+    };
+    for (int i = 0; i < ADDRESS_RANGE_SIZE; i++)
+    {
+        MemoryBenchmark read(regions[i].addr, false);
+        runner.run(std::string("Memory/read/") + regions[i].name, &read);
+        MemoryBenchmark write(regions[i].addr, true);
+        runner.run(std::string("Memory/write/") + regions[i].name, &write);
+    }
+
+    {
+        ScanlineBenchmark benchmark;
+        runner.run("LcdBackground/drawScanline", &benchmark);
+    }
+    {
+        FrameBenchmark benchmark(FrameBenchmark::createVideoProgram());
+        runner.run("GBMachine/runFrame", &benchmark);
+    }
+    for (size_t i = 0; i < romFiles.size(); i++)
+    {
+        Memory* mem = MemoryLoader::loadCartridge(romFiles[i]);
+        if (mem == NULL)
+        {
+            return EXIT_FAILURE;
+        }
+        std::string name = romFiles[i].substr(romFiles[i].find_last_of('/') + 1);
+        FrameBenchmark benchmark(mem);
+        runner.run("GBMachine/runFrame/" + name, &benchmark);
+    }
+    {
+        CartridgeHeaderBenchmark benchmark;
+        runner.run("CartridgeHeader/parse", &benchmark);
+    }
+    {
+        DisassemblerBenchmark benchmark;
+        runner.run("Z80Disassembler/bank", &benchmark);
+    }
+    {
+        HashBenchmark benchmark;
+        runner.run("Hash/frame", &benchmark);
+    }
+
+    if (outFile != NULL)
+    {
+        std::ofstream out(outFile);
+        if (!out.is_open())
+        {
+            std::cerr << "Could not open " << outFile << "." << std::endl;
+            return EXIT_FAILURE;
+        }
+        runner.writeJson(out, argv[0]);
+    }
+    else
+    {
+        runner.writeJson(std::cout, argv[0]);
+    }
+    return 0;
+}
@@ -0,0 +1,134 @@
+#include <iomanip>
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../src/Common/Config.h"
+#include "../../src/Common/FramePacer.h"
+#include "../../src/Cpu/LockstepCpu.h"
+#include "../unittests/testCartridge.h"
+
+#define SEED_ADDR 0x150
+#define MAX_LANES 16
+
+/**
+ * An arithmetic loop that every lane runs on a seed of its own, without ever
+ * diverging.
+ */
+static const data_t benchmarkProgram[] =
+{
+    0xFA, 0x50, 0x01,   // LD A, (0x0150)
+    0x47,               // LD B, A
+    0x0E, 0x00,         // LD C, 0x00
+    0x80,               // loop: ADD A, B
+    0xA9,               // XOR C
+    0x4F,               // LD C, A
+    0xCE, 0x03,         // ADC A, 0x03
+    0x57,               // LD D, A
+    0x05,               // DEC B
+    0x1C,               // INC E
+    0xB3,               // OR E
+    0xE6, 0x7F,         // AND 0x7F
+    0xC3, 0x06, 0x01    // JP loop
+};
+
+static Memory* createMemory(uint8_t seed)
+{
+    data_t program[SEED_ADDR - 0x100 + 1];
+    memset(program, 0, sizeof(program));
+    memcpy(program, benchmarkProgram, sizeof(benchmarkProgram));
+    program[SEED_ADDR - 0x100] = seed;
+    return createTestMemory(program, sizeof(program));
+}
+
+static void report(const char* name, int lanes, uint64_t steps, uint64_t ns)
+{
+    double instructions = (double)lanes * steps;
+    std::cout << std::left << std::setw(24) << name << std::right
+              << std::setw(10) << std::fixed << std::setprecision(2)
+              << (double)ns / instructions << " ns/instruction, "
+              << std::setw(8) << std::setprecision(1)
+              << instructions * 1000.0 / ns << " MIPS" << std::endl;
+}
+
+/**
+ * Steps lanes scalar Z80Cpus one after the other.
+ */
+static uint64_t runScalar(int lanes, uint64_t steps)
+{
+    Memory* memory[MAX_LANES];
+    Z80Cpu* cpu[MAX_LANES];
+    for (int l = 0; l < lanes; l++)
+    {
+        memory[l] = createMemory(l + 1);
+        cpu[l] = new Z80Cpu(memory[l]);
+        cpu[l]->init();
+    }
+
+    uint64_t start = FramePacer::now();
+    for (uint64_t i = 0; i < steps; i++)
+    {
+        for (int l = 0; l < lanes; l++)
+        {
+            cpu[l]->step();
+        }
+    }
+    uint64_t ns = FramePacer::now() - start;
+
+    for (int l = 0; l < lanes; l++)
+    {
+        delete cpu[l];
+        delete memory[l];
+    }
+    return ns;
+}
+
+template<int Lanes>
+static uint64_t runLockstep(uint64_t steps)
+{
+    Memory* memory[Lanes];
+    for (int l = 0; l < Lanes; l++)
+    {
+        memory[l] = createMemory(l + 1);
+    }
+    LockstepCpu<Lanes>* lockstep = new LockstepCpu<Lanes>(memory);
+    lockstep->init();
+
+    uint64_t start = FramePacer::now();
+    for (uint64_t i = 0; i < steps; i++)
+    {
+        lockstep->step();
+    }
+    uint64_t ns = FramePacer::now() - start;
+
+    delete lockstep;
+    for (int l = 0; l < Lanes; l++)
+    {
+        delete memory[l];
+    }
+    return ns;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t steps = 1000000;
+    if (argc > 1)
+    {
+        steps = strtoull(argv[1], NULL, 0);
+    }
+    if (steps == 0)
+    {
+        std::cerr << "Usage: lockstepBenchmark [steps]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // The program has no cartridge logo.
+    Config::DmgEnabled = false;
+
+    std::cout << "Running " << steps << " instructions per lane." << std::endl;
+    report("Z80Cpu x 8", 8, steps, runScalar(8, steps));
+    report("LockstepCpu<8>", 8, steps, runLockstep<8>(steps));
+    report("Z80Cpu x 16", 16, steps, runScalar(16, steps));
+    report("LockstepCpu<16>", 16, steps, runLockstep<16>(steps));
+    return 0;
+}
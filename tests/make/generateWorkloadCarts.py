@@ -0,0 +1,347 @@
+#!/usr/bin/env python
+
+'''
+Generates synthetic cartridges with known instruction mixes, to use as
+performance workloads. The cartridges are built from scratch here, so they
+are free to share, and the same script always makes the same bytes.
+
+The Nintendo logo is left out of the header, so the boot ROM will not start
+them. Run them with --skip-boot.
+
+Three of the workloads are written for hardware the emulator does not have
+yet, and for now time nothing more than a busy loop:
+
+  bank       The memory has no bank controller, so the bank switches are
+             ignored and every read sees the same bank.
+  halt       Z80InstructionSet::halt() does nothing, so HALT does not sleep.
+  interrupt  Z80Cpu::step() does not check for interrupts, so no handler
+             ever runs.
+
+They are kept so the numbers can be compared once those are implemented.
+
+Usage: generateWorkloadCarts.py [-o <dir>] [workload...]
+'''
+
+import argparse
+import os
+
+KB_SIZE = 0x400
+ROM_BANK_SIZE = 16*KB_SIZE
+
+# ROM size codes used in the header (0x0148)
+romMap = { 0x00: 32*KB_SIZE,
+           0x01: 64*KB_SIZE,
+           0x02: 128*KB_SIZE }
+
+# cartridge types used in the header (0x0147)
+ROM_ONLY = 0x00
+MBC1 = 0x01
+
+# I/O ports, as offsets from 0xFF00 for LDH
+P_TMA = 0x06
+P_TAC = 0x07
+P_IF = 0x0F
+P_LCDC = 0x40
+P_STAT = 0x41
+P_LY = 0x44
+P_IE = 0xFF
+
+LCD_ON = 0x91
+
+
+class Program:
+    '''
+    A tiny assembler. Bytes are emitted in order, and jumps can refer to
+    labels that are defined later.
+    '''
+    def __init__( self, origin ):
+        self.origin = origin
+        self.code = bytearray()
+        self.labels = {}
+        self.fixups = []
+
+    def here( self ):
+        return self.origin + len(self.code)
+
+    def emit( self, *values ):
+        for value in values:
+            self.code.append( value & 0xFF )
+
+    def label( self, name ):
+        self.labels[name] = self.here()
+
+    def jr( self, opcode, name ):
+        '''JR, with opcode 0x18 or one of the conditional ones.'''
+        self.emit( opcode, 0 )
+        self.fixups.append( ('jr', len(self.code) - 1, name) )
+
+    def jp( self, opcode, name ):
+        '''JP or CALL, with an absolute address.'''
+        self.emit( opcode, 0, 0 )
+        self.fixups.append( ('jp', len(self.code) - 2, name) )
+
+    def assemble( self ):
+        for kind, offset, name in self.fixups:
+            target = self.labels[name]
+            if kind == 'jr':
+                delta = target - (self.origin + offset + 1)
+                if not -128 <= delta <= 127:
+                    raise ValueError( 'JR to {0} is too far'.format( name ) )
+                self.code[offset] = delta & 0xFF
+            else:
+                self.code[offset] = target & 0xFF
+                self.code[offset + 1] = target >> 8
+        return self.code
+
+
+'''
+Assembles a program into the cartridge, at its origin.
+'''
+def place( rom, program ):
+    code = program.assemble()
+    rom[program.origin:program.origin + len(code)] = code
+
+
+'''
+Common start up code: interrupts off, a stack in high RAM.
+'''
+def startUp( p ):
+    p.emit( 0xF3 )                      # DI
+    p.emit( 0x31, 0xFE, 0xFF )          # LD SP, 0xFFFE
+
+def lcdOn( p ):
+    p.emit( 0x3E, LCD_ON )              # LD A, LCD_ON
+    p.emit( 0xE0, P_LCDC )              # LDH (LCDC), A
+
+def waitForVBlank( p, name ):
+    p.label( name )
+    p.emit( 0xF0, P_LY )                # LDH A, (LY)
+    p.emit( 0xFE, 144 )                 # CP 144
+    p.jr( 0x20, name )                  # JR NZ, wait
+
+
+'''
+Register arithmetic with no memory accesses, the bread and butter of the
+interpreter.
+'''
+def aluWorkload( rom ):
+    p = Program( 0x150 )
+    startUp( p )
+    lcdOn( p )
+    p.emit( 0x06, 1, 0x0E, 3, 0x16, 5, 0x1E, 7 )    # LD B/C/D/E, n
+    p.label( 'loop' )
+    p.emit( 0x80 )                      # ADD A, B
+    p.emit( 0x89 )                      # ADC A, C
+    p.emit( 0x92 )                      # SUB D
+    p.emit( 0x9B )                      # SBC A, E
+    p.emit( 0xE6, 0xF7 )                # AND 0xF7
+    p.emit( 0xA8 )                      # XOR B
+    p.emit( 0xB1 )                      # OR C
+    p.emit( 0xBA )                      # CP D
+    p.emit( 0x04, 0x0D, 0x14, 0x1D )    # INC B, DEC C, INC D, DEC E
+    p.emit( 0x07 )                      # RLCA
+    p.emit( 0x1F )                      # RRA
+    p.emit( 0xCB, 0x37 )                # SWAP A
+    p.emit( 0x67 )                      # LD H, A
+    p.emit( 0x68 )                      # LD L, B
+    p.emit( 0x19 )                      # ADD HL, DE
+    p.emit( 0x23 )                      # INC HL
+    p.emit( 0x1B )                      # DEC DE
+    p.jp( 0xC3, 'loop' )                # JP loop
+    return p
+
+'''
+Copies tile data from ROM into VRAM byte by byte, the way games upload
+graphics, and then fills the tile map.
+'''
+def vramWorkload( rom ):
+    # Tile data to copy, in the second half of the cartridge.
+    for i in range( 0x1000 ):
+        rom[0x4000 + i] = (i * 37 + (i >> 4)) & 0xFF
+
+    p = Program( 0x150 )
+    startUp( p )
+    lcdOn( p )
+    p.label( 'frame' )
+    waitForVBlank( p, 'wait' )
+    p.emit( 0x21, 0x00, 0x80 )          # LD HL, 0x8000
+    p.emit( 0x11, 0x00, 0x40 )          # LD DE, 0x4000
+    p.emit( 0x01, 0x00, 0x10 )          # LD BC, 0x1000
+    p.label( 'copy' )
+    p.emit( 0x1A )                      # LD A, (DE)
+    p.emit( 0x22 )                      # LD (HL+), A
+    p.emit( 0x13 )                      # INC DE
+    p.emit( 0x0B )                      # DEC BC
+    p.emit( 0x78 )                      # LD A, B
+    p.emit( 0xB1 )                      # OR C
+    p.jr( 0x20, 'copy' )                # JR NZ, copy
+    p.emit( 0x21, 0x00, 0x98 )          # LD HL, 0x9800
+    p.emit( 0x0E, 0x00 )                # LD C, 0
+    p.label( 'map' )
+    p.emit( 0x79 )                      # LD A, C
+    p.emit( 0x22 )                      # LD (HL+), A
+    p.emit( 0x22 )                      # LD (HL+), A
+    p.emit( 0x22 )                      # LD (HL+), A
+    p.emit( 0x22 )                      # LD (HL+), A
+    p.emit( 0x0C )                      # INC C
+    p.jr( 0x20, 'map' )                 # JR NZ, map
+    p.jr( 0x18, 'frame' )               # JR frame
+    return p
+
+'''
+Switches MBC1 ROM banks as fast as it can, reading from each bank. Without a
+bank controller it only reads the first switchable bank.
+'''
+def bankWorkload( rom ):
+    # Every switchable bank holds its own number.
+    for bank in range( 1, len(rom) // ROM_BANK_SIZE ):
+        start = bank * ROM_BANK_SIZE
+        rom[start:start + ROM_BANK_SIZE] = bytearray( [bank] ) * ROM_BANK_SIZE
+
+    p = Program( 0x150 )
+    startUp( p )
+    lcdOn( p )
+    p.emit( 0x06, 0 )                   # LD B, 0
+    p.label( 'loop' )
+    p.emit( 0x04 )                      # INC B
+    p.emit( 0x78 )                      # LD A, B
+    p.emit( 0xE6, 0x07 )                # AND 0x07
+    p.jr( 0x20, 'select' )              # JR NZ, select
+    p.emit( 0x3C )                      # INC A
+    p.label( 'select' )
+    p.emit( 0x47 )                      # LD B, A
+    p.emit( 0xEA, 0x00, 0x20 )          # LD (0x2000), A
+    p.emit( 0xFA, 0x00, 0x40 )          # LD A, (0x4000)
+    p.emit( 0xEA, 0x00, 0xC0 )          # LD (0xC000), A
+    p.emit( 0xFA, 0xFF, 0x7F )          # LD A, (0x7FFF)
+    p.emit( 0xEA, 0x01, 0xC0 )          # LD (0xC001), A
+    p.jr( 0x18, 'loop' )                # JR loop
+    return p
+
+'''
+Sleeps in HALT until V-Blank every frame, like most games do when they are
+waiting for the next frame. Until HALT and interrupts are implemented it
+spins through the loop instead.
+'''
+def haltWorkload( rom ):
+    p = Program( 0x150 )
+    startUp( p )
+    lcdOn( p )
+    p.emit( 0x3E, 0x01 )                # LD A, V-Blank
+    p.emit( 0xE0, P_IE )                # LDH (IE), A
+    p.emit( 0xAF )                      # XOR A
+    p.emit( 0xE0, P_IF )                # LDH (IF), A
+    p.emit( 0xFB )                      # EI
+    p.label( 'loop' )
+    p.emit( 0x76 )                      # HALT
+    p.emit( 0x00 )                      # NOP
+    p.emit( 0xFA, 0x00, 0xC0 )          # LD A, (0xC000)
+    p.emit( 0xEA, 0x02, 0xC0 )          # LD (0xC002), A
+    p.jr( 0x18, 'loop' )                # JR loop
+
+    # V-Blank handler: count the frames.
+    handler = Program( 0x40 )
+    handler.emit( 0xF5 )                # PUSH AF
+    handler.emit( 0xE5 )                # PUSH HL
+    handler.emit( 0x21, 0x00, 0xC0 )    # LD HL, 0xC000
+    handler.emit( 0x34 )                # INC (HL)
+    handler.emit( 0xE1 )                # POP HL
+    handler.emit( 0xF1 )                # POP AF
+    handler.emit( 0xD9 )                # RETI
+    place( rom, handler )
+    return p
+
+'''
+Turns on every interrupt source at its fastest rate, and requests the serial
+and joypad interrupts by hand, so interrupts keep coming. Until the CPU takes
+interrupts it only runs the loop.
+'''
+def interruptWorkload( rom ):
+    # One handler per interrupt, each counting into its own byte of high RAM.
+    for i in range( 5 ):
+        counter = 0x80 + i
+        handler = Program( 0x40 + i * 8 )
+        handler.emit( 0xF5 )            # PUSH AF
+        handler.emit( 0xF0, counter )   # LDH A, (counter)
+        handler.emit( 0x3C )            # INC A
+        handler.emit( 0xE0, counter )   # LDH (counter), A
+        handler.emit( 0xF1 )            # POP AF
+        handler.emit( 0xD9 )            # RETI
+        place( rom, handler )
+
+    p = Program( 0x150 )
+    startUp( p )
+    p.emit( 0x3E, 0xFF, 0xE0, P_TMA )   # overflow on every timer tick
+    p.emit( 0x3E, 0x05, 0xE0, P_TAC )   # timer on, 262144Hz
+    p.emit( 0x3E, 0x78, 0xE0, P_STAT )  # STAT on LYC and every mode
+    lcdOn( p )
+    p.emit( 0x3E, 0x1F, 0xE0, P_IE )    # every interrupt
+    p.emit( 0xAF, 0xE0, P_IF )          # XOR A, LDH (IF), A
+    p.emit( 0xFB )                      # EI
+    p.label( 'loop' )
+    p.emit( 0x3E, 0x18, 0xE0, P_IF )    # request serial and joypad
+    p.emit( 0x80, 0xA9, 0x3C )          # ADD A, B; XOR C; INC A
+    p.jr( 0x18, 'loop' )                # JR loop
+    return p
+
+
+# name: ( function, MBC type, ROM size code, title )
+workloads = { 'alu':        ( aluWorkload, ROM_ONLY, 0x00, 'WORKLOAD ALU' ),
+              'vram':       ( vramWorkload, ROM_ONLY, 0x00, 'WORKLOAD VRAM' ),
+              'bank':       ( bankWorkload, MBC1, 0x02, 'WORKLOAD BANK' ),
+              'halt':       ( haltWorkload, ROM_ONLY, 0x00, 'WORKLOAD HALT' ),
+              'interrupt':  ( interruptWorkload, ROM_ONLY, 0x00, 'WORKLOAD IRQ' ) }
+
+
+'''
+Fills in the header, including both check sums.
+'''
+def writeHeader( rom, title, mbcType, romSize ):
+    rom[0x0100:0x0104] = bytearray( [0x00, 0xC3, 0x50, 0x01] )  # NOP, JP 0x150
+    titleBytes = bytearray( title.encode( 'ascii' ) )
+    rom[0x0134:0x0134 + len(titleBytes)] = titleBytes
+    rom[0x0147] = mbcType
+    rom[0x0148] = romSize
+    rom[0x0149] = 0x00
+    rom[0x014A] = 0x01                  # not Japanese
+
+    headerSum = 0
+    for addr in range( 0x0134, 0x014D ):
+        headerSum = (headerSum - rom[addr] - 1) & 0xFF
+    rom[0x014D] = headerSum
+
+    globalSum = (sum( rom ) - rom[0x014E] - rom[0x014F]) & 0xFFFF
+    rom[0x014E] = globalSum >> 8
+    rom[0x014F] = globalSum & 0xFF
+
+'''
+Builds a workload cartridge and writes it to <outDir>/workload-<name>.gb.
+
+returns the name of the file created
+'''
+def makeWorkload( name, outDir ):
+    function, mbcType, romSize, title = workloads[name]
+    rom = bytearray( romMap[romSize] )
+    place( rom, function( rom ) )
+    writeHeader( rom, title, mbcType, romSize )
+
+    fname = os.path.join( outDir, 'workload-{0}.gb'.format( name ) )
+    cart = open( fname, 'wb' )
+    cart.write( rom )
+    cart.close()
+    return fname
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser( description='Generates synthetic workload cartridges.' )
+    parser.add_argument( '-o', dest='outDir', default='.',
+                         help='directory to write the cartridges to' )
+    parser.add_argument( 'names', nargs='*', metavar='workload',
+                         help='workloads to generate, defaults to all of: ' +
+                              ', '.join( sorted( workloads ) ) )
+    args = parser.parse_args()
+
+    for name in args.names or sorted( workloads ):
+        if name not in workloads:
+            parser.error( 'unknown workload ' + name )
+        print( makeWorkload( name, args.outDir ) )
@@ -0,0 +1,89 @@
+#include <stdlib.h>
+#include <vector>
+
+#include "../../include/gtest/gtest.h"
+#include "../../../src/Common/DeltaCompression.h"
+
+/**
+ * Encodes and decodes a buffer, checking it comes back the same.
+ *
+ * @return Length of the encoding.
+ */
+static size_t roundTrip(const std::vector<uint8_t>& data, 
+                        const std::vector<uint8_t>* base)
+{
+    const uint8_t* basePtr = base ? &(*base)[0] : NULL;
+    std::vector<uint8_t> encoded(getMaxDeltaSize(data.size()));
+    size_t length = encodeDelta(&data[0], basePtr, data.size(), &encoded[0]);
+    EXPECT_LE(length, encoded.size());
+
+    std::vector<uint8_t> decoded(data.size());
+    EXPECT_TRUE(decodeDelta(&encoded[0], length, basePtr, &decoded[0], 
+                            decoded.size()));
+    EXPECT_EQ(data, decoded);
+    return length;
+}
+
+/**
+ * Runs should be encoded in a couple of bytes, and random data should not 
+ * grow by more than the worst case.
+ */
+TEST(DeltaCompressionTest, RunLengthTest)
+{
+    std::vector<uint8_t> zeros(10000, 0);
+    ASSERT_LT(roundTrip(zeros, NULL), 200u);
+
+    std::vector<uint8_t> random(10000);
+    srand(1);
+    for (size_t i = 0; i < random.size(); i++)
+    {
+        random[i] = (uint8_t)rand();
+    }
+    roundTrip(random, NULL);
+
+    // Short runs between literals.
+    std::vector<uint8_t> mixed;
+    for (int i = 0; i < 1000; i++)
+    {
+        mixed.insert(mixed.end(), i % 5, (uint8_t)i);
+        mixed.push_back((uint8_t)(i * 7));
+    }
+    roundTrip(mixed, NULL);
+}
+
+/**
+ * A buffer that only changed in a few places should encode into a few bytes
+ * against its base.
+ */
+TEST(DeltaCompressionTest, DeltaTest)
+{
+    std::vector<uint8_t> base(65536);
+    srand(2);
+    for (size_t i = 0; i < base.size(); i++)
+    {
+        base[i] = (uint8_t)rand();
+    }
+
+    std::vector<uint8_t> data(base);
+    ASSERT_LT(roundTrip(data, &base), 1200u);
+
+    data[0] ^= 1;
+    data[1000] = 0;
+    data[1001] = 0;
+    data[65535]++;
+    ASSERT_LT(roundTrip(data, &base), 1200u);
+}
+
+/**
+ * Encodings that don't decode to the right length should be refused.
+ */
+TEST(DeltaCompressionTest, BadEncodingTest)
+{
+    std::vector<uint8_t> data(100, 7);
+    std::vector<uint8_t> encoded(getMaxDeltaSize(data.size()));
+    size_t length = encodeDelta(&data[0], NULL, data.size(), &encoded[0]);
+
+    std::vector<uint8_t> decoded(data.size());
+    ASSERT_FALSE(decodeDelta(&encoded[0], length, NULL, &decoded[0], 99));
+    ASSERT_FALSE(decodeDelta(&encoded[0], length - 1, NULL, &decoded[0], 100));
+}
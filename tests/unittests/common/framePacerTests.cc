@@ -0,0 +1,131 @@
+#include "../../include/gtest/gtest.h"
+#include "../../../src/Common/FramePacer.h"
+
+// 70224 cycles at 4194304 Hz
+#define FRAME_NANOS 16742706ULL
+
+// How far the fake clock moves each time it is read.
+#define TICK_NANOS 1000
+
+/**
+ * A pacer on a clock that only moves when it is read, slept on or told to,
+ * so the tests do not depend on how busy the machine running them is.
+ */
+class FakeClockPacer : public FramePacer
+{
+public:
+    FakeClockPacer() : time(1000000000ULL), sleeps(0) {}
+
+    /**
+     * Moves the clock on, as if a frame took this long to emulate.
+     */
+    void advance(uint64_t nanos) { time += nanos; }
+
+    uint64_t time;
+    int sleeps;
+
+protected:
+    uint64_t currentTime()
+    {
+        time += TICK_NANOS;
+        return time;
+    }
+
+    void sleepUntil(uint64_t wake)
+    {
+        sleeps++;
+        if (wake > time)
+        {
+            time = wake;
+        }
+    }
+};
+
+/**
+ * Unthrottled frames should not wait at all.
+ */
+TEST(FramePacerTest, UnthrottledTest)
+{
+    FakeClockPacer pacer;
+    pacer.setSpeed(0);
+
+    uint64_t start = pacer.time;
+    for (int i = 0; i < 100; i++)
+    {
+        pacer.waitForFrame();
+    }
+    ASSERT_EQ(start, pacer.time);
+    ASSERT_EQ(0, pacer.sleeps);
+}
+
+/**
+ * Frames should take as long as a Game Boy frame divided by the speed. The 
+ * first frame starts the schedule, so it is not counted.
+ */
+TEST(FramePacerTest, SpeedTest)
+{
+    int speeds[] = { 1, 4 };
+    for (int i = 0; i < 2; i++)
+    {
+        FakeClockPacer pacer;
+        pacer.setSpeed(speeds[i]);
+        pacer.waitForFrame();
+
+        const int frames = 10;
+        uint64_t start = pacer.time;
+        for (int j = 0; j < frames; j++)
+        {
+            pacer.advance(FRAME_NANOS / 100);
+            pacer.waitForFrame();
+        }
+        uint64_t elapsed = pacer.time - start;
+        uint64_t expected = frames * FRAME_NANOS / speeds[i];
+        ASSERT_GE(elapsed, expected - TICK_NANOS);
+        ASSERT_LE(elapsed, expected + TICK_NANOS);
+        ASSERT_EQ(frames + 1, pacer.sleeps);
+        ASSERT_EQ(0u, pacer.getLateFrames());
+    }
+}
+
+/**
+ * Falling far behind should start the schedule again, rather than running 
+ * frames without waiting until it catches up.
+ */
+TEST(FramePacerTest, ResyncTest)
+{
+    FakeClockPacer pacer;
+    pacer.setSpeed(8);
+    pacer.waitForFrame();
+
+    // Stall for several frames.
+    pacer.advance(10 * FRAME_NANOS / 8);
+    pacer.waitForFrame();
+    ASSERT_EQ(1u, pacer.getLateFrames());
+    ASSERT_EQ(1u, pacer.getResyncs());
+    ASSERT_GT(pacer.getDrift(), 9 * FRAME_NANOS / 8);
+
+    // The next frame has to wait a whole frame again.
+    uint64_t start = pacer.time;
+    pacer.waitForFrame();
+    ASSERT_GE(pacer.time - start, FRAME_NANOS / 8 - 2 * TICK_NANOS);
+    ASSERT_EQ(1u, pacer.getLateFrames());
+}
+
+/**
+ * On the real clock, frames should never finish early. How late they finish
+ * depends on the machine, so that is not checked.
+ */
+TEST(FramePacerTest, MonotonicClockTest)
+{
+    FramePacer pacer;
+    pacer.setSpeed(4);
+    pacer.waitForFrame();
+
+    const int frames = 10;
+    uint64_t start = FramePacer::now();
+    for (int i = 0; i < frames; i++)
+    {
+        pacer.waitForFrame();
+    }
+    ASSERT_GE(FramePacer::now() - start, (frames - 1) * FRAME_NANOS / 4);
+}
@@ -0,0 +1,47 @@
+#include <string.h>
+#include <vector>
+
+#include "../../include/gtest/gtest.h"
+#include "../../../src/Common/Hash.h"
+
+/**
+ * The hash should be XXH64, so hashes can be checked with other tools.
+ */
+TEST(HashTest, KnownValuesTest)
+{
+    const char* fox = "The quick brown fox jumps over the lazy dog";
+    EXPECT_EQ(0xEF46DB3751D8E999ULL, hashBytes("", 0));
+    EXPECT_EQ(0xD24EC4F1A98C6E5BULL, hashBytes("a", 1));
+    EXPECT_EQ(0x44BC2CF5AD770999ULL, hashBytes("abc", 3));
+    EXPECT_EQ(0x0B242D361FDA71BCULL, hashBytes(fox, strlen(fox)));
+
+    uint8_t bytes[256];
+    for (int i = 0; i < 256; i++)
+    {
+        bytes[i] = (uint8_t)i;
+    }
+    EXPECT_EQ(0x1FACBE8406CD904BULL, hashBytes(bytes, sizeof(bytes)));
+    EXPECT_EQ(0xD5AFBA1336A3BE4BULL, hashBytes("", 0, 1));
+}
+
+/**
+ * Flipping any bit of a frame should change its hash, wherever the bit is
+ * and however the frame is aligned.
+ */
+TEST(HashTest, BitFlipTest)
+{
+    std::vector<uint8_t> frame(160 * 144 + 1, 0x55);
+    uint8_t* shades = &frame[1];
+    uint64_t hash = hashBytes(shades, 160 * 144);
+
+    for (int i = 0; i < 160 * 144; i += 997)
+    {
+        for (int bit = 0; bit < 8; bit++)
+        {
+            shades[i] ^= 1 << bit;
+            EXPECT_NE(hash, hashBytes(shades, 160 * 144));
+            shades[i] ^= 1 << bit;
+        }
+    }
+    EXPECT_EQ(hash, hashBytes(shades, 160 * 144));
+}
@@ -0,0 +1,135 @@
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+#include "../../include/gtest/gtest.h"
+#include "../../../src/Common/Metrics.h"
+#include "../../../src/Common/MetricsExporter.h"
+
+/**
+ * The totals should add up the counters of every thread, and each thread
+ * should have counters of its own.
+ */
+TEST(MetricsTest, ThreadTotalsTest)
+{
+    Metrics::Snapshot before;
+    Metrics::snapshot(&before);
+
+    Metrics::add(Metrics::INSTRUCTIONS, 5);
+    std::thread other([]() {
+        Metrics::add(Metrics::INSTRUCTIONS, 7);
+        Metrics::add(Metrics::MEMORY_READS + 4, 3);
+    });
+    other.join();
+
+    Metrics::Snapshot after;
+    Metrics::snapshot(&after);
+    ASSERT_EQ(12u, after.total[Metrics::INSTRUCTIONS] -
+                   before.total[Metrics::INSTRUCTIONS]);
+    ASSERT_EQ(3u, after.total[Metrics::MEMORY_READS + 4] -
+                  before.total[Metrics::MEMORY_READS + 4]);
+    ASSERT_LE(before.threads.size() + 1, after.threads.size());
+    ASSERT_STREQ("memory_reads.VRAM", Metrics::getName(Metrics::MEMORY_READS + 4));
+}
+
+/**
+ * Snapshots should be written as text and as JSON.
+ */
+TEST(MetricsTest, FormatTest)
+{
+    Metrics::add(Metrics::FRAMES_RENDERED, 1);
+    Metrics::Snapshot snapshot;
+    Metrics::snapshot(&snapshot);
+
+    std::ostringstream text;
+    Metrics::writeText(snapshot, text);
+    std::ostringstream expected;
+    expected << "frames_rendered " << snapshot.total[Metrics::FRAMES_RENDERED]
+             << "\n";
+    ASSERT_NE(std::string::npos, text.str().find(expected.str()));
+
+    std::ostringstream json;
+    Metrics::writeJson(snapshot, json);
+    ASSERT_EQ('{', json.str()[0]);
+    ASSERT_NE(std::string::npos, json.str().find("\"total\": {\"instructions\": "));
+    ASSERT_NE(std::string::npos, json.str().find("\"threads\": ["));
+}
+
+/**
+ * The exporter should write the file when it stops, and answer connections
+ * to its socket with a snapshot.
+ */
+TEST(MetricsTest, ExporterTest)
+{
+    char fileName[] = "/tmp/metricsTestXXXXXX";
+    int fd = mkstemp(fileName);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    std::string jsonName = std::string(fileName) + ".json";
+    std::string socketPath = std::string(fileName) + ".sock";
+
+    MetricsExporter exporter;
+    exporter.setFile(jsonName, 10000);
+    ASSERT_TRUE(exporter.listen(socketPath)) << exporter.getErrorMessage();
+    exporter.start();
+
+    int client = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socketPath.c_str());
+    ASSERT_EQ(0, connect(client, (struct sockaddr*)&addr, sizeof(addr)));
+    std::string answer;
+    char buffer[256];
+    ssize_t n;
+    while ((n = read(client, buffer, sizeof(buffer))) > 0)
+    {
+        answer.append(buffer, n);
+    }
+    close(client);
+    ASSERT_NE(std::string::npos, answer.find("\"vram_rejects\": "));
+
+    Metrics::add(Metrics::CYCLES, 1);
+    exporter.stop();
+    std::ifstream in(jsonName.c_str());
+    std::stringstream file;
+    file << in.rdbuf();
+    ASSERT_NE(std::string::npos, file.str().find("\"present_ns\": "));
+
+    remove(fileName);
+    remove(jsonName.c_str());
+}
+
+/**
+ * Listening should replace a socket left behind, but never a file that is
+ * not a socket.
+ */
+TEST(MetricsTest, SocketPathTest)
+{
+    char fileName[] = "/tmp/metricsTestXXXXXX";
+    int fd = mkstemp(fileName);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(1, write(fd, "x", 1));
+    close(fd);
+
+    MetricsExporter exporter;
+    ASSERT_FALSE(exporter.listen(fileName));
+    std::ifstream in(fileName);
+    ASSERT_EQ('x', in.get());
+    remove(fileName);
+
+    // A stale socket, as left by a run that crashed.
+    int stale = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, fileName);
+    ASSERT_EQ(0, bind(stale, (struct sockaddr*)&addr, sizeof(addr)));
+    close(stale);
+    ASSERT_TRUE(exporter.listen(fileName)) << exporter.getErrorMessage();
+}
@@ -0,0 +1,41 @@
+#include <sstream>
+
+#include "../../include/gtest/gtest.h"
+#include "../../../src/Common/PerfCounters.h"
+
+/**
+ * Only what was run between start() and stop() should be counted. Hosts
+ * without perf events, or where they are not allowed, should say why.
+ */
+TEST(PerfCountersTest, SliceTest)
+{
+    PerfCounters counters;
+    if (!counters.open())
+    {
+        EXPECT_FALSE(counters.getErrorMessage().empty());
+        return;
+    }
+    EXPECT_EQ(0u, counters.getSliceCount());
+
+    counters.start();
+    volatile uint64_t sum = 0;
+    for (int i = 0; i < 1000000; i++)
+    {
+        sum += i;
+    }
+    counters.stop();
+    EXPECT_EQ(1u, counters.getSliceCount());
+
+    if (counters.isAvailable(PerfCounters::TASK_CLOCK))
+    {
+        EXPECT_GT(counters.get(PerfCounters::TASK_CLOCK), 0u);
+    }
+    if (counters.isAvailable(PerfCounters::INSTRUCTIONS))
+    {
+        EXPECT_GT(counters.get(PerfCounters::INSTRUCTIONS), 1000000u);
+    }
+
+    std::ostringstream text;
+    counters.writeText(text, 1000, 0);
+    EXPECT_NE(std::string::npos, text.str().find("task_clock_ns"));
+}
@@ -0,0 +1,110 @@
+#include <thread>
+
+#include "../../include/gtest/gtest.h"
+#include "../../../src/Common/SpscQueue.h"
+#include "../../../src/Common/TripleBuffer.h"
+
+/**
+ * Items should come out of the queue in the order they went in, and the
+ * queue should refuse items when it is full.
+ */
+TEST(SpscQueueTest, OrderTest)
+{
+    SpscQueue<int, 4> queue;
+    int item;
+    ASSERT_FALSE(queue.pop(&item));
+    for (int i = 0; i < 4; i++)
+    {
+        ASSERT_TRUE(queue.push(i));
+    }
+    ASSERT_FALSE(queue.push(4));
+    for (int i = 0; i < 4; i++)
+    {
+        ASSERT_TRUE(queue.pop(&item));
+        ASSERT_EQ(i, item);
+    }
+    ASSERT_FALSE(queue.pop(&item));
+}
+
+/**
+ * Every item pushed on one thread should be popped on another, in order.
+ */
+TEST(SpscQueueTest, ThreadTest)
+{
+    static SpscQueue<int, 16> queue;
+    const int count = 100000;
+    std::thread producer([]() {
+        for (int i = 0; i < count; i++)
+        {
+            while (!queue.push(i))
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    int item;
+    for (int i = 0; i < count; i++)
+    {
+        while (!queue.pop(&item))
+        {
+            std::this_thread::yield();
+        }
+        ASSERT_EQ(i, item);
+    }
+    producer.join();
+}
+
+/**
+ * The reader should only see a new buffer once it has been published, and 
+ * only the most recent one.
+ */
+TEST(TripleBufferTest, PublishTest)
+{
+    TripleBuffer<int> buffer;
+    ASSERT_FALSE(buffer.update());
+
+    *buffer.getBackBuffer() = 1;
+    buffer.publish();
+    *buffer.getBackBuffer() = 2;
+    buffer.publish();
+    ASSERT_TRUE(buffer.update());
+    ASSERT_EQ(2, *buffer.getFrontBuffer());
+    ASSERT_FALSE(buffer.update());
+    ASSERT_EQ(2, *buffer.getFrontBuffer());
+}
+
+/**
+ * The reader should never see a buffer that is only partly written.
+ */
+TEST(TripleBufferTest, ThreadTest)
+{
+    struct Pair { int a, b; };
+    static TripleBuffer<Pair> buffer;
+    const int count = 100000;
+    std::thread writer([]() {
+        for (int i = 1; i <= count; i++)
+        {
+            buffer.getBackBuffer()->a = i;
+            buffer.getBackBuffer()->b = i;
+            buffer.publish();
+        }
+    });
+
+    int last = 0;
+    while (last != count)
+    {
+        if (buffer.update())
+        {
+            const Pair *pair = buffer.getFrontBuffer();
+            ASSERT_EQ(pair->a, pair->b);
+            ASSERT_GT(pair->a, last);
+            last = pair->a;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    writer.join();
+}
@@ -0,0 +1,72 @@
+#include <atomic>
+
+#include "../../include/gtest/gtest.h"
+#include "../../../src/Common/ThreadPool.h"
+
+/**
+ * Counts how many times it was run.
+ */
+class CountTask : public Task
+{
+public:
+    CountTask(std::atomic<int>* counter) { this->counter = counter; }
+    void run() { (*counter)++; }
+
+private:
+    std::atomic<int>* counter;
+};
+
+/**
+ * Submits more tasks from inside the pool.
+ */
+class SpawnTask : public Task
+{
+public:
+    SpawnTask(ThreadPool* pool, CountTask* child) { this->pool = pool; this->child = child; }
+    void run() { pool->submit(child); }
+
+private:
+    ThreadPool* pool;
+    CountTask* child;
+};
+
+/**
+ * Every task should run exactly once before wait() returns.
+ */
+TEST(ThreadPoolTest, RunAllTest)
+{
+    std::atomic<int> counter(0);
+    CountTask task(&counter);
+
+    ThreadPool pool(4);
+    ASSERT_EQ(4, pool.getThreadCount());
+    for (int i = 0; i < 1000; i++)
+    {
+        pool.submit(&task);
+    }
+    pool.wait();
+    ASSERT_EQ(1000, counter.load());
+
+    // The pool can be used again after waiting.
+    pool.submit(&task);
+    pool.wait();
+    ASSERT_EQ(1001, counter.load());
+}
+
+/**
+ * Tasks submitted by other tasks should also be waited for.
+ */
+TEST(ThreadPoolTest, NestedSubmitTest)
+{
+    std::atomic<int> counter(0);
+    CountTask child(&counter);
+
+    ThreadPool pool(3);
+    SpawnTask spawn(&pool, &child);
+    for (int i = 0; i < 100; i++)
+    {
+        pool.submit(&spawn);
+    }
+    pool.wait();
+    ASSERT_EQ(100, counter.load());
+}
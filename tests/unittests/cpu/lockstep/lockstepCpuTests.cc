@@ -0,0 +1,136 @@
+#include "../../../include/gtest/gtest.h"
+#include "../../../../src/Cpu/LockstepCpu.h"
+#include "../../testCartridge.h"
+
+#define SEED_ADDR 0x150
+#define LANES 8
+#define STEPS 20000
+
+/**
+ * A program that mixes lockstep and scalar instructions. Every lane runs an
+ * arithmetic loop on a seed of its own, then lanes with an odd seed go off
+ * into a different loop for good.
+ */
+static const data_t lockstepProgram[] =
+{
+    0x21, 0x00, 0xC0,   // LD HL, 0xC000
+    0xFA, 0x50, 0x01,   // LD A, (0x0150)
+    0x47,               // LD B, A
+    0x0E, 0x10,         // LD C, 0x10
+    0x80,               // loop: ADD A, B
+    0xCE, 0x07,         // ADC A, 0x07
+    0x22,               // LD (HL+), A
+    0xA8,               // XOR B
+    0x0D,               // DEC C
+    0x20, 0xF8,         // JR NZ, loop
+    0x78,               // LD A, B
+    0xE6, 0x01,         // AND 0x01
+    0x20, 0x05,         // JR NZ, odd
+    0x0E, 0x10,         // LD C, 0x10
+    0xC3, 0x09, 0x01,   // JP loop
+    0x04,               // odd: INC B
+    0x90,               // SUB B
+    0xFE, 0x80,         // CP 0x80
+    0x30, 0xFA,         // JR NC, odd
+    0xC3, 0x1B, 0x01    // JP odd
+};
+
+/**
+ * Tests the lockstep CPU against the scalar CPU.
+ */
+class LockstepCpuTest : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        for (int l = 0; l < LANES; l++)
+        {
+            // Only a quarter of the lanes have an odd seed.
+            uint8_t seed = l * 2 + (l % 4 == 3);
+            lockstepMemory[l] = createMemory(seed);
+            scalarMemory[l] = createMemory(seed);
+        }
+    }
+
+    void TearDown()
+    {
+        for (int l = 0; l < LANES; l++)
+        {
+            delete lockstepMemory[l];
+            delete scalarMemory[l];
+        }
+    }
+
+    static Memory* createMemory(uint8_t seed)
+    {
+        Memory* mem = createTestMemory(lockstepProgram, sizeof(lockstepProgram));
+        mem->cart[SEED_ADDR] = seed;
+        return mem;
+    }
+
+    NoBootRom noBootRom;
+    Memory* lockstepMemory[LANES];
+    Memory* scalarMemory[LANES];
+};
+
+/**
+ * Every lane should end up in exactly the same state as a scalar CPU running
+ * the same program.
+ */
+TEST_F(LockstepCpuTest, MatchesScalarTest)
+{
+    LockstepCpu<LANES> lockstep(lockstepMemory);
+    lockstep.init();
+    for (int i = 0; i < STEPS; i++)
+    {
+        lockstep.step();
+    }
+
+    for (int l = 0; l < LANES; l++)
+    {
+        Z80Cpu cpu(scalarMemory[l]);
+        cpu.init();
+        uint64_t cycles = 0;
+        for (int i = 0; i < STEPS; i++)
+        {
+            cycles += cpu.step();
+        }
+
+        Z80Registers expected = *cpu.GetRegisters();
+        Z80Registers actual = lockstep.getRegisters(l);
+        ASSERT_EQ(expected.AF.val, actual.AF.val);
+        ASSERT_EQ(expected.BC.val, actual.BC.val);
+        ASSERT_EQ(expected.DE.val, actual.DE.val);
+        ASSERT_EQ(expected.HL.val, actual.HL.val);
+        ASSERT_EQ(expected.PC.val, actual.PC.val);
+        ASSERT_EQ(expected.SP.val, actual.SP.val);
+        ASSERT_EQ(cycles, lockstep.getCycle(l));
+
+        for (int addr = 0xC000; addr < 0xE000; addr++)
+        {
+            ASSERT_EQ(scalarMemory[l]->read(addr), lockstepMemory[l]->read(addr));
+        }
+        ASSERT_EQ(scalarMemory[l]->read(0xFF05), lockstepMemory[l]->read(0xFF05));
+        ASSERT_EQ(scalarMemory[l]->read(0xFF0F), lockstepMemory[l]->read(0xFF0F));
+    }
+}
+
+/**
+ * Lanes that go off on their own should drop back to the scalar CPU, while
+ * the others keep running in lockstep.
+ */
+TEST_F(LockstepCpuTest, DivergenceTest)
+{
+    LockstepCpu<LANES> lockstep(lockstepMemory);
+    lockstep.init();
+    for (int i = 0; i < STEPS; i++)
+    {
+        lockstep.step();
+    }
+
+    for (int l = 0; l < LANES; l++)
+    {
+        ASSERT_EQ(l % 4 == 3, lockstep.isDetached(l));
+    }
+    ASSERT_GT(lockstep.getLockstepCount(), lockstep.getScalarCount());
+}
@@ -0,0 +1,113 @@
+#include <sstream>
+
+#include "../../../include/gtest/gtest.h"
+#include "../../../../src/Cpu/CpuProfiler.h"
+#include "../../../../src/Cpu/Z80Cpu.h"
+#include "../../testCartridge.h"
+
+#define LOOPS 100
+
+/**
+ * A loop that calls a subroutine, which calls another one.
+ */
+static const data_t profilerProgram[] =
+{
+    0x31, 0xFE, 0xFF,   // 0x0100: LD SP, 0xFFFE
+    0xCD, 0x10, 0x01,   // 0x0103: loop: CALL outer
+    0xCB, 0x37,         // 0x0106: SWAP A
+    0x18, 0xF9,         // 0x0108: JR loop
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x3C,               // 0x0110: outer: INC A
+    0xCD, 0x20, 0x01,   // 0x0111: CALL inner
+    0xC9,               // 0x0114: RET
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00,               // 0x0120: inner: NOP
+    0xC9                // 0x0121: RET
+};
+
+/**
+ * Tests profiling the CPU.
+ */
+class CpuProfilerTest : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        mem = createTestMemory(profilerProgram, sizeof(profilerProgram));
+        cpu = new Z80Cpu(mem);
+        cpu->init();
+        cpu->setProfiler(&profiler);
+
+        // LD SP, then 8 instructions per loop.
+        cycles = cpu->step();
+        for (int i = 0; i < LOOPS * 8; i++)
+        {
+            cycles += cpu->step();
+        }
+    }
+
+    void TearDown()
+    {
+        delete cpu;
+        delete mem;
+    }
+
+    NoBootRom noBootRom;
+    Memory* mem;
+    Z80Cpu* cpu;
+    CpuProfiler profiler;
+    uint64_t cycles;
+};
+
+/**
+ * Every instruction should be counted under its opcode and its address.
+ */
+TEST_F(CpuProfilerTest, CountTest)
+{
+    ASSERT_EQ(cycles, profiler.getTotalCycles());
+    ASSERT_EQ(2u * LOOPS, profiler.getOpcodeCount(0xCD));
+    ASSERT_EQ(2u * LOOPS, profiler.getOpcodeCount(0xC9));
+    ASSERT_EQ((uint64_t)LOOPS, profiler.getOpcodeCount(0x100 + 0x37));
+    ASSERT_EQ(0u, profiler.getOpcodeCount(0xCB));
+    ASSERT_EQ((uint64_t)LOOPS, profiler.getAddressCount(0x0110));
+    ASSERT_EQ(24u * LOOPS, profiler.getAddressCycles(0x0111));
+    ASSERT_EQ(0u, profiler.getAddressCount(0x0107));
+}
+
+/**
+ * Cycles should be split between the call stacks they were spent in.
+ */
+TEST_F(CpuProfilerTest, FoldedStackTest)
+{
+    std::ostringstream out;
+    profiler.writeFoldedStacks(out);
+
+    // root: LD SP, then CALL, SWAP and JR.
+    std::ostringstream expected;
+    expected << "root " << 12 + (24 + 8 + 12) * LOOPS << "\n"
+             << "root;00:0110 " << (4 + 24 + 16) * LOOPS << "\n"
+             << "root;00:0110;00:0120 " << (4 + 16) * LOOPS << "\n";
+    ASSERT_EQ(expected.str(), out.str());
+}
+
+/**
+ * The histogram should list the opcode that took the most cycles first.
+ */
+TEST_F(CpuProfilerTest, HistogramTest)
+{
+    std::ostringstream out;
+    profiler.writeHistogram(out, 2);
+    std::string histogram = out.str();
+
+    ASSERT_EQ(0u, histogram.find("Opcodes by cycles:\n"));
+    size_t first = histogram.find('\n', histogram.find('\n') + 1) + 1;
+    ASSERT_EQ("  CD", histogram.substr(first, 4));
+    ASSERT_NE(std::string::npos, histogram.find("  CB 37"));
+
+    // Only the two busiest addresses are listed.
+    size_t addresses = histogram.find("Addresses by cycles:\n");
+    ASSERT_NE(std::string::npos, addresses);
+    ASSERT_NE(std::string::npos, histogram.find("00:0103", addresses));
+    ASSERT_NE(std::string::npos, histogram.find("00:0111", addresses));
+    ASSERT_EQ(std::string::npos, histogram.find("00:0120", addresses));
+}
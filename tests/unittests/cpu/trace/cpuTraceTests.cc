@@ -0,0 +1,186 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../../../include/gtest/gtest.h"
+#include "../../../../src/Cpu/CpuTrace.h"
+#include "../../../../src/Cpu/Z80Cpu.h"
+#include "../../testCartridge.h"
+
+#define TRACE_SIZE 8
+
+/**
+ * Counts A up forever.
+ */
+static const data_t traceProgram[] =
+{
+    0x3E, 0x00,         // 0x0100: LD A, 0
+    0x3C,               // 0x0102: loop: INC A
+    0x18, 0xFD          // 0x0103: JR loop
+};
+
+/**
+ * Tests tracing the CPU.
+ */
+class CpuTraceTest : public ::testing::Test
+{
+protected:
+    CpuTraceTest() : trace(TRACE_SIZE) {}
+
+    void SetUp()
+    {
+        mem = createTestMemory(traceProgram, sizeof(traceProgram));
+        cpu = new Z80Cpu(mem);
+        cpu->init();
+        cpu->setTrace(&trace);
+    }
+
+    void TearDown()
+    {
+        delete cpu;
+        delete mem;
+    }
+
+    NoBootRom noBootRom;
+    Memory* mem;
+    Z80Cpu* cpu;
+    CpuTrace trace;
+};
+
+/**
+ * Only the last instructions should be kept, with the registers from before
+ * they ran.
+ */
+TEST_F(CpuTraceTest, RingTest)
+{
+    // LD, then 10 loops of INC and JR.
+    for (int i = 0; i < 21; i++)
+    {
+        cpu->step();
+    }
+
+    std::vector<TraceEntry> entries;
+    ASSERT_EQ(13u, trace.copy(&entries));
+    ASSERT_EQ((size_t)TRACE_SIZE, entries.size());
+    ASSERT_EQ(21u, trace.getCount());
+
+    // The oldest entry is the INC of the 7th loop.
+    ASSERT_EQ(0x0102, entries[0].pc);
+    ASSERT_EQ(0x3C, entries[0].bytes[0]);
+    ASSERT_EQ(6, entries[0].af >> 8);
+    ASSERT_EQ(0x0103, entries[1].pc);
+    ASSERT_EQ(0xFD, entries[1].bytes[1]);
+    ASSERT_EQ(entries[0].cycle + 4, entries[1].cycle);
+}
+
+/**
+ * A saved trace should load back the same.
+ */
+TEST_F(CpuTraceTest, SaveLoadTest)
+{
+    for (int i = 0; i < 5; i++)
+    {
+        cpu->step();
+    }
+
+    char fileName[] = "/tmp/cpuTraceTestXXXXXX";
+    int fd = mkstemp(fileName);
+    ASSERT_GE(fd, 0);
+    ASSERT_TRUE(trace.write(fd));
+    close(fd);
+
+    std::vector<TraceEntry> loaded;
+    uint64_t first;
+    std::string error;
+    ASSERT_TRUE(CpuTrace::load(fileName, &loaded, &first, &error)) << error;
+    remove(fileName);
+
+    std::vector<TraceEntry> entries;
+    trace.copy(&entries);
+    ASSERT_EQ(0u, first);
+    ASSERT_EQ(entries.size(), loaded.size());
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        ASSERT_EQ(entries[i].cycle, loaded[i].cycle);
+        ASSERT_EQ(entries[i].pc, loaded[i].pc);
+        ASSERT_EQ(entries[i].af, loaded[i].af);
+        ASSERT_EQ(0, memcmp(entries[i].bytes, loaded[i].bytes, 3));
+    }
+}
+
+/**
+ * A requested save should be written by the CPU after its next instruction.
+ */
+TEST_F(CpuTraceTest, RequestSaveTest)
+{
+    char fileName[] = "/tmp/cpuTraceTestXXXXXX";
+    int fd = mkstemp(fileName);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    remove(fileName);
+
+    cpu->step();
+    trace.requestSave(fileName);
+    ASSERT_NE(0, access(fileName, F_OK));
+    cpu->step();
+    cpu->step();
+
+    std::vector<TraceEntry> loaded;
+    uint64_t first;
+    std::string error;
+    ASSERT_TRUE(CpuTrace::load(fileName, &loaded, &first, &error)) << error;
+    remove(fileName);
+
+    // Saved once, after the second instruction.
+    ASSERT_EQ(0u, first);
+    ASSERT_EQ(2u, loaded.size());
+    ASSERT_EQ(0x0102, loaded[1].pc);
+}
+
+/**
+ * Counts the reads of one address, passing them on.
+ */
+class ReadCounter : public MemoryInterface
+{
+public:
+    ReadCounter(MemoryInterface* target, addr_t addr)
+        : target(target), addr(addr), reads(0) {}
+
+    data_t read(addr_t addr)
+    {
+        if (addr == this->addr)
+            reads++;
+        return target->read(addr);
+    }
+
+    void write(addr_t addr, data_t val) { target->write(addr, val); }
+    data_t peek(addr_t addr) { return target->peek(addr); }
+
+    MemoryInterface* target;
+    addr_t addr;
+    int reads;
+};
+
+/**
+ * Tracing should not read the bytes after an instruction, which the program
+ * never reads itself.
+ */
+TEST_F(CpuTraceTest, UnreadBytesTest)
+{
+    ReadCounter counter(mem->getReadListener(Memory::RomBank0_1), 0x0105);
+    mem->registerReadListener(Memory::RomBank0_1, &counter);
+    for (int i = 0; i < 21; i++)
+    {
+        cpu->step();
+    }
+    mem->registerReadListener(Memory::RomBank0_1, counter.target);
+
+    ASSERT_EQ(0, counter.reads);
+    std::vector<TraceEntry> entries;
+    trace.copy(&entries);
+    ASSERT_EQ(0x0103, entries[1].pc);
+    ASSERT_EQ(0x18, entries[1].bytes[0]);
+    ASSERT_EQ(0xFD, entries[1].bytes[1]);
+    ASSERT_EQ(0, entries[1].bytes[2]);
+}
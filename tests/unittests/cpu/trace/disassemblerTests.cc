@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "../../../include/gtest/gtest.h"
+#include "../../../../src/Cpu/SymbolTable.h"
+#include "../../../../src/Cpu/Z80Disassembler.h"
+
+/**
+ * Instructions should be disassembled with their operands.
+ */
+TEST(Z80DisassemblerTest, DisassembleTest)
+{
+    const data_t jr[] = { 0x20, 0xFE };
+    ASSERT_EQ(2, Z80Disassembler::getLength(0x20));
+    ASSERT_EQ("JR NZ, $0150", Z80Disassembler::disassemble(jr, 0x0150));
+
+    const data_t ld[] = { 0xEA, 0x34, 0x12 };
+    ASSERT_EQ(3, Z80Disassembler::getLength(0xEA));
+    ASSERT_EQ("LD ($1234), A", Z80Disassembler::disassemble(ld, 0));
+
+    const data_t ldh[] = { 0xE0, 0x40 };
+    ASSERT_EQ("LD (FF00+$40), A", Z80Disassembler::disassemble(ldh, 0));
+
+    const data_t sp[] = { 0xF8, 0xFE };
+    ASSERT_EQ(2, Z80Disassembler::getLength(0xF8));
+    ASSERT_EQ("LD HL, SP-2", Z80Disassembler::disassemble(sp, 0));
+
+    const data_t bit[] = { 0xCB, 0x7E };
+    ASSERT_EQ(2, Z80Disassembler::getLength(0xCB));
+    ASSERT_EQ("BIT 7, (HL)", Z80Disassembler::disassemble(bit, 0));
+
+    const data_t swap[] = { 0xCB, 0x37 };
+    ASSERT_EQ("SWAP A", Z80Disassembler::disassemble(swap, 0));
+
+    const data_t illegal[] = { 0xD3 };
+    ASSERT_EQ(1, Z80Disassembler::getLength(0xD3));
+    ASSERT_EQ("DB $D3", Z80Disassembler::disassemble(illegal, 0));
+}
+
+/**
+ * Every opcode should fit in a small buffer, and the buffer version should
+ * give the same text.
+ */
+TEST(Z80DisassemblerTest, BufferTest)
+{
+    for (int op = 0; op < 0x200; op++)
+    {
+        data_t bytes[] = { (data_t)op, 0x80, 0xFF };
+        if (op >= 0x100)
+        {
+            bytes[0] = 0xCB;
+            bytes[1] = (data_t)op;
+        }
+        char text[32];
+        size_t length = Z80Disassembler::disassemble(bytes, 0x4000, text, sizeof(text));
+        ASSERT_LT(length, sizeof(text));
+        ASSERT_EQ(Z80Disassembler::disassemble(bytes, 0x4000), std::string(text));
+    }
+    ASSERT_STREQ("JR NZ, d", Z80Disassembler::getMnemonic(0x20));
+    ASSERT_STREQ("SET 7, A", Z80Disassembler::getMnemonic(0x1FF));
+    ASSERT_EQ(NULL, Z80Disassembler::getMnemonic(0xD3));
+}
+
+/**
+ * Jump targets and memory operands with a symbol should be written as it,
+ * looking in the bank of the instruction.
+ */
+TEST(Z80DisassemblerTest, SymbolTest)
+{
+    SymbolTable symbols;
+    symbols.add(0, 0x0150, "Main");
+    symbols.add(2, 0x4000, "LoadLevel");
+    symbols.add(0, 0xC000, "wScore");
+    symbols.add(0, 0xFF80, "hFrame");
+
+    const data_t jr[] = { 0x20, 0xFE };
+    ASSERT_EQ("JR NZ, Main", Z80Disassembler::disassemble(jr, 0x0150, &symbols));
+
+    const data_t call[] = { 0xCD, 0x00, 0x40 };
+    ASSERT_EQ("CALL LoadLevel", Z80Disassembler::disassemble(call, 0x4100, &symbols, 2));
+    ASSERT_EQ("CALL $4000", Z80Disassembler::disassemble(call, 0x4100, &symbols, 3));
+
+    const data_t ld[] = { 0xEA, 0x00, 0xC0 };
+    ASSERT_EQ("LD (wScore), A", Z80Disassembler::disassemble(ld, 0, &symbols));
+
+    // Only addresses are looked up, not values.
+    const data_t value[] = { 0x21, 0x00, 0xC0 };
+    ASSERT_EQ("LD HL, $C000", Z80Disassembler::disassemble(value, 0, &symbols));
+
+    const data_t ldh[] = { 0xF0, 0x80 };
+    ASSERT_EQ("LD A, (hFrame)", Z80Disassembler::disassemble(ldh, 0, &symbols));
+}
+
+/**
+ * RGBDS symbol files should be loaded, and addresses formatted as the
+ * symbol before them.
+ */
+TEST(SymbolTableTest, LoadTest)
+{
+    char fileName[] = "/tmp/symbolTableTestXXXXXX";
+    int fd = mkstemp(fileName);
+    ASSERT_NE(-1, fd);
+    const char text[] = "; File generated by rgblink\n"
+                        "00:0150 Main\n"
+                        "00:0158 Main.loop\n"
+                        "01:4000 LoadLevel ; a comment\n"
+                        "02:4000 DrawMap\n"
+                        "00:c000 wScore\n"
+                        "\n";
+    ASSERT_EQ((ssize_t)sizeof(text) - 1, write(fd, text, sizeof(text) - 1));
+    close(fd);
+
+    SymbolTable symbols;
+    bool loaded = symbols.load(fileName);
+    remove(fileName);
+    ASSERT_TRUE(loaded) << symbols.getErrorMessage();
+    ASSERT_EQ(5u, symbols.size());
+
+    ASSERT_STREQ("Main.loop", symbols.getName(0x0158));
+    ASSERT_STREQ("LoadLevel", symbols.getName(0x4000));
+    ASSERT_STREQ("DrawMap", symbols.getName(0x4000, 2));
+    ASSERT_EQ(NULL, symbols.getName(0x4000, 3));
+
+    ASSERT_EQ("Main", symbols.format(0x0150));
+    ASSERT_EQ("Main+$4", symbols.format(0x0154));
+    ASSERT_EQ("DrawMap+$10", symbols.format(0x4010, 2));
+    ASSERT_EQ("wScore+$1F", symbols.format(0xC01F));
+    // Symbols in other banks, or in ROM for RAM, do not count.
+    ASSERT_EQ("03:4010", symbols.format(0x4010, 3));
+    ASSERT_EQ("00:8000", symbols.format(0x8000));
+    ASSERT_EQ("00:0100", symbols.format(0x0100));
+    // Nor do symbols in another part of RAM, or too far away.
+    ASSERT_EQ("00:FF40", symbols.format(0xFF40));
+    ASSERT_EQ("00:D000", symbols.format(0xD000));
+    ASSERT_EQ("00:2000", symbols.format(0x2000));
+
+    SymbolTable broken;
+    ASSERT_FALSE(broken.load("/nonexistent.sym"));
+}
@@ -0,0 +1,47 @@
+#include <stdio.h>
+
+#include "../../include/gtest/gtest.h"
+#include "../../../src/Input/InputLog.h"
+#include "../../../src/Memory/Customizers/IOMemory.h"
+
+/**
+ * Only changes of buttons should be recorded, and replaying should give
+ * back the buttons held on any cycle.
+ */
+TEST(InputLogTest, RecordTest)
+{
+    InputLog log;
+    log.record(0, 0);
+    log.record(70224, JOYPAD_START);
+    log.record(140448, JOYPAD_START);
+    log.record(210672, 0);
+    ASSERT_EQ(2u, log.getSize());
+
+    ASSERT_EQ(0, log.getButtons(0));
+    ASSERT_EQ(0, log.getButtons(70223));
+    ASSERT_EQ(JOYPAD_START, log.getButtons(70224));
+    ASSERT_EQ(JOYPAD_START, log.getButtons(210671));
+    ASSERT_EQ(0, log.getButtons(210672));
+    ASSERT_EQ(JOYPAD_START, log.getButtons(100000));
+}
+
+/**
+ * A saved log should load back the same.
+ */
+TEST(InputLogTest, SaveLoadTest)
+{
+    const char* fileName = "inputLogTest.txt";
+    InputLog log;
+    log.record(1234567890123ULL, JOYPAD_A | JOYPAD_RIGHT);
+    log.record(1234567900000ULL, JOYPAD_SELECT);
+    ASSERT_TRUE(log.save(fileName));
+
+    InputLog loaded;
+    ASSERT_TRUE(loaded.load(fileName));
+    remove(fileName);
+
+    ASSERT_EQ(2u, loaded.getSize());
+    ASSERT_EQ(0, loaded.getButtons(1234567890122ULL));
+    ASSERT_EQ(JOYPAD_A | JOYPAD_RIGHT, loaded.getButtons(1234567890123ULL));
+    ASSERT_EQ(JOYPAD_SELECT, loaded.getButtons(1234567900000ULL));
+}
@@ -0,0 +1,124 @@
+#include <stdio.h>
+
+#include "../../include/gtest/gtest.h"
+#include "../../../src/Input/InputScript.h"
+#include "../../../src/Memory/Customizers/IOMemory.h"
+
+#define JOYP_ADDR 0xFF00
+#define IF_ADDR 0xFF0F
+
+/**
+ * Reading JOYP should only show the buttons in the selected row, with a 
+ * pressed button reading as 0.
+ */
+TEST(JoypadTest, RowSelectTest)
+{
+    IOMemory io;
+    io.setButtons(JOYPAD_RIGHT | JOYPAD_START);
+
+    // No rows selected.
+    io.write(JOYP_ADDR, 0x30);
+    ASSERT_EQ(0xFF, io.read(JOYP_ADDR));
+
+    // Directions.
+    io.write(JOYP_ADDR, 0x20);
+    ASSERT_EQ(0xEE, io.read(JOYP_ADDR));
+
+    // Buttons.
+    io.write(JOYP_ADDR, 0x10);
+    ASSERT_EQ(0xD7, io.read(JOYP_ADDR));
+
+    // Both rows.
+    io.write(JOYP_ADDR, 0x00);
+    ASSERT_EQ(0xC6, io.read(JOYP_ADDR));
+}
+
+/**
+ * Pressing a button in a selected row should request the joypad interrupt,
+ * releasing it or pressing a button in another row should not.
+ */
+TEST(JoypadTest, InterruptTest)
+{
+    IOMemory io;
+    io.write(JOYP_ADDR, 0x20);
+
+    io.setButtons(JOYPAD_A);
+    ASSERT_EQ(0x00, io.IFLAGS & 0x10);
+
+    io.setButtons(JOYPAD_A | JOYPAD_DOWN);
+    ASSERT_EQ(0x10, io.IFLAGS & 0x10);
+
+    io.IFLAGS = 0;
+    io.setButtons(0);
+    ASSERT_EQ(0x00, io.IFLAGS & 0x10);
+}
+
+/**
+ * Selecting a row with a button held should request the joypad interrupt,
+ * as the line goes low then. Deselecting it should not.
+ */
+TEST(JoypadTest, RowSelectInterruptTest)
+{
+    IOMemory io;
+    io.write(JOYP_ADDR, 0x30);
+    io.setButtons(JOYPAD_START);
+    ASSERT_EQ(0x00, io.IFLAGS & 0x10);
+
+    // Directions: no button held there.
+    io.write(JOYP_ADDR, 0x20);
+    ASSERT_EQ(0x00, io.IFLAGS & 0x10);
+
+    io.write(JOYP_ADDR, 0x10);
+    ASSERT_EQ(0x10, io.IFLAGS & 0x10);
+
+    io.IFLAGS = 0;
+    io.write(JOYP_ADDR, 0x30);
+    ASSERT_EQ(0x00, io.IFLAGS & 0x10);
+}
+
+/**
+ * A script should hold its buttons down from the frame they start on until
+ * the next line.
+ */
+TEST(InputScriptTest, LoadTest)
+{
+    const char* fileName = "inputScriptTest.txt";
+    FILE* file = fopen(fileName, "w");
+    ASSERT_TRUE(file != NULL);
+    fprintf(file, "# frame buttons\n"
+                  "10 START\n"
+                  "\n"
+                  "12 -      # release\n"
+                  "20 RIGHT A\n");
+    fclose(file);
+
+    InputScript script;
+    ASSERT_TRUE(script.load(fileName));
+    remove(fileName);
+
+    ASSERT_EQ(0, script.getButtons(0));
+    ASSERT_EQ(JOYPAD_START, script.getButtons(10));
+    ASSERT_EQ(JOYPAD_START, script.getButtons(11));
+    ASSERT_EQ(0, script.getButtons(12));
+    ASSERT_EQ(JOYPAD_RIGHT | JOYPAD_A, script.getButtons(1000));
+
+    // Going back should still work.
+    ASSERT_EQ(JOYPAD_START, script.getButtons(10));
+}
+
+/**
+ * Unknown buttons should fail to load.
+ */
+TEST(InputScriptTest, BadButtonTest)
+{
+    const char* fileName = "inputScriptBadTest.txt";
+    FILE* file = fopen(fileName, "w");
+    ASSERT_TRUE(file != NULL);
+    fprintf(file, "0 TURBO\n");
+    fclose(file);
+
+    InputScript script;
+    ASSERT_FALSE(script.load(fileName));
+    ASSERT_FALSE(script.getErrorMessage().empty());
+    remove(fileName);
+}
@@ -0,0 +1,43 @@
+#include "../../include/gtest/gtest.h"
+#include "../../../src/Lcd/LcdComponent.h"
+
+/**
+ * Converting shades to pixels should match the color of every shade, for
+ * any number of scanlines.
+ */
+TEST(LcdFrameTest, ConvertFrameTest)
+{
+    uint8_t frame[160 * 144];
+    uint32_t pixels[160 * 144];
+    for (int i = 0; i < 160 * 144; i++)
+    {
+        frame[i] = (i * 7 + i / 160) & 0x3;
+        pixels[i] = 0x12345678;
+    }
+
+    LcdComponent::convertFrame(frame, pixels, 3, 5);
+    for (int i = 0; i < 160 * 144; i++)
+    {
+        int line = i / 160;
+        if (line >= 3 && line < 8)
+        {
+            ASSERT_EQ(LcdComponent::getColor(frame[i]).getColor(), pixels[i]);
+        }
+        else
+        {
+            ASSERT_EQ(0x12345678u, pixels[i]);
+        }
+    }
+}
+
+/**
+ * Pixels should be stored one shade per byte.
+ */
+TEST(LcdFrameTest, SetPixelTest)
+{
+    uint8_t frame[160 * 144];
+    memset(frame, 0, sizeof(frame));
+    LcdComponent::setPixel(frame, 10, 20, 3);
+    ASSERT_EQ(3, frame[20 * 160 + 10]);
+    ASSERT_EQ(3, LcdComponent::getPixel(frame, 10, 20));
+}
@@ -0,0 +1,275 @@
+#include "../../include/gtest/gtest.h"
+#include "../../../src/Lcd/Lcd.h"
+#include "../testCartridge.h"
+
+#define LCD_ENABLED 0x80
+
+#define LINE_CYCLES 456
+#define FRAME_CYCLES 70224
+
+/**
+ * Tests the mode timings of the LCD.
+ */
+class LcdTimingTest : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        // A blank cartridge is enough for the LCD.
+        mem = createTestMemory();
+        ioPorts = mem->getIOMemory();
+        ioPorts->LCDC = LCD_ENABLED;
+
+        lcd = new Lcd(mem);
+        lcd->init(pixels);
+
+        cycle = 0;
+        lcdCycle = 0;
+    }
+
+    void TearDown()
+    {
+        delete lcd;
+        delete mem;
+    }
+
+    /**
+     * Steps the LCD the way the window loop does, only when the LCD has
+     * reached its next event.
+     *
+     * @param cycles Number of cycles to run for.
+     * @param stepSize Number of cycles per "instruction".
+     * @return Number of times the LCD was stepped.
+     */
+    int run(int cycles, int stepSize)
+    {
+        int steps = 0;
+        for (int i = 0; i < cycles; i += stepSize)
+        {
+            cycle += stepSize;
+            if (cycle >= lcd->getNextEventCycle())
+            {
+                lcd->step((int)(cycle - lcdCycle));
+                lcdCycle = cycle;
+                steps++;
+            }
+        }
+        return steps;
+    }
+
+    int getMode()
+    {
+        return ioPorts->STAT & 0x3;
+    }
+
+    Memory* mem;
+    IOMemory* ioPorts;
+    Lcd* lcd;
+    uint32_t pixels[160 * 144];
+    uint64_t cycle;
+    uint64_t lcdCycle;
+};
+
+/**
+ * The LCD should go through OAM search, transfer and H-Blank on every visible
+ * line.
+ */
+TEST_F(LcdTimingTest, ScanLineModesTest)
+{
+    // The LCD starts in H-Blank.
+    run(204, 4);
+    ASSERT_EQ(Lcd::SearchOAM, getMode());
+    run(80, 4);
+    ASSERT_EQ(Lcd::Transfer, getMode());
+    ASSERT_EQ(0, ioPorts->LY);
+    run(172, 4);
+    ASSERT_EQ(Lcd::HBlank, getMode());
+    ASSERT_EQ(1, ioPorts->LY);
+}
+
+/**
+ * The next event should always be the end of the current mode.
+ */
+TEST_F(LcdTimingTest, NextEventTest)
+{
+    lcd->step(0);
+    ASSERT_EQ(204u, lcd->getNextEventCycle());
+    lcd->step(210);
+    ASSERT_EQ(204u + 80u, lcd->getNextEventCycle());
+    lcd->step(74);
+    ASSERT_EQ(204u + 80u + 172u, lcd->getNextEventCycle());
+}
+
+/**
+ * Stepping over several modes at once should give the same result as 
+ * stepping through every one of them.
+ */
+TEST_F(LcdTimingTest, LargeStepTest)
+{
+    lcd->step(204 + LINE_CYCLES * 10 + 100);
+    ASSERT_EQ(10, ioPorts->LY);
+    ASSERT_EQ(Lcd::Transfer, getMode());
+    ASSERT_EQ(204u + LINE_CYCLES * 10 + 80 + 172, lcd->getNextEventCycle());
+}
+
+/**
+ * A frame should take 70224 cycles, and only a handful of steps per line
+ * are required.
+ */
+TEST_F(LcdTimingTest, FrameTest)
+{
+    // Line up with the start of the first frame.
+    run(204, 4);
+    ASSERT_FALSE(lcd->isDirty());
+
+    int steps = run(FRAME_CYCLES, 4);
+    ASSERT_TRUE(lcd->isDirty());
+    ASSERT_EQ(0, ioPorts->LY);
+    ASSERT_EQ(Lcd::SearchOAM, getMode());
+    ASSERT_LE(steps, 154 * 4);
+
+    // V-Blank starts after the 144 visible lines.
+    lcd->clean();
+    run(144 * LINE_CYCLES, 4);
+    ASSERT_TRUE(lcd->isDirty());
+    ASSERT_EQ(144, ioPorts->LY);
+    ASSERT_EQ(Lcd::VBlank, getMode());
+}
+
+/**
+ * While the LCD is off it should only be stepped once a frame, and present a
+ * blank frame each time.
+ */
+TEST_F(LcdTimingTest, LcdOffTest)
+{
+    run(204 + LINE_CYCLES * 3, 4);
+    mem->write(0xFF40, 0);
+    run(4, 4);
+    ASSERT_EQ(0, ioPorts->LY);
+    ASSERT_EQ(Lcd::HBlank, getMode());
+    ASSERT_EQ(LcdComponent::getColor(0).getColor(), pixels[0]);
+    lcd->clean();
+
+    int steps = run(FRAME_CYCLES * 3, 4);
+    ASSERT_EQ(3, steps);
+    ASSERT_TRUE(lcd->isDirty());
+    ASSERT_EQ(0, ioPorts->LY);
+}
+
+/**
+ * Switching the LCD back on should restart it from the first scanline 
+ * straight away.
+ */
+TEST_F(LcdTimingTest, LcdOnTest)
+{
+    mem->write(0xFF40, 0);
+    run(FRAME_CYCLES / 2, 4);
+    mem->write(0xFF40, LCD_ENABLED);
+    run(4, 4);
+    ASSERT_EQ(0, ioPorts->LY);
+    ASSERT_EQ(Lcd::SearchOAM, getMode());
+
+    run(LINE_CYCLES * 2, 4);
+    ASSERT_EQ(2, ioPorts->LY);
+    ASSERT_EQ(Lcd::SearchOAM, getMode());
+}
+
+/**
+ * Skipped frames should keep the same timings, but should not mark the LCD
+ * dirty.
+ */
+TEST_F(LcdTimingTest, FrameSkipTest)
+{
+    // The setting takes effect from the next frame.
+    lcd->setFrameSkip(3);
+    run(204 + FRAME_CYCLES, 4);
+    lcd->clean();
+
+    int frames = 0;
+    for (int i = 0; i < 6; i++)
+    {
+        run(FRAME_CYCLES, 4);
+        ASSERT_EQ(0, ioPorts->LY);
+        if (lcd->isDirty())
+        {
+            frames++;
+            lcd->clean();
+        }
+    }
+    ASSERT_EQ(2, frames);
+
+    // Only render requested frames.
+    lcd->setFrameSkip(0);
+    run(FRAME_CYCLES, 4);
+    lcd->clean();
+    run(FRAME_CYCLES, 4);
+    ASSERT_FALSE(lcd->isDirty());
+    lcd->requestFrame();
+    run(FRAME_CYCLES, 4);
+    ASSERT_FALSE(lcd->isDirty());
+    run(FRAME_CYCLES, 4);
+    ASSERT_TRUE(lcd->isDirty());
+}
+
+/**
+ * Only the scanlines that changed since the last frame should be dirty.
+ */
+TEST_F(LcdTimingTest, DirtyLineTest)
+{
+    // Make the tile used by the first row of tiles dark, the rest of the 
+    // background uses a blank tile.
+    ioPorts->BGP = 0xE4;
+    ioPorts->LCDC |= 0x10;
+    mem->write(0x9800, 1);
+    for (int i = 0; i < 16; i++)
+    {
+        mem->write(0x8010 + i, 0xFF);
+    }
+
+    run(204 + FRAME_CYCLES, 4);
+    ASSERT_TRUE(lcd->isDirty());
+    ASSERT_EQ(8, lcd->getDirtyLineCount());
+    ASSERT_TRUE(lcd->isLineDirty(0));
+    ASSERT_TRUE(lcd->isLineDirty(7));
+    ASSERT_FALSE(lcd->isLineDirty(8));
+    ASSERT_EQ(LcdComponent::getColor(3).getColor(), pixels[0]);
+    ASSERT_EQ(LcdComponent::getColor(0).getColor(), pixels[8 * 160]);
+
+    // Nothing changed in the next frame.
+    lcd->clean();
+    run(FRAME_CYCLES, 4);
+    ASSERT_TRUE(lcd->isDirty());
+    ASSERT_EQ(0, lcd->getDirtyLineCount());
+}
+
+/**
+ * States with a mode that does not exist, or cycles outside of their mode,
+ * should be refused rather than hang or read past the mode lengths.
+ */
+TEST_F(LcdTimingTest, CorruptStateTest)
+{
+    run(1000, 4);
+    StateWriter writer;
+    lcd->saveState(&writer);
+    std::vector<uint8_t> state(writer.getData(), writer.getData() + writer.getSize());
+
+    // "LCD ", the chunk size, then enabled, mode and lcdCycles.
+    size_t chunk = 8;
+    ASSERT_EQ(0, memcmp(&state[chunk], "LCD ", 4));
+    size_t modeOffset = chunk + 9;
+    size_t cyclesOffset = chunk + 10;
+
+    std::vector<uint8_t> badMode = state;
+    badMode[modeOffset] = 7;
+    StateReader modeReader(&badMode[0], badMode.size());
+    ASSERT_FALSE(lcd->loadState(&modeReader));
+
+    std::vector<uint8_t> badCycles = state;
+    int cycles = -1;
+    memcpy(&badCycles[cyclesOffset], &cycles, sizeof(cycles));
+    StateReader cyclesReader(&badCycles[0], badCycles.size());
+    ASSERT_FALSE(lcd->loadState(&cyclesReader));
+
+    StateReader reader(&state[0], state.size());
+    ASSERT_TRUE(lcd->loadState(&reader));
+}
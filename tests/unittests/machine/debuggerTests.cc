@@ -0,0 +1,128 @@
+#include "../../include/gtest/gtest.h"
+#include "../../../src/Machine/Debugger.h"
+#include "testMachine.h"
+
+/**
+ * Tests stopping a machine with breakpoints and watchpoints.
+ */
+class DebuggerTest : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        machine = createTestMachine();
+        debugger = new Debugger(machine->getMemory());
+    }
+
+    void TearDown()
+    {
+        delete debugger;
+        delete machine;
+    }
+
+    uint16_t getPC()
+    {
+        return machine->getCpu()->GetRegisters()->PC.val;
+    }
+
+    NoBootRom noBootRom;
+    GBMachine* machine;
+    Debugger* debugger;
+};
+
+/**
+ * A breakpoint should stop the machine before its instruction, and the
+ * instruction should run once the machine is resumed.
+ */
+TEST_F(DebuggerTest, BreakpointTest)
+{
+    // loop: INC A
+    debugger->addBreakpoint(0x0107);
+    ASSERT_FALSE(machine->runUntilWith(UINT64_MAX, *debugger));
+    ASSERT_EQ(Debugger::BREAKPOINT, debugger->getStopReason());
+    ASSERT_EQ(0x0107, getPC());
+    uint8_t a = machine->getCpu()->GetRegisters()->AF.hi;
+
+    // Running again without resuming stays put.
+    uint64_t cycle = machine->getCycle();
+    machine->runUntilWith(UINT64_MAX, *debugger);
+    ASSERT_EQ(cycle, machine->getCycle());
+
+    // Once around the loop.
+    debugger->resume();
+    machine->runUntilWith(UINT64_MAX, *debugger);
+    ASSERT_EQ(Debugger::BREAKPOINT, debugger->getStopReason());
+    ASSERT_EQ(0x0107, getPC());
+    ASSERT_EQ((uint8_t)(a + 1), machine->getCpu()->GetRegisters()->AF.hi);
+
+    // Single steps run the instruction at the breakpoint.
+    debugger->step();
+    ASSERT_EQ(4, machine->stepWith(*debugger));
+    ASSERT_EQ(Debugger::STEPPED, debugger->getStopReason());
+    ASSERT_EQ(0x0108, getPC());
+
+    debugger->removeBreakpoint(0x0107);
+    debugger->resume();
+    ASSERT_TRUE(machine->runUntilWith(UINT64_MAX, *debugger));
+}
+
+/**
+ * Watchpoints should stop the machine after the instruction that accessed
+ * their address, including I/O registers.
+ */
+TEST_F(DebuggerTest, WatchpointTest)
+{
+    Memory* memory = machine->getMemory();
+    MemoryInterface* ioPorts = memory->getReadListener(Memory::IOPorts);
+    MemoryInterface* workRam = memory->getReadListener(Memory::WRam0);
+
+    // LDH (0x40), A
+    debugger->addWatchpoint(0xFF40, Debugger::WATCH_WRITE);
+    machine->runUntilWith(UINT64_MAX, *debugger);
+    ASSERT_EQ(Debugger::WATCHPOINT, debugger->getStopReason());
+    ASSERT_EQ(0xFF40, debugger->getStopAddress());
+    ASSERT_EQ(Debugger::WATCH_WRITE, debugger->getStopAccess());
+    ASSERT_EQ(0x0104, getPC());
+    ASSERT_EQ(0x91, memory->read(0xFF40));
+
+    // LD (0xC000), A, but not reads of it.
+    debugger->addWatchpoint(0xC000, Debugger::WATCH_READ);
+    debugger->resume();
+    for (int i = 0; i < 100; i++)
+    {
+        machine->stepWith(*debugger);
+    }
+    ASSERT_FALSE(debugger->isStopped());
+    debugger->addWatchpoint(0xC000, Debugger::WATCH_WRITE);
+    machine->runUntilWith(UINT64_MAX, *debugger);
+    ASSERT_EQ(Debugger::WATCHPOINT, debugger->getStopReason());
+    ASSERT_EQ(0xC000, debugger->getStopAddress());
+    ASSERT_EQ(0x010C, getPC());
+
+    // Ranges without watchpoints get their listeners back.
+    ASSERT_NE(workRam, memory->getReadListener(Memory::WRam0));
+    debugger->removeWatchpoint(0xC000);
+    ASSERT_EQ(workRam, memory->getReadListener(Memory::WRam0));
+    ASSERT_NE(ioPorts, memory->getReadListener(Memory::IOPorts));
+    debugger->removeWatchpoint(0xFF40);
+    ASSERT_EQ(ioPorts, memory->getReadListener(Memory::IOPorts));
+}
+
+/**
+ * Save states should be the same with watchpoints as without.
+ */
+TEST_F(DebuggerTest, SaveStateTest)
+{
+    machine->runFrame();
+    std::vector<uint8_t> state = saveTestState(machine);
+    debugger->addWatchpoint(0xFF40, Debugger::WATCH_ACCESS);
+    debugger->addWatchpoint(0xC000, Debugger::WATCH_ACCESS);
+    ASSERT_EQ(state, saveTestState(machine));
+
+    // External RAM is also the write listener of the ROM, which must not
+    // make it two listeners.
+    debugger->addWatchpoint(0xA000, Debugger::WATCH_WRITE);
+    ASSERT_EQ(state, saveTestState(machine));
+    debugger->clear();
+    ASSERT_EQ(state, saveTestState(machine));
+}
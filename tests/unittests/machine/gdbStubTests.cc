@@ -0,0 +1,164 @@
+#include <fstream>
+#include <stdlib.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+#include "../../include/gtest/gtest.h"
+#include "../../../src/Machine/GdbStub.h"
+#include "testMachine.h"
+
+/**
+ * Tests debugging a machine over the GDB remote serial protocol, with the
+ * test playing GDB on the other end of a socket pair.
+ */
+class GdbStubTest : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        machine = createTestMachine();
+        stub = new GdbStub(machine);
+        machine->setRunner(stub);
+
+        int fds[2];
+        ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+        stub->setConnection(fds[0]);
+        gdbFd = fds[1];
+    }
+
+    void TearDown()
+    {
+        close(gdbFd);
+        delete stub;
+        delete machine;
+    }
+
+    /**
+     * Sends a packet as GDB would, with its checksum.
+     */
+    void send(const std::string& packet)
+    {
+        uint8_t sum = 0;
+        for (size_t i = 0; i < packet.size(); i++)
+        {
+            sum += (uint8_t)packet[i];
+        }
+        char checksum[3];
+        snprintf(checksum, sizeof(checksum), "%02x", sum);
+        std::string framed = "$" + packet + "#" + checksum;
+        ASSERT_EQ((ssize_t)framed.size(), write(gdbFd, framed.data(), framed.size()));
+    }
+
+    /**
+     * Reads the next reply, skipping acknowledgements.
+     */
+    std::string receive()
+    {
+        std::string reply;
+        char c;
+        while (read(gdbFd, &c, 1) == 1 && c != '$')
+        {
+        }
+        while (read(gdbFd, &c, 1) == 1 && c != '#')
+        {
+            reply += c;
+        }
+        char checksum[2];
+        EXPECT_EQ(2, read(gdbFd, checksum, 2));
+        return reply;
+    }
+
+    std::string request(const std::string& packet)
+    {
+        send(packet);
+        return receive();
+    }
+
+    NoBootRom noBootRom;
+    GBMachine* machine;
+    GdbStub* stub;
+    int gdbFd;
+};
+
+/**
+ * GDB should be able to read registers and memory, stop at breakpoints,
+ * step, and kill the machine.
+ */
+TEST_F(GdbStubTest, SessionTest)
+{
+    std::thread runner([this]()
+    {
+        while (machine->runUntil(UINT64_MAX))
+        {
+        }
+    });
+
+    // The machine waits for GDB before running.
+    ASSERT_EQ("S05", request("?"));
+    ASSERT_EQ("0001", request("p5"));
+    ASSERT_EQ("3e91e040", request("m100,4"));
+
+    // Reads longer than a packet are cut short, and GDB asks for the rest.
+    std::string memory = request("m0,10000");
+    ASSERT_EQ(2046u * 2, memory.size());
+    ASSERT_EQ("3e91e040", memory.substr(0x100 * 2, 8));
+
+    // loop: INC A
+    ASSERT_EQ("OK", request("Z0,107,1"));
+    ASSERT_EQ("S05", request("c"));
+    ASSERT_EQ("0701", request("p5"));
+    std::string registers = request("g");
+    ASSERT_EQ(13u * 4, registers.size());
+    ASSERT_EQ("0701", registers.substr(5 * 4, 4));
+
+    // "monitor disas 2" prints through a console output packet.
+    std::string disassembly = "00:0107  INC A\n00:0108  LDI (HL), A\n";
+    std::string hex;
+    for (size_t i = 0; i < disassembly.size(); i++)
+    {
+        char digits[3];
+        snprintf(digits, sizeof(digits), "%02x", (uint8_t)disassembly[i]);
+        hex += digits;
+    }
+    ASSERT_EQ("O" + hex, request("qRcmd,64697361732032"));
+    ASSERT_EQ("OK", receive());
+
+    // Stepping runs the instruction at the breakpoint.
+    ASSERT_EQ("S05", request("s"));
+    ASSERT_EQ("0801", request("p5"));
+
+    // LD (0xC000), A
+    ASSERT_EQ("OK", request("z0,107,1"));
+    ASSERT_EQ("OK", request("Z2,c000,1"));
+    ASSERT_EQ("T05watch:c000;", request("c"));
+    ASSERT_EQ("OK", request("Mc000,1:5a"));
+    ASSERT_EQ("5a", request("mc000,1"));
+    ASSERT_EQ("OK", request("z2,c000,1"));
+
+    // Unsupported packets get an empty reply.
+    ASSERT_EQ("", request("vMustReplyEmpty"));
+
+    send("k");
+    runner.join();
+    ASSERT_FALSE(machine->runUntil(UINT64_MAX));
+}
+
+/**
+ * Listening on a path should never delete a file that is not a socket.
+ */
+TEST_F(GdbStubTest, SocketPathTest)
+{
+    char fileName[] = "/tmp/gdbStubTestXXXXXX";
+    int fd = mkstemp(fileName);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(1, write(fd, "x", 1));
+    close(fd);
+
+    GdbStub listener(machine);
+    ASSERT_FALSE(listener.listen(fileName));
+    std::ifstream in(fileName);
+    ASSERT_EQ('x', in.get());
+    remove(fileName);
+}
@@ -0,0 +1,99 @@
+#include <stdexcept>
+#include <vector>
+
+#include "../../include/gtest/gtest.h"
+#include "../../../src/Machine/MachineFork.h"
+#include "testMachine.h"
+
+/**
+ * Holds a different button down in each child, runs a few frames and sends
+ * back the machine's state.
+ */
+class ButtonJob : public ForkJob
+{
+public:
+    void run(GBMachine* machine, int child, std::vector<uint8_t>* result)
+    {
+        machine->setButtons(child % 2 == 0 ? JOYPAD_A : JOYPAD_B);
+        for (int i = 0; i < 5; i++)
+        {
+            machine->runFrame();
+        }
+        *result = saveTestState(machine);
+    }
+};
+
+/**
+ * Fails in every child.
+ */
+class ThrowingJob : public ForkJob
+{
+public:
+    void run(GBMachine* machine, int child, std::vector<uint8_t>* result)
+    {
+        throw std::runtime_error("job failed");
+    }
+};
+
+/**
+ * Tests forking a machine.
+ */
+class MachineForkTest : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        machine = createTestMachine();
+    }
+
+    void TearDown()
+    {
+        delete machine;
+    }
+
+    NoBootRom noBootRom;
+    GBMachine* machine;
+};
+
+/**
+ * Each child should carry on from the forked state with its own input, 
+ * the same as if it had run in the parent, and the parent should not 
+ * change.
+ */
+TEST_F(MachineForkTest, ForkTest)
+{
+    machine->runFrame();
+    std::vector<uint8_t> forked = saveTestState(machine);
+
+    ButtonJob job;
+    MachineFork fork(machine);
+    ASSERT_TRUE(fork.run(4, &job));
+    ASSERT_EQ(forked, saveTestState(machine));
+
+    // Run the same job in the parent to see what the children should get.
+    std::vector<uint8_t> expected[2];
+    for (int i = 0; i < 2; i++)
+    {
+        job.run(machine, i, &expected[i]);
+        StateReader reader(&forked[0], forked.size());
+        ASSERT_TRUE(machine->loadState(&reader));
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        ASSERT_EQ(expected[i % 2], fork.getResult(i));
+    }
+}
+
+/**
+ * A job that throws should fail the fork, not carry on in the child as if it
+ * were the parent.
+ */
+TEST_F(MachineForkTest, ThrowTest)
+{
+    ThrowingJob job;
+    MachineFork fork(machine);
+    ASSERT_FALSE(fork.run(2, &job));
+    ASSERT_EQ("A child did not finish.", fork.getErrorMessage());
+    ASSERT_TRUE(fork.getResult(0).empty());
+}
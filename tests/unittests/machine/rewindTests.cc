@@ -0,0 +1,112 @@
+#include <vector>
+
+#include "../../include/gtest/gtest.h"
+#include "../../../src/Machine/RewindBuffer.h"
+#include "testMachine.h"
+
+/**
+ * Tests rewinding a machine.
+ */
+class RewindTest : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        machine = createTestMachine();
+    }
+
+    void TearDown()
+    {
+        delete machine;
+    }
+
+    NoBootRom noBootRom;
+    GBMachine* machine;
+};
+
+/**
+ * Rewinding should go back through exactly the states that were captured, 
+ * across keyframes.
+ */
+TEST_F(RewindTest, RewindTest)
+{
+    RewindBuffer rewind(4 * 1024 * 1024, 4);
+    std::vector<std::vector<uint8_t> > states;
+    for (int i = 0; i < 10; i++)
+    {
+        machine->runFrame();
+        rewind.capture(machine);
+        states.push_back(saveTestState(machine));
+    }
+    ASSERT_EQ(10u, rewind.getCount());
+
+    // Deltas should be much smaller than whole states.
+    ASSERT_LT(rewind.getUsedBytes(), states[0].size() * 5);
+
+    for (int i = 9; i >= 0; i--)
+    {
+        // Run on a bit, so there is something to rewind.
+        machine->runFrame();
+        ASSERT_TRUE(rewind.rewind(machine));
+        ASSERT_EQ(states[i], saveTestState(machine));
+    }
+    ASSERT_EQ(0u, rewind.getCount());
+    ASSERT_EQ(0u, rewind.getUsedBytes());
+    ASSERT_FALSE(rewind.rewind(machine));
+}
+
+/**
+ * Capturing after rewinding should carry on from the rewound state.
+ */
+TEST_F(RewindTest, CaptureAfterRewindTest)
+{
+    RewindBuffer rewind(4 * 1024 * 1024, 3);
+    for (int i = 0; i < 5; i++)
+    {
+        machine->runFrame();
+        rewind.capture(machine);
+    }
+    ASSERT_TRUE(rewind.rewind(machine));
+    ASSERT_TRUE(rewind.rewind(machine));
+    ASSERT_TRUE(rewind.rewind(machine));
+
+    std::vector<std::vector<uint8_t> > states;
+    for (int i = 0; i < 4; i++)
+    {
+        machine->runFrame();
+        rewind.capture(machine);
+        states.push_back(saveTestState(machine));
+    }
+    for (int i = 3; i >= 0; i--)
+    {
+        ASSERT_TRUE(rewind.rewind(machine));
+        ASSERT_EQ(states[i], saveTestState(machine));
+    }
+    ASSERT_EQ(2u, rewind.getCount());
+}
+
+/**
+ * The buffer should never use more than its budget, dropping the oldest
+ * states instead.
+ */
+TEST_F(RewindTest, BudgetTest)
+{
+    size_t budget = 64 * 1024;
+    RewindBuffer rewind(budget, 8);
+    std::vector<uint8_t> last;
+    for (int i = 0; i < 100; i++)
+    {
+        machine->runFrame();
+        rewind.capture(machine);
+        last = saveTestState(machine);
+        ASSERT_LE(rewind.getUsedBytes(), budget);
+    }
+    ASSERT_GT(rewind.getCount(), 0u);
+    ASSERT_LT(rewind.getCount(), 100u);
+
+    ASSERT_TRUE(rewind.rewind(machine));
+    ASSERT_EQ(last, saveTestState(machine));
+    while (rewind.rewind(machine))
+    {
+    }
+}
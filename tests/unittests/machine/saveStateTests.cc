@@ -0,0 +1,113 @@
+#include "../../include/gtest/gtest.h"
+#include "../../../src/Machine/GBMachine.h"
+#include "testMachine.h"
+
+/**
+ * Tests saving and loading the state of a machine.
+ */
+class SaveStateTest : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        machine = createTestMachine();
+    }
+
+    void TearDown()
+    {
+        delete machine;
+    }
+
+    NoBootRom noBootRom;
+    GBMachine* machine;
+};
+
+/**
+ * Loading a state and running from it should end up in exactly the same 
+ * state as the run it was saved from, whether it is loaded into the same 
+ * machine or a new one.
+ */
+TEST_F(SaveStateTest, ResumeTest)
+{
+    machine->runUntil(100000);
+    std::vector<uint8_t> start = saveTestState(machine);
+    while (machine->runUntil(500000))
+    {
+    }
+    std::vector<uint8_t> end = saveTestState(machine);
+    ASSERT_NE(start, end);
+
+    StateReader reader(&start[0], start.size());
+    ASSERT_TRUE(machine->loadState(&reader));
+    ASSERT_EQ(start, saveTestState(machine));
+    while (machine->runUntil(500000))
+    {
+    }
+    ASSERT_EQ(end, saveTestState(machine));
+
+    GBMachine* other = createTestMachine();
+    StateReader otherReader(&start[0], start.size());
+    ASSERT_TRUE(other->loadState(&otherReader));
+    while (other->runUntil(500000))
+    {
+    }
+    ASSERT_EQ(end, saveTestState(other));
+    delete other;
+}
+
+/**
+ * States from a different version, or that are not states at all, should be
+ * refused.
+ */
+TEST_F(SaveStateTest, VersionTest)
+{
+    std::vector<uint8_t> state = saveTestState(machine);
+    state[4]++;
+    StateReader reader(&state[0], state.size());
+    ASSERT_FALSE(reader.isValid());
+    ASSERT_FALSE(machine->loadState(&reader));
+
+    uint8_t junk[16] = { 0 };
+    StateReader junkReader(junk, sizeof(junk));
+    ASSERT_FALSE(machine->loadState(&junkReader));
+}
+
+/**
+ * A chunk that is cut short should fail to load rather than read past it.
+ */
+TEST_F(SaveStateTest, TruncatedTest)
+{
+    std::vector<uint8_t> state = saveTestState(machine);
+    state.resize(state.size() / 2);
+    StateReader reader(&state[0], state.size());
+    ASSERT_FALSE(machine->loadState(&reader));
+    ASSERT_FALSE(reader.getErrorMessage().empty());
+}
+
+/**
+ * External RAM should only save the bank the CPU can address, however big
+ * the ROM is.
+ */
+TEST_F(SaveStateTest, ExternalRamSizeTest)
+{
+    size_t smallState = saveTestState(machine).size();
+
+    // A 1 MB ROM claiming 32 KB of RAM.
+    const size_t bigCartSize = 0x100000;
+    data_t* cart = new data_t[bigCartSize];
+    memset(cart, 0, bigCartSize);
+    cart[0x148] = 0x05;
+    cart[0x149] = 0x03;
+    GBMachine big(new Memory(cart, bigCartSize));
+    big.getLcd()->init(NULL);
+
+    std::vector<uint8_t> state = saveTestState(&big);
+    ASSERT_EQ(smallState + 0x2000, state.size());
+
+    big.getMemory()->write(0xBFFF, 0x5A);
+    state = saveTestState(&big);
+    big.getMemory()->write(0xBFFF, 0);
+    StateReader reader(&state[0], state.size());
+    ASSERT_TRUE(big.loadState(&reader));
+    ASSERT_EQ(0x5A, big.getMemory()->read(0xBFFF));
+}
@@ -0,0 +1,45 @@
+#ifndef _TEST_MACHINE_H_
+#define _TEST_MACHINE_H_
+
+#include <vector>
+
+#include "../../../src/Machine/GBMachine.h"
+#include "../testCartridge.h"
+
+/**
+ * A program that switches the LCD on, then keeps writing a counter 
+ * everywhere in memory.
+ */
+static const data_t testProgram[] = 
+{
+    0x3E, 0x91,         // LD A, 0x91
+    0xE0, 0x40,         // LDH (0x40), A
+    0x21, 0x00, 0x80,   // LD HL, 0x8000
+    0x3C,               // loop: INC A
+    0x22,               // LD (HL+), A
+    0xEA, 0x00, 0xC0,   // LD (0xC000), A
+    0x18, 0xF9          // JR loop
+};
+
+/**
+ * Creates a machine running the test program. The boot ROM has to be 
+ * turned off first, see NoBootRom.
+ */
+inline GBMachine* createTestMachine()
+{
+    GBMachine* gb = new GBMachine(createTestMemory(testProgram, sizeof(testProgram)));
+    gb->getLcd()->init(NULL);
+    return gb;
+}
+
+/**
+ * Saves the state of a machine into a byte array.
+ */
+inline std::vector<uint8_t> saveTestState(GBMachine* gb)
+{
+    StateWriter state;
+    gb->saveState(&state);
+    return std::vector<uint8_t>(state.getData(), state.getData() + state.getSize());
+}
+
+#endif
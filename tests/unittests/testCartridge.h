@@ -0,0 +1,48 @@
+#ifndef _TEST_CARTRIDGE_H_
+#define _TEST_CARTRIDGE_H_
+
+#include <string.h>
+
+#include "../../src/Common/Config.h"
+#include "../../src/Memory/Memory.h"
+
+#define TEST_CART_SIZE 0x8000
+
+/**
+ * Creates the memory of a blank 32KB cartridge without a memory bank
+ * controller, with a program at 0x0100, where the CPU starts without the
+ * boot ROM.
+ *
+ * @param program The program, or NULL for a blank cartridge.
+ * @param size Size of the program in bytes.
+ */
+inline Memory* createTestMemory(const data_t* program = NULL, size_t size = 0)
+{
+    data_t* cart = new data_t[TEST_CART_SIZE];
+    memset(cart, 0, TEST_CART_SIZE);
+    if (program != NULL)
+    {
+        memcpy(cart + 0x100, program, size);
+    }
+    return new Memory(cart, TEST_CART_SIZE);
+}
+
+/**
+ * Turns the boot ROM off for as long as it exists, since the test
+ * cartridges have no logo for it to check. The memory and CPUs it is off
+ * for start at 0x0100 straight away.
+ *
+ * Make it the first member of a fixture, so it covers everything created in
+ * SetUp() and deleted in TearDown().
+ */
+class NoBootRom
+{
+public:
+    NoBootRom() : wasEnabled(Config::DmgEnabled) { Config::DmgEnabled = false; }
+    ~NoBootRom() { Config::DmgEnabled = wasEnabled; }
+
+private:
+    bool wasEnabled;
+};
+
+#endif